@@ -1,6 +1,7 @@
 #include "cycles_engine.h"
 
 #include <stdio.h>
+#include <algorithm>
 #include <memory>
 
 #include "device/device.h"
@@ -21,6 +22,9 @@
 using namespace ccl;
 using namespace cycles_wrapper;
 
+// Render regions closer to each other than this number of pixels are rendered together
+#define RENDER_REGION_MERGE_DISTANCE 32
+
 CyclesEngine::CyclesEngine()
 {
   mCameraTransform = std::make_unique<ccl::Transform>();
@@ -44,6 +48,7 @@ CyclesEngine::CyclesEngine()
 
   mViewportWidth = mOptions.width;
   mViewportHeight = mOptions.height;
+  mCurrentRenderCrop = 0;
 
   // No need for any kind of crazy shading for now. If, however, OSL
   // is used then there needs to be a 'shader' folder next to the executable
@@ -95,9 +100,172 @@ BufferParams CyclesEngine::GetBufferParams()
   buffer_params.height = mOptions.height;
   buffer_params.full_width = mOptions.width;
   buffer_params.full_height = mOptions.height;
+
+  // Render only the current render crop, keeping the camera of the full frame
+  std::vector<RenderRegion> crops = GetRenderCrops();
+  if (mCurrentRenderCrop < (int)crops.size()) {
+    const RenderRegion &crop = crops[mCurrentRenderCrop];
+    buffer_params.full_x = crop.x;
+    buffer_params.full_y = crop.y;
+    buffer_params.width = crop.width;
+    buffer_params.height = crop.height;
+    buffer_params.window_x = 0;
+    buffer_params.window_y = 0;
+    buffer_params.window_width = crop.width;
+    buffer_params.window_height = crop.height;
+  }
+
   return buffer_params;
 }
 
+void CyclesEngine::SetRenderRegions(const RenderRegion *regions, uint count)
+{
+  // The output driver might still be writing the previous result using the current regions.
+  if (mOptions.session) {
+    mOptions.session->wait_denoise_pipeline();
+  }
+  mRenderRegions.assign(regions, regions + count);
+  mCurrentRenderCrop = 0;
+}
+
+void CyclesEngine::ClearRenderRegions()
+{
+  // The output driver might still be writing the previous result using the current regions.
+  if (mOptions.session) {
+    mOptions.session->wait_denoise_pipeline();
+  }
+  mRenderRegions.clear();
+  mCurrentRenderCrop = 0;
+}
+
+bool CyclesEngine::HasRenderRegions() const
+{
+  return !GetRenderCrops().empty();
+}
+
+bool CyclesEngine::IsOutputFlippedHorizontally() const
+{
+  // Coordinate system-based correction is not needed for panoramic for some reason
+  return mOptions.session->scene->camera->get_camera_type() != CAMERA_PANORAMA;
+}
+
+bool CyclesEngine::GetBufferRegion(const RenderRegion &region, RenderRegion &bufferRegion) const
+{
+  // Regions are clipped to the frame, regions outside of it are ignored
+  const int x0 = std::max(region.x, 0);
+  const int y0 = std::max(region.y, 0);
+  const int x1 = std::min(region.x + region.width, mOptions.width);
+  const int y1 = std::min(region.y + region.height, mOptions.height);
+  if (x0 >= x1 || y0 >= y1) {
+    return false;
+  }
+
+  // The output image is stored top-down and optionally mirrored, the render buffers bottom-up
+  bufferRegion.x = IsOutputFlippedHorizontally() ? mOptions.width - x1 : x0;
+  bufferRegion.y = mOptions.height - y1;
+  bufferRegion.width = x1 - x0;
+  bufferRegion.height = y1 - y0;
+  return true;
+}
+
+std::vector<RenderRegion> CyclesEngine::GetRenderCrops() const
+{
+  std::vector<RenderRegion> crops;
+  for (const RenderRegion &region : mRenderRegions) {
+    RenderRegion bufferRegion;
+    if (GetBufferRegion(region, bufferRegion)) {
+      crops.push_back(bufferRegion);
+    }
+  }
+
+  // Merge crops which overlap or are close to each other into their bounding box, since rendering
+  // the pixels between them costs less than rendering them separately. Repeat until no crops can
+  // be merged, as a merged crop might now be close to another one.
+  auto isClose = [](const RenderRegion &a, const RenderRegion &b) {
+    const int distance = RENDER_REGION_MERGE_DISTANCE;
+    return a.x < b.x + b.width + distance && b.x < a.x + a.width + distance &&
+           a.y < b.y + b.height + distance && b.y < a.y + a.height + distance;
+  };
+
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < crops.size() && !merged; i++) {
+      for (size_t j = i + 1; j < crops.size(); j++) {
+        if (!isClose(crops[i], crops[j])) {
+          continue;
+        }
+
+        RenderRegion &a = crops[i];
+        const RenderRegion &b = crops[j];
+        const int x1 = std::max(a.x + a.width, b.x + b.width);
+        const int y1 = std::max(a.y + a.height, b.y + b.height);
+        a.x = std::min(a.x, b.x);
+        a.y = std::min(a.y, b.y);
+        a.width = x1 - a.x;
+        a.height = y1 - a.y;
+        crops.erase(crops.begin() + j);
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  return crops;
+}
+
+void CyclesEngine::CompositeRenderRegions(const float *cropPixels,
+                                          int numChannels,
+                                          float *framePixels) const
+{
+  // The crop pixels cover the current render crop and are stored bottom-up, as read from the
+  // render buffers. The frame pixels cover the full output image.
+  std::vector<RenderRegion> crops = GetRenderCrops();
+  if (mCurrentRenderCrop >= (int)crops.size()) {
+    return;
+  }
+
+  const RenderRegion &crop = crops[mCurrentRenderCrop];
+  const int frameWidth = mOptions.width;
+  const int frameHeight = mOptions.height;
+  const bool flipX = IsOutputFlippedHorizontally();
+  const size_t pixelSize = sizeof(float) * numChannels;
+
+  for (const RenderRegion &region : mRenderRegions) {
+    RenderRegion bufferRegion;
+    if (!GetBufferRegion(region, bufferRegion)) {
+      continue;
+    }
+
+    // Only the part of the region inside of the current crop
+    const int x0 = std::max(bufferRegion.x, crop.x);
+    const int y0 = std::max(bufferRegion.y, crop.y);
+    const int x1 = std::min(bufferRegion.x + bufferRegion.width, crop.x + crop.width);
+    const int y1 = std::min(bufferRegion.y + bufferRegion.height, crop.y + crop.height);
+    if (x0 >= x1 || y0 >= y1) {
+      continue;
+    }
+
+    for (int y = y0; y < y1; y++) {
+      const int frameY = frameHeight - 1 - y;
+      const float *src = cropPixels +
+                         ((size_t)(y - crop.y) * crop.width + (x0 - crop.x)) * numChannels;
+
+      if (!flipX) {
+        float *dst = framePixels + ((size_t)frameY * frameWidth + x0) * numChannels;
+        memcpy(dst, src, pixelSize * (x1 - x0));
+        continue;
+      }
+
+      for (int x = x0; x < x1; x++, src += numChannels) {
+        const int frameX = frameWidth - 1 - x;
+        float *dst = framePixels + ((size_t)frameY * frameWidth + frameX) * numChannels;
+        memcpy(dst, src, pixelSize);
+      }
+    }
+  }
+}
+
 void CyclesEngine::ResetSession()
 {
   mOptions.session->reset(*mOptions.session_params, GetBufferParams());
@@ -95,6 +95,12 @@ struct DenoisingOptions{
   bool mEnable;
   bool mPrefilter;
 };
+// Rectangle of the frame to render, in pixels of the output image. The origin is the top-left
+// corner of the image as it is written, after any flipping of the render result.
+struct RenderRegion {
+  int x, y;
+  int width, height;
+};
 
 class CyclesEngine {
 
@@ -122,6 +128,13 @@ class CyclesEngine {
       float p[], float d[], float u[], float *n, float *f, float *fov, float *aspect);
   DLL_API void SetDenoising(const DenoisingOptions&);
 
+  // Render only the given regions of the frame instead of the full frame. Regions which overlap
+  // or are close to each other are rendered together as their bounding box, other regions are
+  // rendered one after the other. Only the pixels inside the regions are composited into the
+  // existing output image. Passing no regions renders the full frame.
+  DLL_API void SetRenderRegions(const RenderRegion *regions, uint count);
+  DLL_API void ClearRenderRegions();
+
   // Scene graph manipulation
   DLL_API Scene *GetScene();
   DLL_API void CleanScene(Scene *scene);
@@ -205,6 +218,11 @@ class CyclesEngine {
  protected:
   void Log(int type, const std::string &msg);
   ccl::BufferParams GetBufferParams();
+  bool HasRenderRegions() const;
+  bool IsOutputFlippedHorizontally() const;
+  bool GetBufferRegion(const RenderRegion &region, RenderRegion &bufferRegion) const;
+  std::vector<RenderRegion> GetRenderCrops() const;
+  void CompositeRenderRegions(const float *cropPixels, int numChannels, float *framePixels) const;
   virtual void DefaultSceneInit();
   virtual void ResetSession();
   virtual void CancelSession();
@@ -216,6 +234,9 @@ class CyclesEngine {
   int mCurrentSample;
   float mMaxDepth;
   std::vector<std::unique_ptr<ccl::ImageHandle>> mImageHandles;
+  std::vector<RenderRegion> mRenderRegions;
+  // Index of the render crop which is being rendered, see GetRenderCrops()
+  int mCurrentRenderCrop;
 
   // Camera cache
   std::unique_ptr<ccl::Transform> mCameraTransform;
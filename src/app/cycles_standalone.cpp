@@ -7,7 +7,9 @@
 #include "scene/camera.h"
 #include "scene/integrator.h"
 #include "scene/scene.h"
+#include "scene/stats.h"
 #include "session/buffers.h"
+#include "session/merge.h"
 #include "session/session.h"
 
 #include "util/args.h"
@@ -48,6 +50,11 @@ struct Options {
   bool show_help, interactive, pause;
   string output_filepath;
   string output_pass;
+  /* Render a subset of the samples, for merging with the other subsets afterwards. */
+  int split_index, split_count;
+  /* Merge previously rendered images into a single image, instead of rendering. */
+  vector<string> input_filepaths;
+  string merge_filepath;
 } options;
 
 static void session_print(const string &str)
@@ -136,8 +143,10 @@ static void session_init()
 #endif
 
   if (!options.output_filepath.empty()) {
+    /* Store the number of samples for weighting when merging split renders. */
+    const int num_samples = (options.split_count > 1) ? options.session_params.samples : 0;
     options.session->set_output_driver(make_unique<OIIOOutputDriver>(
-        options.output_filepath, options.output_pass, session_print));
+        options.output_filepath, options.output_pass, session_print, num_samples));
   }
 
   if (options.session_params.background && !options.quiet)
@@ -162,6 +171,12 @@ static void session_init()
 static void session_exit()
 {
   if (options.session) {
+    if (options.session_params.use_profiling) {
+      RenderStats stats;
+      options.session->collect_statistics(&stats);
+      printf("\n%s\n", stats.full_report().c_str());
+    }
+
     delete options.session;
     options.session = NULL;
   }
@@ -346,12 +361,41 @@ static void keyboard(unsigned char key)
 
 static int files_parse(int argc, const char *argv[])
 {
-  if (argc > 0)
+  if (argc > 0 && options.filepath.empty())
     options.filepath = argv[0];
 
+  for (int i = 0; i < argc; i++)
+    options.input_filepaths.push_back(argv[i]);
+
   return 0;
 }
 
+static void split_samples()
+{
+  /* Distribute samples evenly over the splits, with the remainder going to the first ones. */
+  const int total_samples = options.session_params.samples;
+  const int base_samples = total_samples / options.split_count;
+  const int remainder = total_samples % options.split_count;
+
+  options.session_params.sample_offset += options.split_index * base_samples +
+                                          min(options.split_index, remainder);
+  options.session_params.samples = base_samples + (options.split_index < remainder ? 1 : 0);
+}
+
+static int merge_images()
+{
+  ImageMerger merger;
+  merger.input = options.input_filepaths;
+  merger.output = options.merge_filepath;
+
+  if (!merger.run()) {
+    fprintf(stderr, "%s\n", merger.error.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
 static void options_parse(int argc, const char **argv)
 {
   options.width = 1024;
@@ -361,6 +405,8 @@ static void options_parse(int argc, const char **argv)
   options.quiet = false;
   options.session_params.use_auto_tile = false;
   options.session_params.tile_size = 0;
+  options.split_index = 0;
+  options.split_count = 1;
 
   /* device names */
   string device_names = "";
@@ -379,12 +425,22 @@ static void options_parse(int argc, const char **argv)
   /* shading system */
   string ssname = "svm";
 
+  /* temporary tile file format */
+  string tile_format = "exr";
+
+  /* render checkpoint interval in seconds */
+  float checkpoint_interval = options.session_params.checkpoint_interval;
+
+  /* render time limit in seconds */
+  float time_limit = options.session_params.time_limit;
+
   /* parse options */
   ArgParse ap;
   bool help = false, profile = false, debug = false, version = false;
   int verbosity = 1;
 
-  ap.options("Usage: cycles [options] file.xml",
+  ap.options("Usage: cycles [options] file.xml\n"
+             "       cycles --merge output.exr [options] input1.exr input2.exr ...",
              "%*",
              files_parse,
              "",
@@ -405,12 +461,36 @@ static void options_parse(int argc, const char **argv)
              "--samples %d",
              &options.session_params.samples,
              "Number of samples to render",
+             "--sample-offset %d",
+             &options.session_params.sample_offset,
+             "Number of samples to skip, to render a subset of a larger render",
+             "--split-count %d",
+             &options.split_count,
+             "Split the samples into this many parts, to render in separate processes",
+             "--split-index %d",
+             &options.split_index,
+             "Index of the part of the split samples to render",
+             "--time-limit %f",
+             &time_limit,
+             "Time limit in seconds for rendering, zero for no limit",
+             "--noise-target %f",
+             &options.session_params.noise_target,
+             "Stop rendering when the noise level is below this adaptive sampling threshold",
+             "--merge %s",
+             &options.merge_filepath,
+             "Merge the input images rendered with split samples into this file",
              "--output %s",
              &options.output_filepath,
              "File path to write output image",
              "--threads %d",
              &options.session_params.threads,
              "CPU Rendering Threads",
+             "--denoise-pipeline",
+             &options.session_params.use_denoise_pipeline,
+             "Denoise and write the result in the background while rendering continues",
+             "--denoise-threads %d",
+             &options.session_params.denoise_threads,
+             "Number of threads used for pipelined denoising, zero for all available threads",
              "--width  %d",
              &options.width,
              "Window width in pixel",
@@ -420,12 +500,30 @@ static void options_parse(int argc, const char **argv)
              "--tile-size %d",
              &options.session_params.tile_size,
              "Tile size in pixels",
+             "--tile-compression %s",
+             &options.session_params.temp_compression,
+             "Compression of the temporary tile file: none, rle, zips, zip, piz",
+             "--tile-format %s",
+             &tile_format,
+             "Format of the temporary tile file: exr, raw",
+             "--checkpoint %s",
+             &options.session_params.checkpoint_filepath,
+             "File path to periodically store render progress in",
+             "--checkpoint-interval %f",
+             &checkpoint_interval,
+             "Interval in seconds between render checkpoints",
+             "--resume",
+             &options.session_params.checkpoint_resume,
+             "Resume render from the checkpoint file",
+             "--bvh-quantized-nodes",
+             &options.scene_params.use_bvh_quantized_nodes,
+             "Quantize BVH2 node bounds to reduce memory usage",
              "--list-devices",
              &list,
              "List information about all available devices",
              "--profile",
              &profile,
-             "Enable profile logging",
+             "Enable profile logging and print render and BVH statistics",
 #ifdef WITH_CYCLES_LOGGING
              "--debug",
              &debug,
@@ -474,6 +572,10 @@ static void options_parse(int argc, const char **argv)
     ap.usage();
     exit(EXIT_SUCCESS);
   }
+  else if (!options.merge_filepath.empty()) {
+    /* Merging does not need a device or scene. */
+    return;
+  }
 
   options.session_params.use_profiling = profile;
 
@@ -490,6 +592,20 @@ static void options_parse(int argc, const char **argv)
     options.session_params.use_auto_tile = true;
   }
 
+  options.session_params.checkpoint_interval = checkpoint_interval;
+  options.session_params.time_limit = time_limit;
+
+  if (tile_format == "raw") {
+    options.session_params.temp_format = TILE_FILE_FORMAT_RAW;
+  }
+  else if (tile_format == "exr") {
+    options.session_params.temp_format = TILE_FILE_FORMAT_EXR;
+  }
+  else {
+    fprintf(stderr, "Unknown tile file format: %s\n", tile_format.c_str());
+    exit(EXIT_FAILURE);
+  }
+
   /* find matching device */
   DeviceType device_type = Device::type_from_string(devicename.c_str());
   vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK(device_type));
@@ -520,10 +636,31 @@ static void options_parse(int argc, const char **argv)
     fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
     exit(EXIT_FAILURE);
   }
+  else if (options.session_params.sample_offset < 0) {
+    fprintf(stderr, "Invalid sample offset: %d\n", options.session_params.sample_offset);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.split_count < 1 || options.split_index < 0 ||
+           options.split_index >= options.split_count) {
+    fprintf(stderr,
+            "Invalid split index %d for split count %d\n",
+            options.split_index,
+            options.split_count);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.split_count > 1 &&
+           !string_endswith(string_to_lower(options.output_filepath), ".exr")) {
+    fprintf(stderr, "Split renders require an EXR output file for merging\n");
+    exit(EXIT_FAILURE);
+  }
   else if (options.filepath == "") {
     fprintf(stderr, "No file path specified\n");
     exit(EXIT_FAILURE);
   }
+
+  if (options.split_count > 1) {
+    split_samples();
+  }
 }
 
 CCL_NAMESPACE_END
@@ -536,6 +673,10 @@ int main(int argc, const char **argv)
   path_init();
   options_parse(argc, argv);
 
+  if (!options.merge_filepath.empty()) {
+    return merge_images();
+  }
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
   if (options.session_params.background) {
 #endif
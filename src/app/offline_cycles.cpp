@@ -1,6 +1,7 @@
 #include "offline_cycles.h"
 
 #include <stdio.h>
+#include <algorithm>
 
 #include "device/device.h"
 #include "scene/camera.h"
@@ -132,6 +133,11 @@ class OfflineCycles_OIIOOutputDriver : public OIIOOutputDriver {
       return;
     }
 
+    if (Engine && Engine->HasRenderRegions()) {
+      write_render_regions(tile);
+      return;
+    }
+
     log_(string_printf("OFFLINE_CYCLES_STATUS: Writing image %s", filepath_.c_str()));
     const int width = tile.size.x;
     const int height = tile.size.y;
@@ -284,6 +290,91 @@ class OfflineCycles_OIIOOutputDriver : public OIIOOutputDriver {
     }
   }
 
+  // Composite the pixels of the render regions into the existing frame, keeping all other pixels.
+  void write_render_regions(const Tile &tile)
+  {
+    log_(string_printf("OFFLINE_CYCLES_STATUS: Writing render regions to %s", filepath_.c_str()));
+    const int width = tile.size.x;
+    const int height = tile.size.y;
+    const int pixelCount = width * height;
+    const int frameWidth = Engine->mOptions.width;
+    const int frameHeight = Engine->mOptions.height;
+    const int channels = (IsSingleChannelFloat) ? 1 : 4;
+
+    vector<float> pixels(pixelCount * 4);
+    if (!tile.get_pass_pixels(pass_, 4, pixels.data())) {
+      log_("OFFLINE_CYCLES_STATUS: Failed to read render pass pixels");
+      return;
+    }
+    if (IsSingleChannelFloat) {
+      for (size_t i = 0; i < pixelCount; i++) {
+        pixels[i] = pixels[i * 4 + 0];  // red channel
+      }
+      pixels.resize(pixelCount);
+    }
+
+    auto applyGamma = [&]() {
+      const float g = 1.0f / 2.2f;
+      for (size_t i = 0; i < pixelCount; i++) {
+        for (size_t k = 0; k < 3; k++) {
+          pixels[i * 4 + k] = std::pow(pixels[i * 4 + k], g);
+        }
+      }
+    };
+
+    if (UseSharedMemory) {
+      // The shared memory holds the existing frame of the client
+      unique_ptr<SharedMemoryImageOutput> shared_memory_image_output =
+          SharedMemoryImageOutput::create(filepath_);
+      if (shared_memory_image_output == nullptr) {
+        log_("OFFLINE_CYCLES_STATUS: Failed to open shared memory");
+        return;
+      }
+      if (ForceSrgbColorConversion && !IsSingleChannelFloat) {
+        applyGamma();
+      }
+      Engine->CompositeRenderRegions(
+          pixels.data(), channels, shared_memory_image_output->GetPixels());
+      return;
+    }
+
+    unique_ptr<ImageOutput> image_output = ImageOutput::create(filepath_);
+    if (image_output == nullptr) {
+      log_("OFFLINE_CYCLES_STATUS: Failed to create image file");
+      return;
+    }
+    if (!IsSingleChannelFloat &&
+        (ForceSrgbColorConversion ||
+         ColorSpaceManager::detect_known_colorspace(
+             u_colorspace_auto, "", image_output->format_name(), true) == u_colorspace_srgb)) {
+      applyGamma();
+    }
+
+    // Start from the previously written frame if it matches, so pixels outside of the regions
+    // are kept
+    ImageSpec spec(frameWidth, frameHeight, channels, TypeDesc::FLOAT);
+    vector<float> framePixels((size_t)frameWidth * frameHeight * channels, 0.0f);
+    unique_ptr<ImageInput> image_input = ImageInput::open(filepath_);
+    if (image_input) {
+      const ImageSpec &inputSpec = image_input->spec();
+      if (inputSpec.width == frameWidth && inputSpec.height == frameHeight &&
+          inputSpec.nchannels == channels) {
+        image_input->read_image(0, 0, 0, channels, TypeDesc::FLOAT, framePixels.data());
+      }
+      image_input->close();
+      image_input.reset();
+    }
+
+    Engine->CompositeRenderRegions(pixels.data(), channels, framePixels.data());
+
+    if (!image_output->open(filepath_, spec)) {
+      log_("OFFLINE_CYCLES_STATUS: Failed to create image file");
+      return;
+    }
+    image_output->write_image(TypeDesc::FLOAT, framePixels.data());
+    image_output->close();
+  }
+
   void UpdateFilePath(const ccl::string_view filepath, bool useSharedMemory)
   {
     filepath_ = filepath;
@@ -291,6 +382,7 @@ class OfflineCycles_OIIOOutputDriver : public OIIOOutputDriver {
   }
 
  public:
+  OfflineCycles *Engine = nullptr;
   bool FlipHorizontally;
   bool IsSingleChannelFloat;
   bool UseSharedMemory;
@@ -409,6 +501,7 @@ bool OfflineCycles::SessionInit()
           this->Log(LOG_TYPE_INFO, str);
         });
     mOutputDriver = (OfflineCycles_OIIOOutputDriver *)driver.get();
+    mOutputDriver->Engine = this;
     mOptions.session->set_output_driver(std::move(driver));
   }
 
@@ -459,6 +552,7 @@ void OfflineCycles::SetSamples(uint samples)
 
 void OfflineCycles::SetIsSingleChannelFloat(bool value)
 {
+  mOptions.session->wait_denoise_pipeline();
   mOutputDriver->IsSingleChannelFloat = value;
 }
 
@@ -489,17 +583,31 @@ void OfflineCycles::ResetSession()
 
 bool OfflineCycles::RenderScene(const char *fileNameDest, bool useSharedMemory)
 {
-  // Coordinate system-based correction is not needed for panoramic for some reason
-  mOutputDriver->FlipHorizontally = mOptions.session->scene->camera->get_camera_type() !=
-                                    CameraType::Panoramic;
+  // The result of the previous frame might still be denoised and written in the background.
+  mOptions.session->wait_denoise_pipeline();
+
+  mOutputDriver->FlipHorizontally = IsOutputFlippedHorizontally();
 
   mOutputDriver->UpdateFilePath(fileNameDest, useSharedMemory);
-  ResetSession();
-  mOptions.session->start();
 
-  // ...
+  // Render regions which are far apart are rendered one after the other
+  const int numCrops = std::max((int)GetRenderCrops().size(), 1);
+  for (int crop = 0; crop < numCrops; crop++) {
+    // The output driver might still be writing the previous crop.
+    mOptions.session->wait_denoise_pipeline();
+    mCurrentRenderCrop = crop;
 
-  mOptions.session->wait();
+    ResetSession();
+    mOptions.session->start();
+
+    // ...
+
+    mOptions.session->wait();
+
+    if (mOptions.session->progress.get_cancel()) {
+      break;
+    }
+  }
 
   // Check for error messages
   bool isOk = !mOptions.session->device->have_error();
@@ -7,6 +7,8 @@ namespace cycles_wrapper {
 
 class OfflineCycles : public CyclesEngine {
 
+  friend class OfflineCycles_OIIOOutputDriver;
+
  public:
   DLL_API OfflineCycles();
   DLL_API virtual ~OfflineCycles();
@@ -12,8 +12,9 @@ CCL_NAMESPACE_BEGIN
 
 OIIOOutputDriver::OIIOOutputDriver(const string_view filepath,
                                    const string_view pass,
-                                   LogFunction log)
-    : filepath_(filepath), pass_(pass), log_(log)
+                                   LogFunction log,
+                                   const int num_samples)
+    : filepath_(filepath), pass_(pass), log_(log), num_samples_(num_samples)
 {
 }
 
@@ -40,6 +41,9 @@ void OIIOOutputDriver::write_render_tile(const Tile &tile)
   const int height = tile.size.y;
 
   ImageSpec spec(width, height, 4, TypeDesc::FLOAT);
+  if (num_samples_ > 0) {
+    spec.attribute("cycles.View Layer.samples", TypeDesc::STRING, to_string(num_samples_));
+  }
   if (!image_output->open(filepath_, spec)) {
     log_("Failed to create image file");
     return;
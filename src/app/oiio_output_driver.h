@@ -15,7 +15,12 @@ class OIIOOutputDriver : public OutputDriver {
  public:
   typedef function<void(const string &)> LogFunction;
 
-  OIIOOutputDriver(const string_view filepath, const string_view pass, LogFunction log);
+  /* When num_samples is non-zero it is stored in the image metadata, so that images rendered
+   * with different sample ranges can be merged with ImageMerger. */
+  OIIOOutputDriver(const string_view filepath,
+                   const string_view pass,
+                   LogFunction log,
+                   const int num_samples = 0);
   virtual ~OIIOOutputDriver();
 
   void write_render_tile(const Tile &tile) override;
@@ -24,6 +29,7 @@ class OIIOOutputDriver : public OutputDriver {
   string filepath_;
   string pass_;
   LogFunction log_;
+  int num_samples_;
 };
 
 CCL_NAMESPACE_END
@@ -5,6 +5,7 @@
 #include "bvh/build.h"
 
 #include "bvh/binning.h"
+#include "bvh/bvh.h"
 #include "bvh/node.h"
 #include "bvh/params.h"
 #include "bvh/split.h"
@@ -44,8 +45,10 @@ BVHBuild::BVHBuild(const vector<Object *> &objects_,
       params(params_),
       progress(progress_),
       progress_start_time(0.0),
+      build_time(0.0),
       unaligned_heuristic(objects_)
 {
+  num_original_references = 0;
   spatial_min_overlap = 0.0f;
 }
 
@@ -494,6 +497,7 @@ BVHNode *BVHBuild::run()
   progress_count = 0;
   progress_total = references.size();
   progress_original_total = progress_total;
+  num_original_references = references.size();
 
   prim_type.resize(references.size());
   prim_index.resize(references.size());
@@ -524,6 +528,8 @@ BVHNode *BVHBuild::run()
   /* clean up temporary memory usage by threads */
   spatial_storage.clear();
 
+  build_time = time_dt() - build_start_time;
+
   /* delete if we canceled */
   if (rootnode) {
     if (progress.get_cancel()) {
@@ -538,7 +544,7 @@ BVHNode *BVHBuild::run()
     }
     if (rootnode != NULL) {
       VLOG_WORK << "BVH build statistics:\n"
-                << "  Build time: " << time_dt() - build_start_time << "\n"
+                << "  Build time: " << build_time << "\n"
                 << "  Total number of nodes: "
                 << string_human_readable_number(rootnode->getSubtreeSize(BVH_STAT_NODE_COUNT))
                 << "\n"
@@ -563,6 +569,53 @@ BVHNode *BVHBuild::run()
   return rootnode;
 }
 
+/* Statistics */
+
+static void bvh_statistics_recursive(const BVHNode *node, int depth, BVHStats &stats)
+{
+  stats.num_nodes++;
+  if (node->is_unaligned) {
+    stats.num_unaligned_nodes++;
+  }
+  stats.max_depth = max(stats.max_depth, depth + 1);
+
+  if (node->is_leaf()) {
+    const size_t num_prims = node->num_triangles();
+    if (stats.leaf_size_histogram.size() <= num_prims) {
+      stats.leaf_size_histogram.resize(num_prims + 1, 0);
+    }
+    if (stats.depth_histogram.size() <= (size_t)depth) {
+      stats.depth_histogram.resize(depth + 1, 0);
+    }
+    stats.leaf_size_histogram[num_prims]++;
+    stats.depth_histogram[depth]++;
+    stats.num_leaf_nodes++;
+    return;
+  }
+
+  stats.num_inner_nodes++;
+  for (int i = 0; i < node->num_children(); i++) {
+    bvh_statistics_recursive(node->get_child(i), depth + 1, stats);
+  }
+}
+
+void BVHBuild::collect_statistics(const BVHNode *root, BVHStats &stats) const
+{
+  stats.reset();
+  stats.builder = "BVH2";
+  stats.build_time = build_time;
+  stats.num_original_references = num_original_references;
+  stats.num_references = prim_index.size();
+
+  if (root == NULL) {
+    return;
+  }
+
+  stats.bounds = root->bounds;
+  stats.sah_cost = root->computeSubtreeSAHCost(params);
+  bvh_statistics_recursive(root, 0, stats);
+}
+
 void BVHBuild::progress_update()
 {
   if (time_dt() - progress_start_time < 0.25)
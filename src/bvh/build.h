@@ -21,6 +21,7 @@ class BVHBuildTask;
 class BVHNode;
 class BVHSpatialSplitBuildTask;
 class BVHParams;
+struct BVHStats;
 class InnerNode;
 class Geometry;
 class Hair;
@@ -45,6 +46,9 @@ class BVHBuild {
 
   BVHNode *run();
 
+  /* Gather tree quality statistics of the tree returned by run(). */
+  void collect_statistics(const BVHNode *root, BVHStats &stats) const;
+
  protected:
   friend class BVHMixedSplit;
   friend class BVHObjectSplit;
@@ -109,6 +113,7 @@ class BVHBuild {
   /* Progress reporting. */
   Progress &progress;
   double progress_start_time;
+  double build_time;
   size_t progress_count;
   size_t progress_total;
   size_t progress_original_total;
@@ -58,6 +58,88 @@ struct PackedBVH {
   }
 };
 
+/* BVH Statistics
+ *
+ * Quality and memory statistics of a built BVH, used to tune build parameters.
+ * Fields which are not known for a specific BVH implementation are left zero. */
+
+struct BVHStats {
+  /* Name of the builder which produced the tree. */
+  const char *builder;
+  double build_time;
+
+  /* Surface area heuristic cost of the whole tree. */
+  float sah_cost;
+  BoundBox bounds;
+
+  size_t num_nodes;
+  size_t num_inner_nodes;
+  size_t num_leaf_nodes;
+  size_t num_unaligned_nodes;
+  int max_depth;
+
+  /* Number of primitive references before and after the build. The difference
+   * is caused by references duplicated by spatial splits. */
+  size_t num_original_references;
+  size_t num_references;
+
+  /* Number of leaves indexed by the number of primitives they contain, and
+   * number of leaves indexed by their depth in the tree. */
+  vector<size_t> leaf_size_histogram;
+  vector<size_t> depth_histogram;
+
+  /* Memory used by the packed tree, per node type. */
+  size_t aligned_node_memory;
+  size_t unaligned_node_memory;
+  size_t leaf_node_memory;
+  size_t primitive_memory;
+
+  BVHStats()
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    builder = "";
+    build_time = 0.0;
+    sah_cost = 0.0f;
+    bounds = BoundBox::empty;
+    num_nodes = 0;
+    num_inner_nodes = 0;
+    num_leaf_nodes = 0;
+    num_unaligned_nodes = 0;
+    max_depth = 0;
+    num_original_references = 0;
+    num_references = 0;
+    leaf_size_histogram.clear();
+    depth_histogram.clear();
+    aligned_node_memory = 0;
+    unaligned_node_memory = 0;
+    leaf_node_memory = 0;
+    primitive_memory = 0;
+  }
+
+  size_t total_memory() const
+  {
+    return aligned_node_memory + unaligned_node_memory + leaf_node_memory + primitive_memory;
+  }
+
+  /* Fraction of references which were added by spatial splits. */
+  float duplication_ratio() const
+  {
+    if (num_references <= num_original_references) {
+      return 0.0f;
+    }
+    return (float)(num_references - num_original_references) / num_original_references;
+  }
+
+  bool is_valid() const
+  {
+    return build_time > 0.0 || num_references != 0;
+  }
+};
+
 /* BVH */
 
 class BVH {
@@ -66,6 +148,9 @@ class BVH {
   vector<Geometry *> geometry;
   vector<Object *> objects;
 
+  /* Statistics of the last build. */
+  BVHStats stats;
+
   static BVH *create(const BVHParams &params,
                      const vector<Geometry *> &geometry,
                      const vector<Object *> &objects,
@@ -55,6 +55,8 @@ void BVH2::build(Progress &progress, Stats *)
     return;
   }
 
+  bvh_build.collect_statistics(bvh2_root, stats);
+
   /* BVH builder returns tree in a binary mode (with two children per inner
    * node. Need to adopt that for a wider BVH implementations. */
   BVHNode *root = widen_children_nodes(bvh2_root);
@@ -82,6 +84,12 @@ void BVH2::build(Progress &progress, Stats *)
   progress.set_substatus("Packing BVH nodes");
   pack_nodes(root);
 
+  stats.primitive_memory = pack.prim_type.size() * sizeof(int) +
+                           pack.prim_index.size() * sizeof(int) +
+                           pack.prim_object.size() * sizeof(int) +
+                           pack.prim_visibility.size() * sizeof(uint) +
+                           pack.prim_time.size() * sizeof(float2);
+
   /* free build nodes */
   root->deleteSubtree();
 }
@@ -140,6 +148,17 @@ void BVH2::pack_aligned_inner(const BVHStackEntry &e,
                               const BVHStackEntry &e0,
                               const BVHStackEntry &e1)
 {
+  if (params.use_quantized_nodes) {
+    pack_quantized_node(e.idx,
+                        e0.node->bounds,
+                        e1.node->bounds,
+                        e0.encodeIdx(),
+                        e1.encodeIdx(),
+                        e0.node->visibility,
+                        e1.node->visibility);
+    return;
+  }
+
   pack_aligned_node(e.idx,
                     e0.node->bounds,
                     e1.node->bounds,
@@ -181,6 +200,126 @@ void BVH2::pack_aligned_node(int idx,
   memcpy(&pack.nodes[idx], data, sizeof(int4) * BVH_NODE_SIZE);
 }
 
+/* Largest magnitude of quantized bounds, keeps the quantization scale finite. */
+#define BVH_QUANTIZED_BOUNDS_LIMIT 1e37f
+
+static float bvh_quantize_clamp(float f)
+{
+  if (!isfinite_safe(f)) {
+    return (f > 0.0f) ? BVH_QUANTIZED_BOUNDS_LIMIT : -BVH_QUANTIZED_BOUNDS_LIMIT;
+  }
+  return clamp(f, -BVH_QUANTIZED_BOUNDS_LIMIT, BVH_QUANTIZED_BOUNDS_LIMIT);
+}
+
+/* Same arithmetic as bvh_quantized_node_decode_axis() in the kernel. */
+static float bvh_quantize_decode(float origin, uint exponent, uint q)
+{
+  return origin + (float)q * __uint_as_float(exponent << 23);
+}
+
+/* Quantize the lower and upper planes of both children along one axis. The planes are stored as
+ * 8 bit offsets from the origin in units of a power of two scale, packed as (lo0, lo1, hi0, hi1)
+ * to match the layout of regular aligned nodes. Planes are rounded outwards and verified against
+ * the decoding arithmetic, so decoded bounds always contain the original bounds.
+ *
+ * Returns the biased exponent of the scale. */
+static uint bvh_quantize_axis(const float origin,
+                              const float extent,
+                              const float lo[2],
+                              const float hi[2],
+                              uint *r_planes)
+{
+  int exponent = 1;
+  if (extent > 0.0f) {
+    int e;
+    frexpf(extent / 255.0f, &e);
+    exponent = clamp(e + 127, 1, 254);
+  }
+
+  for (;; exponent++) {
+    const float scale = __uint_as_float((uint)exponent << 23);
+    uint q[4];
+    bool fits = true;
+
+    for (int i = 0; i < 2; i++) {
+      /* Lower plane, rounded down. */
+      uint q_lo = (uint)clamp(floorf((lo[i] - origin) / scale), 0.0f, 255.0f);
+      while (q_lo > 0 && bvh_quantize_decode(origin, exponent, q_lo) > lo[i]) {
+        q_lo--;
+      }
+
+      /* Upper plane, rounded up. */
+      uint q_hi = (uint)clamp(ceilf((hi[i] - origin) / scale), 0.0f, 256.0f);
+      while (q_hi <= 255 && bvh_quantize_decode(origin, exponent, q_hi) < hi[i]) {
+        q_hi++;
+      }
+
+      if (q_hi > 255) {
+        fits = false;
+      }
+
+      q[i] = q_lo;
+      q[i + 2] = min(q_hi, 255u);
+    }
+
+    if (fits || exponent >= 254) {
+      *r_planes = q[0] | (q[1] << 8) | (q[2] << 16) | (q[3] << 24);
+      return (uint)exponent;
+    }
+  }
+}
+
+void BVH2::pack_quantized_node(int idx,
+                               const BoundBox &b0,
+                               const BoundBox &b1,
+                               int c0,
+                               int c1,
+                               uint visibility0,
+                               uint visibility1)
+{
+  assert(idx + BVH_QUANTIZED_NODE_SIZE <= pack.nodes.size());
+  assert(c0 < 0 || c0 < pack.nodes.size());
+  assert(c1 < 0 || c1 < pack.nodes.size());
+
+  const float3 min0 = make_float3(bvh_quantize_clamp(b0.min.x),
+                                  bvh_quantize_clamp(b0.min.y),
+                                  bvh_quantize_clamp(b0.min.z));
+  const float3 max0 = make_float3(bvh_quantize_clamp(b0.max.x),
+                                  bvh_quantize_clamp(b0.max.y),
+                                  bvh_quantize_clamp(b0.max.z));
+  const float3 min1 = make_float3(bvh_quantize_clamp(b1.min.x),
+                                  bvh_quantize_clamp(b1.min.y),
+                                  bvh_quantize_clamp(b1.min.z));
+  const float3 max1 = make_float3(bvh_quantize_clamp(b1.max.x),
+                                  bvh_quantize_clamp(b1.max.y),
+                                  bvh_quantize_clamp(b1.max.z));
+
+  /* Bounds of this node, which the child planes are relative to. */
+  const float3 origin = min(min0, min1);
+  const float3 extent = max(max0, max1) - origin;
+
+  uint exponent[3], planes[3];
+  for (int axis = 0; axis < 3; axis++) {
+    const float lo[2] = {min0[axis], min1[axis]};
+    const float hi[2] = {max0[axis], max1[axis]};
+    exponent[axis] = bvh_quantize_axis(origin[axis], extent[axis], lo, hi, &planes[axis]);
+  }
+
+  int4 data[BVH_QUANTIZED_NODE_SIZE] = {
+      make_int4((visibility0 & ~PATH_RAY_NODE_UNALIGNED) | PATH_RAY_NODE_QUANTIZED,
+                (visibility1 & ~PATH_RAY_NODE_UNALIGNED) | PATH_RAY_NODE_QUANTIZED,
+                c0,
+                c1),
+      make_int4(__float_as_int(origin.x),
+                __float_as_int(origin.y),
+                __float_as_int(origin.z),
+                (int)(exponent[0] | (exponent[1] << 8) | (exponent[2] << 16))),
+      make_int4((int)planes[0], (int)planes[1], (int)planes[2], 0),
+  };
+
+  memcpy(&pack.nodes[idx], data, sizeof(int4) * BVH_QUANTIZED_NODE_SIZE);
+}
+
 void BVH2::pack_unaligned_inner(const BVHStackEntry &e,
                                 const BVHStackEntry &e0,
                                 const BVHStackEntry &e1)
@@ -234,15 +373,20 @@ void BVH2::pack_nodes(const BVHNode *root)
   const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
   assert(num_leaf_nodes <= num_nodes);
   const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
-  size_t node_size;
-  if (params.use_unaligned_nodes) {
-    const size_t num_unaligned_nodes = root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT);
-    node_size = (num_unaligned_nodes * BVH_UNALIGNED_NODE_SIZE) +
-                (num_inner_nodes - num_unaligned_nodes) * BVH_NODE_SIZE;
-  }
-  else {
-    node_size = num_inner_nodes * BVH_NODE_SIZE;
-  }
+  const size_t num_unaligned_nodes = (params.use_unaligned_nodes) ?
+                                         root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT) :
+                                         0;
+  const size_t aligned_node_size = (params.use_quantized_nodes) ? BVH_QUANTIZED_NODE_SIZE :
+                                                                  BVH_NODE_SIZE;
+  const size_t node_size = (num_unaligned_nodes * BVH_UNALIGNED_NODE_SIZE) +
+                           (num_inner_nodes - num_unaligned_nodes) * aligned_node_size;
+
+  /* Memory of the nodes of this BVH only, merged instance BVHs are accounted for in their own
+   * statistics. */
+  stats.aligned_node_memory = (num_inner_nodes - num_unaligned_nodes) * aligned_node_size *
+                              sizeof(int4);
+  stats.unaligned_node_memory = num_unaligned_nodes * BVH_UNALIGNED_NODE_SIZE * sizeof(int4);
+  stats.leaf_node_memory = num_leaf_nodes * BVH_NODE_LEAF_SIZE * sizeof(int4);
   /* Resize arrays */
   pack.nodes.clear();
   pack.leaf_nodes.clear();
@@ -264,7 +408,7 @@ void BVH2::pack_nodes(const BVHNode *root)
   }
   else {
     stack.push_back(BVHStackEntry(root, nextNodeIdx));
-    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_NODE_SIZE : BVH_NODE_SIZE;
+    nextNodeIdx += inner_node_size(root);
   }
 
   while (stack.size()) {
@@ -285,8 +429,7 @@ void BVH2::pack_nodes(const BVHNode *root)
         }
         else {
           idx[i] = nextNodeIdx;
-          nextNodeIdx += e.node->get_child(i)->has_unaligned() ? BVH_UNALIGNED_NODE_SIZE :
-                                                                 BVH_NODE_SIZE;
+          nextNodeIdx += inner_node_size(e.node->get_child(i));
         }
       }
 
@@ -301,6 +444,14 @@ void BVH2::pack_nodes(const BVHNode *root)
   pack.root_index = (root->is_leaf()) ? -1 : 0;
 }
 
+int BVH2::inner_node_size(const BVHNode *node) const
+{
+  if (node->has_unaligned()) {
+    return BVH_UNALIGNED_NODE_SIZE;
+  }
+  return (params.use_quantized_nodes) ? BVH_QUANTIZED_NODE_SIZE : BVH_NODE_SIZE;
+}
+
 void BVH2::refit_nodes()
 {
   assert(!params.top_level);
@@ -330,10 +481,12 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4) * BVH_NODE_LEAF_SIZE);
   }
   else {
-    assert(idx + BVH_NODE_SIZE <= pack.nodes.size());
+    assert(idx + BVH_QUANTIZED_NODE_SIZE <= pack.nodes.size());
 
     const int4 *data = &pack.nodes[idx];
     const bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+    const bool is_quantized = (data[0].x & PATH_RAY_NODE_QUANTIZED) != 0;
+    assert(is_quantized || idx + BVH_NODE_SIZE <= pack.nodes.size());
     const int c0 = data[0].z;
     const int c1 = data[0].w;
     /* refit inner node, set bbox from children */
@@ -348,6 +501,9 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
       pack_unaligned_node(
           idx, aligned_space, aligned_space, bbox0, bbox1, c0, c1, visibility0, visibility1);
     }
+    else if (is_quantized) {
+      pack_quantized_node(idx, bbox0, bbox1, c0, c1, visibility0, visibility1);
+    }
     else {
       pack_aligned_node(idx, bbox0, bbox1, c0, c1, visibility0, visibility1);
     }
@@ -614,6 +770,10 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
           nsize = BVH_UNALIGNED_NODE_SIZE;
           nsize_bbox = 0;
         }
+        else if (bvh_nodes[i].x & PATH_RAY_NODE_QUANTIZED) {
+          nsize = BVH_QUANTIZED_NODE_SIZE;
+          nsize_bbox = 0;
+        }
         else {
           nsize = BVH_NODE_SIZE;
           nsize_bbox = 0;
@@ -34,6 +34,7 @@
 #  include "util/log.h"
 #  include "util/progress.h"
 #  include "util/stats.h"
+#  include "util/time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -122,6 +123,9 @@ void BVHEmbree::build(Progress &progress, Stats *stats, RTCDevice rtc_device_)
     scene = NULL;
   }
 
+  const double build_start_time = time_dt();
+  this->stats.reset();
+
   const bool dynamic = params.bvh_type == BVH_TYPE_DYNAMIC;
   const bool compact = params.use_compact_structure;
 
@@ -163,6 +167,24 @@ void BVHEmbree::build(Progress &progress, Stats *stats, RTCDevice rtc_device_)
 
   rtcSetSceneProgressMonitorFunction(scene, rtc_progress_func, &progress);
   rtcCommitScene(scene);
+
+  /* Embree does not expose its internal tree layout, only report what is known. */
+  RTCBounds rtc_bounds;
+  rtcGetSceneBounds(scene, &rtc_bounds);
+  this->stats.bounds = BoundBox(
+      make_float3(rtc_bounds.lower_x, rtc_bounds.lower_y, rtc_bounds.lower_z),
+      make_float3(rtc_bounds.upper_x, rtc_bounds.upper_y, rtc_bounds.upper_z));
+  if (build_quality == RTC_BUILD_QUALITY_HIGH) {
+    this->stats.builder = "Embree (high quality)";
+  }
+  else if (build_quality == RTC_BUILD_QUALITY_MEDIUM) {
+    this->stats.builder = "Embree (medium quality)";
+  }
+  else {
+    this->stats.builder = "Embree (low quality)";
+  }
+  this->stats.num_original_references = this->stats.num_references;
+  this->stats.build_time = time_dt() - build_start_time;
 }
 
 void BVHEmbree::add_object(Object *ob, int i)
@@ -173,18 +195,21 @@ void BVHEmbree::add_object(Object *ob, int i)
     Mesh *mesh = static_cast<Mesh *>(geom);
     if (mesh->num_triangles() > 0) {
       add_triangles(ob, mesh, i);
+      stats.num_references += mesh->num_triangles();
     }
   }
   else if (geom->geometry_type == Geometry::HAIR) {
     Hair *hair = static_cast<Hair *>(geom);
     if (hair->num_curves() > 0) {
       add_curves(ob, hair, i);
+      stats.num_references += hair->num_segments();
     }
   }
   else if (geom->geometry_type == Geometry::POINTCLOUD) {
     PointCloud *pointcloud = static_cast<PointCloud *>(geom);
     if (pointcloud->num_points() > 0) {
       add_points(ob, pointcloud, i);
+      stats.num_references += pointcloud->num_points();
     }
   }
 }
@@ -230,6 +255,8 @@ void BVHEmbree::add_instance(Object *ob, int i)
   rtcCommitGeometry(geom_id);
   rtcAttachGeometryByID(scene, geom_id, i * 2);
   rtcReleaseGeometry(geom_id);
+
+  stats.num_references++;
 }
 
 void BVHEmbree::add_triangles(const Object *ob, const Mesh *mesh, int i)
@@ -87,6 +87,12 @@ class BVHParams {
   /* Use compact acceleration structure (Embree)*/
   bool use_compact_structure;
 
+  /* Store aligned inner nodes with child bounds quantized relative to the
+   * node bounds. Uses less memory at the cost of some decoding during traversal.
+   * Only used for BVH2 layout.
+   */
+  bool use_quantized_nodes;
+
   /* Split time range to this number of steps and create leaf node for each
    * of this time steps.
    *
@@ -130,6 +136,7 @@ class BVHParams {
     top_level = false;
     bvh_layout = BVH_LAYOUT_BVH2;
     use_compact_structure = false;
+    use_quantized_nodes = false;
     use_unaligned_nodes = false;
 
     num_motion_curve_steps = 0;
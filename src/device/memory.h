@@ -520,6 +520,26 @@ template<typename T> class device_vector : public device_memory {
     }
   }
 
+  /* Copy only the first num elements to the device. Device memory is allocated for the whole
+   * vector by the first copy, so that later copies of more elements still fit. Not supported for
+   * global memory and textures, which are reallocated on every copy. */
+  void copy_to_device(size_t num)
+  {
+    assert(type != MEM_GLOBAL && type != MEM_TEXTURE);
+
+    if (device_pointer == 0 || num >= data_size) {
+      copy_to_device();
+      return;
+    }
+
+    if (num != 0) {
+      const size_t size = data_size;
+      data_size = num;
+      device_copy_to();
+      data_size = size;
+    }
+  }
+
   void copy_to_device_if_modified()
   {
     if (!modified) {
@@ -39,4 +39,22 @@ class AdaptiveSampling {
   float threshold = 0.0f;
 };
 
+/* Convergence of the image at a point in time, measured by the adaptive sampling convergence
+ * check and filter. */
+class AdaptiveSamplingConvergence {
+ public:
+  /* Number of samples rendered at the time of the check. */
+  int num_samples = 0;
+
+  /* Time in seconds since the render started. */
+  double time = 0.0;
+
+  /* Threshold used by the check. */
+  float threshold = 0.0f;
+
+  /* Number of pixels which did not converge yet, out of all pixels of the render. */
+  int num_active_pixels = 0;
+  int num_pixels = 0;
+};
+
 CCL_NAMESPACE_END
@@ -50,6 +50,9 @@ class OIDNPass {
     num_components = pass_info.num_components;
     use_compositing = pass_info.use_compositing;
     use_denoising_albedo = pass_info.use_denoising_albedo;
+
+    const BufferPass *buffer_pass = buffer_params.find_pass(type, mode);
+    use_half_storage = (buffer_pass && buffer_pass->use_half_storage);
   }
 
   inline operator bool() const
@@ -68,6 +71,10 @@ class OIDNPass {
   bool use_compositing = false;
   bool use_denoising_albedo = true;
 
+  /* Pass is stored as packed half float in the render buffers, and can not be referenced by the
+   * denoiser directly. */
+  bool use_half_storage = false;
+
   /* Offset of beginning of this pass in the render buffers. */
   int offset = -1;
 
@@ -152,6 +159,9 @@ class OIDNDenoiseContext {
 
     oidn::DeviceRef oidn_device = oidn::newDevice();
     oidn_device.set("setAffinity", false);
+    if (denoiser_->get_num_threads() > 0) {
+      oidn_device.set("numThreads", denoiser_->get_num_threads());
+    }
     oidn_device.commit();
 
     /* Create a filter for denoising a beauty (color) image using prefiltered auxiliary images too.
@@ -211,6 +221,11 @@ class OIDNDenoiseContext {
 
     DCHECK(!oidn_pass.use_compositing);
 
+    if (oidn_pass.use_half_storage) {
+      read_pass_pixels_into_buffer(oidn_pass);
+      return;
+    }
+
     if (denoise_params_.prefilter != DENOISER_PREFILTER_ACCURATE &&
         !is_pass_scale_needed(oidn_pass)) {
       /* Pass data is available as-is from the render buffers. */
@@ -618,6 +633,16 @@ bool OIDNDenoiser::denoise_buffer(const BufferParams &buffer_params,
   return true;
 }
 
+void OIDNDenoiser::set_num_threads(const int num_threads)
+{
+  num_threads_ = num_threads;
+}
+
+int OIDNDenoiser::get_num_threads() const
+{
+  return num_threads_;
+}
+
 uint OIDNDenoiser::get_device_type_mask() const
 {
   return DEVICE_MASK_CPU;
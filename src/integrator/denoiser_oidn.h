@@ -23,6 +23,11 @@ class OIDNDenoiser : public Denoiser {
                               const int num_samples,
                               bool allow_inplace_modification) override;
 
+  /* Number of threads used by OpenImageDenoise. Zero means all available threads.
+   * Allows to leave threads for path tracing when denoising happens at the same time. */
+  void set_num_threads(const int num_threads);
+  int get_num_threads() const;
+
  protected:
   virtual uint get_device_type_mask() const override;
   virtual Device *ensure_denoiser_device(Progress *progress) override;
@@ -30,6 +35,8 @@ class OIDNDenoiser : public Denoiser {
   /* We only perform one denoising at a time, since OpenImageDenoise itself is multithreaded.
    * Use this mutex whenever images are passed to the OIDN and needs to be denoised. */
   static thread_mutex mutex_;
+
+  int num_threads_ = 0;
 };
 
 CCL_NAMESPACE_END
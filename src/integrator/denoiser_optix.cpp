@@ -237,6 +237,9 @@ class OptiXDenoiser::DenoiseContext {
         use_pass_normal = true;
         pass_denoising_normal = buffer_params.get_pass_offset(PASS_DENOISING_NORMAL);
       }
+
+      const BufferPass *albedo_pass = buffer_params.find_pass(PASS_DENOISING_ALBEDO);
+      pass_denoising_use_half = (albedo_pass && albedo_pass->use_half_storage);
     }
 
     if (denoise_params.temporally_stable) {
@@ -255,7 +258,9 @@ class OptiXDenoiser::DenoiseContext {
     use_guiding_passes = (num_input_passes - 1) > 0;
 
     if (use_guiding_passes) {
-      if (task.allow_inplace_modification) {
+      /* Guiding passes stored in half float are unpacked into a separate buffer, as the unpacked
+       * pixels do not fit into the render buffer passes. */
+      if (task.allow_inplace_modification && !pass_denoising_use_half) {
         guiding_params.device_pointer = render_buffers->buffer.device_pointer;
 
         guiding_params.pass_albedo = pass_denoising_albedo;
@@ -337,6 +342,9 @@ class OptiXDenoiser::DenoiseContext {
   int pass_denoising_normal = PASS_UNUSED;
   int pass_motion = PASS_UNUSED;
 
+  /* Denoising albedo and normal passes are stored as packed half float. */
+  int pass_denoising_use_half = 0;
+
   /* For passes which don't need albedo channel for denoising we replace the actual albedo with
    * the (0.5, 0.5, 0.5). This flag indicates that the real albedo pass has been replaced with
    * the fake values and denoising of passes which do need albedo can no longer happen. */
@@ -411,6 +419,7 @@ bool OptiXDenoiser::denoise_filter_guiding_preprocess(const DenoiseContext &cont
                              &context.pass_sample_count,
                              &context.pass_denoising_albedo,
                              &context.pass_denoising_normal,
+                             &context.pass_denoising_use_half,
                              &context.pass_motion,
                              &buffer_params.full_x,
                              &buffer_params.full_y,
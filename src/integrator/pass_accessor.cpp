@@ -282,6 +282,9 @@ void PassAccessor::init_kernel_film_convert(KernelFilmConvert *kfilm_convert,
                                                            destination.num_components;
 
   kfilm_convert->is_denoised = (mode == PassMode::DENOISED);
+
+  const BufferPass *buffer_pass = buffer_params.find_pass(pass_access_info_.type, mode);
+  kfilm_convert->pass_use_half = (buffer_pass && buffer_pass->use_half_storage);
 }
 
 bool PassAccessor::set_render_tile_pixels(RenderBuffers *render_buffers, const Source &source)
@@ -305,6 +308,26 @@ bool PassAccessor::set_render_tile_pixels(RenderBuffers *render_buffers, const S
   float *out = buffer_data + pass_access_info_.offset;
   const float *in = source.pixels + source.offset * in_stride;
 
+  const BufferPass *buffer_pass = buffer_params.find_pass(pass_access_info_.type,
+                                                          pass_access_info_.mode);
+  if (buffer_pass && buffer_pass->use_half_storage) {
+    const int storage_size = buffer_pass->get_storage_size();
+    for (int i = 0; i < size; i++, out += out_stride, in += in_stride) {
+      for (int j = 0; j < storage_size; j++) {
+        const int component = j * 2;
+        uint packed = 0;
+        if (component < num_components_to_copy) {
+          packed |= float_to_half_storage(in[component]);
+        }
+        if (component + 1 < num_components_to_copy) {
+          packed |= float_to_half_storage(in[component + 1]) << 16;
+        }
+        out[j] = __uint_as_float(packed);
+      }
+    }
+    return true;
+  }
+
   for (int i = 0; i < size; i++, out += out_stride, in += in_stride) {
     memcpy(out, in, sizeof(float) * num_components_to_copy);
   }
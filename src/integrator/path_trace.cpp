@@ -5,12 +5,14 @@
 
 #include "device/cpu/device.h"
 #include "device/device.h"
+#include "integrator/denoiser_oidn.h"
 #include "integrator/pass_accessor.h"
 #include "integrator/path_trace_display.h"
 #include "integrator/path_trace_tile.h"
 #include "integrator/render_scheduler.h"
 #include "scene/pass.h"
 #include "scene/scene.h"
+#include "session/checkpoint.h"
 #include "session/tile.h"
 #include "util/algorithm.h"
 #include "util/log.h"
@@ -58,6 +60,9 @@ PathTrace::PathTrace(Device *device,
 
 PathTrace::~PathTrace()
 {
+  /* The pipelined task accesses the output driver and buffers owned by the path tracer. */
+  wait_denoise_pipeline();
+
   destroy_gpu_resources();
 }
 
@@ -212,17 +217,24 @@ void PathTrace::render_pipeline(RenderWork render_work)
     return;
   }
 
+  write_checkpoint(render_work);
+
   cryptomatte_postprocess(render_work);
   if (render_cancel_.is_requested) {
     return;
   }
 
-  denoise(render_work);
-  if (render_cancel_.is_requested) {
-    return;
+  if (is_denoise_pipeline_used(render_work)) {
+    denoise_pipeline_push(render_work);
   }
+  else {
+    denoise(render_work);
+    if (render_cancel_.is_requested) {
+      return;
+    }
 
-  write_tile_buffer(render_work);
+    write_tile_buffer(render_work);
+  }
   update_display(render_work);
 
   progress_update_if_needed(render_work);
@@ -368,6 +380,9 @@ void PathTrace::init_render_buffers(const RenderWork &render_work)
 
     tile_buffer_read();
   }
+  else if (render_work.checkpoint.read) {
+    checkpoint_read();
+  }
 }
 
 void PathTrace::path_trace(RenderWork &render_work)
@@ -449,6 +464,11 @@ void PathTrace::adaptive_sample(RenderWork &render_work)
 
     render_scheduler_.report_adaptive_filter_time(
         render_work, time_dt() - start_time, is_cancel_requested());
+    render_scheduler_.report_adaptive_filter_active_pixels(
+        render_work,
+        num_active_pixels,
+        render_state_.effective_big_tile_params.width *
+            render_state_.effective_big_tile_params.height);
 
     if (num_active_pixels == 0) {
       VLOG_WORK << "All pixels converged.";
@@ -562,6 +582,13 @@ void PathTrace::denoise(const RenderWork &render_work)
     buffer_to_denoise = path_trace_works_.front()->get_render_buffers();
   }
 
+  const DenoiseParams denoise_params = denoiser_->get_params();
+  const DenoiseParams work_denoise_params = get_denoise_params(render_work);
+  const bool use_work_params = work_denoise_params.modified(denoise_params);
+  if (use_work_params) {
+    denoiser_->set_params(work_denoise_params);
+  }
+
   if (denoiser_->denoise_buffer(render_state_.effective_big_tile_params,
                                 buffer_to_denoise,
                                 get_num_samples_in_buffer(),
@@ -569,11 +596,65 @@ void PathTrace::denoise(const RenderWork &render_work)
     render_state_.has_denoised_result = true;
   }
 
+  if (use_work_params) {
+    denoiser_->set_params(denoise_params);
+  }
+
   render_scheduler_.report_denoise_time(render_work, time_dt() - start_time);
 }
 
+DenoiseParams PathTrace::get_denoise_params(const RenderWork &render_work) const
+{
+  DenoiseParams denoise_params = denoiser_->get_params();
+
+  /* Spend the time which is left until the render deadline on a more accurate prefiltering of the
+   * guiding passes. It denoises the albedo and normal passes as well, so it takes about three
+   * times as long as the fast prefiltering. */
+  const double denoise_time_estimate = render_scheduler_.estimate_denoise_time();
+  if (denoise_params.prefilter == DENOISER_PREFILTER_FAST && denoise_time_estimate > 0.0 &&
+      render_work.tile.denoise_time_budget > 3.0 * denoise_time_estimate) {
+    VLOG_WORK << "Using accurate denoiser prefilter, denoising time budget is "
+              << render_work.tile.denoise_time_budget << " seconds.";
+    denoise_params.prefilter = DENOISER_PREFILTER_ACCURATE;
+  }
+
+  return denoise_params;
+}
+
+void PathTrace::set_checkpoint_filepath(const string &filepath)
+{
+  checkpoint_filepath_ = filepath;
+}
+
+void PathTrace::set_denoise_pipeline(const bool use, const int num_threads)
+{
+  denoise_pipeline_.use = use;
+  denoise_pipeline_.num_threads = num_threads;
+}
+
+void PathTrace::wait_denoise_pipeline()
+{
+  if (denoise_pipeline_.pool) {
+    denoise_pipeline_.pool->wait();
+  }
+}
+
+void PathTrace::finish_denoise_pipeline()
+{
+  wait_denoise_pipeline();
+
+  if (denoise_pipeline_.need_report_denoise_time) {
+    render_scheduler_.report_denoise_time(denoise_pipeline_.render_work,
+                                          denoise_pipeline_.denoise_time);
+    denoise_pipeline_.need_report_denoise_time = false;
+  }
+}
+
 void PathTrace::set_output_driver(unique_ptr<OutputDriver> driver)
 {
+  /* Make sure the previous result is written to the driver it was rendered for. */
+  wait_denoise_pipeline();
+
   output_driver_ = move(driver);
 }
 
@@ -639,6 +720,7 @@ void PathTrace::update_display(const RenderWork &render_work)
     VLOG_WORK << "Invoke buffer update callback.";
 
     PathTraceTile tile(*this);
+    thread_scoped_lock lock(output_driver_mutex_);
     output_driver_->update_render_tile(tile);
   }
 
@@ -759,6 +841,79 @@ void PathTrace::write_tile_buffer(const RenderWork &render_work)
   }
 }
 
+bool PathTrace::is_denoise_pipeline_used(const RenderWork &render_work) const
+{
+  if (!denoise_pipeline_.use || !render_work.tile.denoise || !render_work.tile.write) {
+    return false;
+  }
+
+  if (!denoiser_ || denoiser_->get_params().type != DENOISER_OPENIMAGEDENOISE) {
+    return false;
+  }
+
+  /* With multiple tiles the full frame is denoised once all tiles are written to disk. */
+  if (tile_manager_.has_multiple_tiles()) {
+    return false;
+  }
+
+  return output_driver_ != nullptr;
+}
+
+void PathTrace::denoise_pipeline_push(const RenderWork &render_work)
+{
+  /* Keep at most one result in flight, so that the memory used by the copies is bounded and the
+   * results are written in order. */
+  finish_denoise_pipeline();
+
+  VLOG_WORK << "Queue pipelined denoising and writing of the tile result.";
+
+  render_state_.tile_written = true;
+
+  const DenoiseParams denoise_params = get_denoise_params(render_work);
+  if (!denoise_pipeline_.denoiser) {
+    denoise_pipeline_.denoiser = make_unique<OIDNDenoiser>(cpu_device_.get(), denoise_params);
+  }
+  else {
+    denoise_pipeline_.denoiser->set_params(denoise_params);
+  }
+  denoise_pipeline_.denoiser->set_num_threads(denoise_pipeline_.num_threads);
+
+  if (!denoise_pipeline_.render_buffers) {
+    denoise_pipeline_.render_buffers = make_unique<RenderBuffers>(cpu_device_.get());
+  }
+  denoise_pipeline_.render_buffers->reset(render_state_.effective_big_tile_params);
+  copy_to_render_buffers(denoise_pipeline_.render_buffers.get());
+
+  if (!denoise_pipeline_.pool) {
+    denoise_pipeline_.pool = make_unique<DedicatedTaskPool>();
+  }
+
+  denoise_pipeline_.render_work = render_work;
+  denoise_pipeline_.need_report_denoise_time = false;
+
+  const int num_samples = get_num_samples_in_buffer();
+  const int2 offset = get_render_tile_offset();
+  const int2 size = get_render_tile_size();
+  const int2 full_size = get_render_size();
+
+  denoise_pipeline_.pool->push([this, num_samples, offset, size, full_size]() {
+    RenderBuffers *render_buffers = denoise_pipeline_.render_buffers.get();
+
+    const double start_time = time_dt();
+    const bool has_denoised_result = denoise_pipeline_.denoiser->denoise_buffer(
+        render_buffers->params, render_buffers, num_samples, true);
+    denoise_pipeline_.denoise_time = time_dt() - start_time;
+    denoise_pipeline_.need_report_denoise_time = true;
+    VLOG_WORK << "Pipelined denoising finished in " << denoise_pipeline_.denoise_time
+              << " seconds.";
+
+    RenderBuffersTile tile(
+        offset, size, full_size, *render_buffers, num_samples, has_denoised_result);
+    thread_scoped_lock lock(output_driver_mutex_);
+    output_driver_->write_render_tile(tile);
+  });
+}
+
 void PathTrace::finalize_full_buffer_on_disk(const RenderWork &render_work)
 {
   if (!render_work.full.write) {
@@ -774,7 +929,9 @@ void PathTrace::finalize_full_buffer_on_disk(const RenderWork &render_work)
 
   /* Make sure writing to the file is fully finished.
    * This will include writing all possible missing tiles, ensuring validness of the file. */
-  tile_manager_.finish_write_tiles();
+  if (!tile_manager_.finish_write_tiles()) {
+    device_->set_error("Error writing tile file");
+  }
 
   /* NOTE: The rest of full-frame post-processing (such as full-frame denoising) will be done after
    * all scenes and layers are rendered by the Session (which happens after freeing Session memory,
@@ -821,6 +978,7 @@ void PathTrace::tile_buffer_write()
   }
 
   PathTraceTile tile(*this);
+  thread_scoped_lock lock(output_driver_mutex_);
   output_driver_->write_render_tile(tile);
 }
 
@@ -841,6 +999,7 @@ void PathTrace::tile_buffer_read()
 
   /* Read (subset of) passes from output driver. */
   PathTraceTile tile(*this);
+  thread_scoped_lock lock(output_driver_mutex_);
   if (output_driver_->read_render_tile(tile)) {
     /* Copy buffers to device again. */
     parallel_for_each(path_trace_works_, [](unique_ptr<PathTraceWork> &path_trace_work) {
@@ -849,6 +1008,21 @@ void PathTrace::tile_buffer_read()
   }
 }
 
+void PathTrace::checkpoint_read()
+{
+  VLOG_WORK << "Read render buffers from checkpoint " << checkpoint_filepath_;
+
+  RenderBuffers big_tile_cpu_buffers(cpu_device_.get());
+  big_tile_cpu_buffers.reset(render_state_.effective_big_tile_params);
+
+  if (!RenderCheckpoint::read_buffers(checkpoint_filepath_, &big_tile_cpu_buffers)) {
+    device_->set_error("Error reading render checkpoint");
+    return;
+  }
+
+  copy_from_render_buffers(&big_tile_cpu_buffers);
+}
+
 void PathTrace::tile_buffer_write_to_disk()
 {
   /* Sample count pass is required to support per-tile partial results stored in the file. */
@@ -881,6 +1055,29 @@ void PathTrace::tile_buffer_write_to_disk()
   }
 }
 
+void PathTrace::write_checkpoint(const RenderWork &render_work)
+{
+  if (!render_work.checkpoint.write || checkpoint_filepath_.empty()) {
+    return;
+  }
+
+  VLOG_WORK << "Write render checkpoint.";
+
+  const double start_time = time_dt();
+
+  RenderBuffers big_tile_cpu_buffers(cpu_device_.get());
+  big_tile_cpu_buffers.reset(render_state_.effective_big_tile_params);
+  copy_to_render_buffers(&big_tile_cpu_buffers);
+
+  RenderCheckpoint checkpoint;
+  render_scheduler_.get_checkpoint_state(checkpoint);
+
+  /* Failure to write a checkpoint is not fatal for the render itself. */
+  checkpoint.write(checkpoint_filepath_, big_tile_cpu_buffers);
+
+  VLOG_WORK << "Render checkpoint written in " << time_dt() - start_time << " seconds.";
+}
+
 void PathTrace::progress_update_if_needed(const RenderWork &render_work)
 {
   if (progress_ != nullptr) {
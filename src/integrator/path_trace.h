@@ -7,12 +7,14 @@
 #include "integrator/guiding.h"
 #include "integrator/pass_accessor.h"
 #include "integrator/path_trace_work.h"
+#include "integrator/render_scheduler.h"
 #include "integrator/work_balancer.h"
 
 #include "session/buffers.h"
 
 #include "util/function.h"
 #include "util/guiding.h"
+#include "util/task.h"
 #include "util/thread.h"
 #include "util/unique_ptr.h"
 #include "util/vector.h"
@@ -24,9 +26,8 @@ class Device;
 class DeviceScene;
 class DisplayDriver;
 class Film;
+class OIDNDenoiser;
 class RenderBuffers;
-class RenderScheduler;
-class RenderWork;
 class PathTraceDisplay;
 class OutputDriver;
 class Progress;
@@ -97,6 +98,23 @@ class PathTrace {
    * Use to setup the guiding structures before each rendering iteration.*/
   void set_guiding_params(const GuidingParams &params, const bool reset);
 
+  /* Set file path of the render checkpoint.
+   * The checkpoint is written and read when the render scheduler schedules it. */
+  void set_checkpoint_filepath(const string &filepath);
+
+  /* Configure pipelined denoising of the final render result.
+   * When enabled the result is copied, and denoised and written to the output driver on a
+   * separate thread while the path tracer carries on with the next render. The denoiser uses the
+   * given number of threads, zero means all available threads. */
+  void set_denoise_pipeline(const bool use, const int num_threads);
+
+  /* Wait for the pipelined denoising and writing of the previous render result to finish. */
+  void wait_denoise_pipeline();
+
+  /* Same as above, and also report the time the denoising took to the render scheduler. Only to
+   * be called from the thread which renders. */
+  void finish_denoise_pipeline();
+
   /* Sets output driver for render buffer output. */
   void set_output_driver(unique_ptr<OutputDriver> driver);
 
@@ -211,6 +229,7 @@ class PathTrace {
   void update_display(const RenderWork &render_work);
   void rebalance(const RenderWork &render_work);
   void write_tile_buffer(const RenderWork &render_work);
+  void write_checkpoint(const RenderWork &render_work);
   void finalize_full_buffer_on_disk(const RenderWork &render_work);
 
   /* Updates/initializes the guiding structures after a rendering iteration.
@@ -225,6 +244,16 @@ class PathTrace {
   /* Get number of samples in the current state of the render buffers. */
   int get_num_samples_in_buffer();
 
+  /* Check whether denoising and writing of the given work is to be pipelined. */
+  bool is_denoise_pipeline_used(const RenderWork &render_work) const;
+
+  /* Get denoiser parameters for the work, using the accurate prefilter when the time which is left
+   * until the render deadline allows it. */
+  DenoiseParams get_denoise_params(const RenderWork &render_work) const;
+
+  /* Copy the big tile, and queue its denoising and writing to the output driver. */
+  void denoise_pipeline_push(const RenderWork &render_work);
+
   /* Check whether user requested to cancel rendering, so that path tracing is to be finished as
    * soon as possible. */
   bool is_cancel_requested();
@@ -235,6 +264,9 @@ class PathTrace {
   /* Read the big tile render buffer via the read callback. */
   void tile_buffer_read();
 
+  /* Read the big tile render buffer from the render checkpoint. */
+  void checkpoint_read();
+
   /* Write current tile into the file on disk. */
   void tile_buffer_write_to_disk();
 
@@ -262,8 +294,14 @@ class PathTrace {
   /* Display driver for interactive render buffer display. */
   unique_ptr<PathTraceDisplay> display_;
 
-  /* Output driver to write render buffer to. */
+  /* Output driver to write render buffer to.
+   * Calls into the driver are serialized by the mutex, since the denoise pipeline writes results
+   * from its own thread. */
   unique_ptr<OutputDriver> output_driver_;
+  thread_mutex output_driver_mutex_;
+
+  /* File path of the render checkpoint. */
+  string checkpoint_filepath_;
 
   /* Per-compute device descriptors of work which is responsible for path tracing on its configured
    * device. */
@@ -282,6 +320,29 @@ class PathTrace {
   /* Denoiser device descriptor which holds the denoised big tile for multi-device workloads. */
   unique_ptr<PathTraceWork> big_tile_denoise_work_;
 
+  /* Denoising of the final render result on a dedicated thread.
+   * The buffers and denoiser are only accessed by the pool while a task is queued, and there is at
+   * most one queued task at a time. */
+  struct {
+    bool use = false;
+    int num_threads = 0;
+
+    unique_ptr<DedicatedTaskPool> pool;
+
+    /* Separate denoiser, so that its threads and parameters are not shared with the denoiser
+     * used for the regular rendering. */
+    unique_ptr<OIDNDenoiser> denoiser;
+
+    /* Copy of the render result which is being denoised and written. */
+    unique_ptr<RenderBuffers> render_buffers;
+
+    /* Work of the queued result, and the time its denoising took. The time is set by the task
+     * and reported by finish_denoise_pipeline(), since the render scheduler is not thread-safe. */
+    RenderWork render_work;
+    double denoise_time = 0.0;
+    bool need_report_denoise_time = false;
+  } denoise_pipeline_;
+
 #ifdef WITH_PATH_GUIDING
   /* Guiding related attributes */
   GuidingParams guiding_params_;
@@ -91,4 +91,57 @@ bool PathTraceTile::set_pass_pixels(const string_view pass_name,
   return path_trace_.set_render_tile_pixels(pass_accessor, source);
 }
 
+RenderBuffersTile::RenderBuffersTile(const int2 offset,
+                                     const int2 size,
+                                     const int2 full_size,
+                                     const RenderBuffers &render_buffers,
+                                     const int num_samples,
+                                     const bool has_denoised_result)
+    : OutputDriver::Tile(
+          offset, size, full_size, render_buffers.params.layer, render_buffers.params.view),
+      render_buffers_(render_buffers),
+      num_samples_(num_samples),
+      has_denoised_result_(has_denoised_result)
+{
+}
+
+bool RenderBuffersTile::get_pass_pixels(const string_view pass_name,
+                                        const int num_channels,
+                                        float *pixels) const
+{
+  const BufferParams &buffer_params = render_buffers_.params;
+
+  const BufferPass *pass = buffer_params.find_pass(pass_name);
+  if (pass == nullptr) {
+    return false;
+  }
+
+  if (pass->mode == PassMode::DENOISED && !has_denoised_result_) {
+    pass = buffer_params.find_pass(pass->type);
+    if (pass == nullptr) {
+      return false;
+    }
+  }
+
+  pass = buffer_params.get_actual_display_pass(pass);
+
+  PassAccessor::PassAccessInfo pass_access_info(*pass);
+  pass_access_info.use_approximate_shadow_catcher = buffer_params.use_approximate_shadow_catcher;
+  pass_access_info.use_approximate_shadow_catcher_background =
+      pass_access_info.use_approximate_shadow_catcher && !buffer_params.use_transparent_background;
+
+  const PassAccessorCPU pass_accessor(pass_access_info, buffer_params.exposure, num_samples_);
+  const PassAccessor::Destination destination(pixels, num_channels);
+
+  return pass_accessor.get_render_tile_pixels(&render_buffers_, destination);
+}
+
+bool RenderBuffersTile::set_pass_pixels(const string_view /*pass_name*/,
+                                        const int /*num_channels*/,
+                                        const float * /*pixels*/) const
+{
+  /* The buffers are a copy of the render result, so there is nothing to read passes into. */
+  return false;
+}
+
 CCL_NAMESPACE_END
@@ -12,6 +12,7 @@ CCL_NAMESPACE_BEGIN
  * Implementation of OutputDriver::Tile interface for path tracer. */
 
 class PathTrace;
+class RenderBuffers;
 
 class PathTraceTile : public OutputDriver::Tile {
  public:
@@ -27,4 +28,29 @@ class PathTraceTile : public OutputDriver::Tile {
   mutable bool copied_from_device_;
 };
 
+/* RenderBuffersTile
+ *
+ * Implementation of OutputDriver::Tile interface for a copy of the big tile render buffers.
+ * Used when the result is written while the path tracer is busy with the next render. */
+
+class RenderBuffersTile : public OutputDriver::Tile {
+ public:
+  RenderBuffersTile(const int2 offset,
+                    const int2 size,
+                    const int2 full_size,
+                    const RenderBuffers &render_buffers,
+                    const int num_samples,
+                    const bool has_denoised_result);
+
+  bool get_pass_pixels(const string_view pass_name, const int num_channels, float *pixels) const;
+  bool set_pass_pixels(const string_view pass_name,
+                       const int num_channels,
+                       const float *pixels) const;
+
+ private:
+  const RenderBuffers &render_buffers_;
+  int num_samples_;
+  bool has_denoised_result_;
+};
+
 CCL_NAMESPACE_END
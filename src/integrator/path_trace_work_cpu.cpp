@@ -21,6 +21,11 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Size in pixels of the blocks used to skip converged regions of the image with adaptive
+ * sampling. Small enough to follow the shape of noisy regions, large enough to keep the
+ * bookkeeping cheap. */
+static const int ADAPTIVE_SAMPLING_BLOCK_SIZE = 8;
+
 /* Create TBB arena for execution of path tracing and rendering tasks. */
 static inline tbb::task_arena local_tbb_arena_create(const Device *device)
 {
@@ -72,32 +77,64 @@ void PathTraceWorkCPU::render_samples(RenderStatistics &statistics,
     }
   }
 
-  tbb::task_arena local_arena = local_tbb_arena_create(device_);
-  local_arena.execute([&]() {
-    parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
-      if (is_cancel_requested()) {
-        return;
-      }
+  auto render_pixel = [&](const int x, const int y) {
+    KernelWorkTile work_tile;
+    work_tile.x = effective_buffer_params_.full_x + x;
+    work_tile.y = effective_buffer_params_.full_y + y;
+    work_tile.w = 1;
+    work_tile.h = 1;
+    work_tile.start_sample = start_sample;
+    work_tile.sample_offset = sample_offset;
+    work_tile.num_samples = 1;
+    work_tile.offset = effective_buffer_params_.offset;
+    work_tile.stride = effective_buffer_params_.stride;
 
-      const int y = work_index / image_width;
-      const int x = work_index - y * image_width;
+    CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
 
-      KernelWorkTile work_tile;
-      work_tile.x = effective_buffer_params_.full_x + x;
-      work_tile.y = effective_buffer_params_.full_y + y;
-      work_tile.w = 1;
-      work_tile.h = 1;
-      work_tile.start_sample = start_sample;
-      work_tile.sample_offset = sample_offset;
-      work_tile.num_samples = 1;
-      work_tile.offset = effective_buffer_params_.offset;
-      work_tile.stride = effective_buffer_params_.stride;
+    render_samples_full_pipeline(kernel_globals, work_tile, samples_num);
+  };
 
-      CPUKernelThreadGlobals *kernel_globals = kernel_thread_globals_get(kernel_thread_globals_);
+  tbb::task_arena local_arena = local_tbb_arena_create(device_);
+  if (has_adaptive_sampling_active_blocks()) {
+    /* Only schedule blocks which have pixels that did not converge yet. Converged pixels inside
+     * of the active blocks are skipped by the kernel. */
+    const vector<int> &blocks = adaptive_active_blocks_.blocks;
+    const int num_blocks_x = divide_up(image_width, ADAPTIVE_SAMPLING_BLOCK_SIZE);
 
-      render_samples_full_pipeline(kernel_globals, work_tile, samples_num);
+    local_arena.execute([&]() {
+      parallel_for(size_t(0), blocks.size(), [&](size_t block_index) {
+        const int block_y = blocks[block_index] / num_blocks_x;
+        const int block_x = blocks[block_index] - block_y * num_blocks_x;
+        const int x_begin = block_x * ADAPTIVE_SAMPLING_BLOCK_SIZE;
+        const int y_begin = block_y * ADAPTIVE_SAMPLING_BLOCK_SIZE;
+        const int x_end = min(x_begin + ADAPTIVE_SAMPLING_BLOCK_SIZE, int(image_width));
+        const int y_end = min(y_begin + ADAPTIVE_SAMPLING_BLOCK_SIZE, int(image_height));
+
+        for (int y = y_begin; y < y_end; ++y) {
+          for (int x = x_begin; x < x_end; ++x) {
+            if (is_cancel_requested()) {
+              return;
+            }
+            render_pixel(x, y);
+          }
+        }
+      });
     });
-  });
+  }
+  else {
+    local_arena.execute([&]() {
+      parallel_for(int64_t(0), total_pixels_num, [&](int64_t work_index) {
+        if (is_cancel_requested()) {
+          return;
+        }
+
+        const int y = work_index / image_width;
+        const int x = work_index - y * image_width;
+
+        render_pixel(x, y);
+      });
+    });
+  }
   if (device_->profiler.active()) {
     for (CPUKernelThreadGlobals &kernel_globals : kernel_thread_globals_) {
       kernel_globals.stop_profiling();
@@ -126,6 +163,12 @@ void PathTraceWorkCPU::render_samples_full_pipeline(KernelGlobalsCPU *kernel_glo
   KernelWorkTile sample_work_tile = work_tile;
   float *render_buffer = buffers_->buffer.data();
 
+  /* Passes stored as half float are accumulated in float over all samples of the pixel rendered
+   * here, and written to the render buffer once at the end. */
+  KernelHalfPassesBlock half_passes_block;
+  film_reset_half_passes_block(&half_passes_block);
+  kernel_globals->half_passes_block = &half_passes_block;
+
   for (int sample = 0; sample < samples_num; ++sample) {
     if (is_cancel_requested()) {
       break;
@@ -159,6 +202,12 @@ void PathTraceWorkCPU::render_samples_full_pipeline(KernelGlobalsCPU *kernel_glo
 
     ++sample_work_tile.start_sample;
   }
+
+  if (half_passes_block.num_samples) {
+    film_fold_half_passes_block(
+        kernel_globals, film_pass_pixel_render_buffer(kernel_globals, state, render_buffer));
+  }
+  kernel_globals->half_passes_block = nullptr;
 }
 
 void PathTraceWorkCPU::copy_to_display(PathTraceDisplay *display,
@@ -200,12 +249,17 @@ bool PathTraceWorkCPU::copy_render_buffers_from_device()
 
 bool PathTraceWorkCPU::copy_render_buffers_to_device()
 {
+  /* Convergence of pixels is not known for the new buffer content. */
+  adaptive_active_blocks_.valid = false;
+
   buffers_->buffer.copy_to_device();
   return true;
 }
 
 bool PathTraceWorkCPU::zero_render_buffers()
 {
+  adaptive_active_blocks_.valid = false;
+
   buffers_->zero();
   return true;
 }
@@ -259,9 +313,80 @@ int PathTraceWorkCPU::adaptive_sampling_converge_filter_count_active(float thres
     });
   }
 
+  update_adaptive_sampling_active_blocks(num_active_pixels != 0);
+
   return num_active_pixels;
 }
 
+void PathTraceWorkCPU::update_adaptive_sampling_active_blocks(const bool has_active_pixels)
+{
+  const int full_x = effective_buffer_params_.full_x;
+  const int full_y = effective_buffer_params_.full_y;
+  const int width = effective_buffer_params_.width;
+  const int height = effective_buffer_params_.height;
+  const int64_t offset = effective_buffer_params_.offset;
+  const int64_t stride = effective_buffer_params_.stride;
+
+  adaptive_active_blocks_.valid = true;
+  adaptive_active_blocks_.full_x = full_x;
+  adaptive_active_blocks_.full_y = full_y;
+  adaptive_active_blocks_.width = width;
+  adaptive_active_blocks_.height = height;
+  adaptive_active_blocks_.blocks.clear();
+
+  if (!has_active_pixels) {
+    return;
+  }
+
+  const int num_blocks_x = divide_up(width, ADAPTIVE_SAMPLING_BLOCK_SIZE);
+  const int num_blocks_y = divide_up(height, ADAPTIVE_SAMPLING_BLOCK_SIZE);
+
+  /* The filter marks neighbors of active pixels as active, so the convergence flag of the pixels
+   * is only final once the filter is done. */
+  const KernelFilm &kfilm = device_scene_->data.film;
+  const int64_t pass_stride = kfilm.pass_stride;
+  const float *render_buffer = buffers_->buffer.data() + kfilm.pass_adaptive_aux_buffer + 3;
+
+  vector<uint8_t> block_active(num_blocks_x * num_blocks_y, 0);
+
+  tbb::task_arena local_arena = local_tbb_arena_create(device_);
+  local_arena.execute([&]() {
+    parallel_for(0, num_blocks_y, [&](int block_y) {
+      uint8_t *row_block_active = block_active.data() + block_y * num_blocks_x;
+      const int y_begin = block_y * ADAPTIVE_SAMPLING_BLOCK_SIZE;
+      const int y_end = min(y_begin + ADAPTIVE_SAMPLING_BLOCK_SIZE, height);
+
+      for (int y = y_begin; y < y_end; ++y) {
+        const float *aux_w = render_buffer +
+                             (offset + full_x + (full_y + y) * stride) * pass_stride;
+        for (int x = 0; x < width; ++x, aux_w += pass_stride) {
+          if (*aux_w == 0.0f) {
+            row_block_active[x / ADAPTIVE_SAMPLING_BLOCK_SIZE] = 1;
+          }
+        }
+      }
+    });
+  });
+
+  for (int block = 0; block < block_active.size(); ++block) {
+    if (block_active[block]) {
+      adaptive_active_blocks_.blocks.push_back(block);
+    }
+  }
+
+  VLOG_WORK << "Adaptive sampling active blocks: " << adaptive_active_blocks_.blocks.size()
+            << " of " << block_active.size() << ".";
+}
+
+bool PathTraceWorkCPU::has_adaptive_sampling_active_blocks() const
+{
+  return adaptive_active_blocks_.valid &&
+         adaptive_active_blocks_.full_x == effective_buffer_params_.full_x &&
+         adaptive_active_blocks_.full_y == effective_buffer_params_.full_y &&
+         adaptive_active_blocks_.width == effective_buffer_params_.width &&
+         adaptive_active_blocks_.height == effective_buffer_params_.height;
+}
+
 void PathTraceWorkCPU::cryptomatte_postproces()
 {
   const int width = effective_buffer_params_.width;
@@ -73,6 +73,13 @@ class PathTraceWorkCPU : public PathTraceWork {
                                     const KernelWorkTile &work_tile,
                                     const int samples_num);
 
+  /* Gather blocks of pixels which have pixels that did not converge yet, after the adaptive
+   * sampling convergence check and filter. */
+  void update_adaptive_sampling_active_blocks(const bool has_active_pixels);
+
+  /* Check whether the active blocks are known for the current effective buffer. */
+  bool has_adaptive_sampling_active_blocks() const;
+
   /* CPU kernels. */
   const CPUKernels &kernels_;
 
@@ -82,6 +89,19 @@ class PathTraceWorkCPU : public PathTraceWork {
    * accessing it, but some "localization" is required to decouple from kernel globals stored
    * on the device level. */
   vector<CPUKernelThreadGlobals> kernel_thread_globals_;
+
+  /* Blocks of pixels which are to be rendered when adaptive sampling is used.
+   *
+   * Blocks in which all pixels converged are not scheduled at all, so that the cost of rendering
+   * samples scales with the number of active pixels rather than with the image size. Blocks are
+   * indices in the row-major grid of blocks covering the effective buffer the list was gathered
+   * for. */
+  struct {
+    bool valid = false;
+    int full_x = 0, full_y = 0;
+    int width = 0, height = 0;
+    vector<int> blocks;
+  } adaptive_active_blocks_;
 };
 
 CCL_NAMESPACE_END
@@ -3,6 +3,7 @@
 
 #include "integrator/render_scheduler.h"
 
+#include "session/checkpoint.h"
 #include "session/session.h"
 #include "session/tile.h"
 #include "util/log.h"
@@ -100,6 +101,49 @@ double RenderScheduler::get_time_limit() const
   return time_limit_;
 }
 
+void RenderScheduler::set_noise_target(float noise_target)
+{
+  noise_target_ = noise_target;
+}
+
+float RenderScheduler::get_noise_target() const
+{
+  return noise_target_;
+}
+
+double RenderScheduler::estimate_denoise_time() const
+{
+  return denoise_time_per_pixel_ * buffer_params_.width * buffer_params_.height;
+}
+
+void RenderScheduler::set_checkpoint_interval(double checkpoint_interval)
+{
+  checkpoint_interval_ = checkpoint_interval;
+}
+
+void RenderScheduler::get_checkpoint_state(RenderCheckpoint &checkpoint) const
+{
+  checkpoint.num_rendered_samples = state_.num_rendered_samples;
+  checkpoint.sample_offset = sample_offset_;
+  checkpoint.num_samples = num_samples_;
+  checkpoint.adaptive_sampling_threshold = state_.adaptive_sampling_threshold;
+  checkpoint.path_trace_time = path_trace_time_.get_wall();
+}
+
+void RenderScheduler::resume_from_checkpoint(const RenderCheckpoint &checkpoint)
+{
+  DCHECK_EQ(checkpoint.sample_offset, sample_offset_);
+
+  /* Checkpoints are only written at the final resolution. */
+  state_.resolution_divider = pixel_size_;
+
+  state_.num_rendered_samples = checkpoint.num_rendered_samples;
+  state_.adaptive_sampling_threshold = checkpoint.adaptive_sampling_threshold;
+  state_.need_checkpoint_read = true;
+
+  path_trace_time_.add_wall(checkpoint.path_trace_time);
+}
+
 int RenderScheduler::get_rendered_sample() const
 {
   DCHECK_GT(get_num_rendered_samples(), 0);
@@ -154,11 +198,16 @@ void RenderScheduler::reset(const BufferParams &buffer_params, int num_samples,
   state_.full_frame_was_written = false;
 
   state_.path_trace_finished = false;
+  state_.noise_target_reached = false;
+  state_.noise_target_estimated_samples = 0;
 
   state_.start_render_time = 0.0;
   state_.end_render_time = 0.0;
   state_.time_limit_reached = false;
 
+  state_.need_checkpoint_read = false;
+  state_.last_checkpoint_time = 0.0;
+
   state_.occupancy_num_samples = 0;
   state_.occupancy = 1.0f;
 
@@ -171,6 +220,8 @@ void RenderScheduler::reset(const BufferParams &buffer_params, int num_samples,
   adaptive_filter_time_.reset();
   display_update_time_.reset();
   rebalance_time_.reset();
+
+  adaptive_sampling_convergence_.clear();
 }
 
 void RenderScheduler::reset_for_next_tile()
@@ -194,6 +245,7 @@ bool RenderScheduler::render_work_reschedule_on_converge(RenderWork &render_work
 
   bool denoiser_delayed, denoiser_ready_to_display;
   render_work.tile.denoise = work_need_denoise(denoiser_delayed, denoiser_ready_to_display);
+  render_work.tile.denoise_time_budget = work_denoise_time_budget(render_work);
 
   render_work.display.update = work_need_update_display(denoiser_delayed);
   render_work.display.use_denoised_result = denoiser_ready_to_display;
@@ -300,6 +352,8 @@ RenderWork RenderScheduler::get_render_work()
       set_full_frame_render_work(&render_work);
     }
 
+    render_work.tile.denoise_time_budget = work_denoise_time_budget(render_work);
+
     if (!render_work) {
       state_.end_render_time = time_now;
     }
@@ -325,6 +379,9 @@ RenderWork RenderScheduler::get_render_work()
 
   render_work.init_render_buffers = (render_work.path_trace.start_sample == get_start_sample());
 
+  render_work.checkpoint.read = state_.need_checkpoint_read;
+  state_.need_checkpoint_read = false;
+
   /* NOTE: Rebalance scheduler requires current number of samples to not be advanced forward. */
   render_work.rebalance = work_need_rebalance();
 
@@ -341,6 +398,9 @@ RenderWork RenderScheduler::get_render_work()
 
   render_work.tile.write = done();
 
+  /* No need to checkpoint the last samples, the result will be written anyway. */
+  render_work.checkpoint.write = !render_work.tile.write && work_need_checkpoint();
+
   render_work.display.update = work_need_update_display(denoiser_delayed);
   render_work.display.use_denoised_result = denoiser_ready_to_display;
 
@@ -348,6 +408,8 @@ RenderWork RenderScheduler::get_render_work()
     set_postprocess_render_work(&render_work);
   }
 
+  render_work.tile.denoise_time_budget = work_denoise_time_budget(render_work);
+
   update_state_for_render_work(render_work);
 
   return render_work;
@@ -452,7 +514,8 @@ void RenderScheduler::report_work_begin(const RenderWork &render_work)
    * because it might be wrongly 0. Check for whether path tracing is actually happening as it is
    * expected to happen in the first work. */
   if (render_work.resolution_divider == pixel_size_ && render_work.path_trace.num_samples != 0 &&
-      render_work.path_trace.start_sample == get_start_sample()) {
+      (render_work.path_trace.start_sample == get_start_sample() ||
+       render_work.checkpoint.read)) {
     state_.start_render_time = time_dt();
   }
 }
@@ -512,6 +575,71 @@ void RenderScheduler::report_adaptive_filter_time(const RenderWork &render_work,
             << " seconds.";
 }
 
+void RenderScheduler::report_adaptive_filter_active_pixels(const RenderWork &render_work,
+                                                           int num_active_pixels,
+                                                           int num_pixels)
+{
+  AdaptiveSamplingConvergence convergence;
+  convergence.num_samples = get_num_rendered_samples();
+  convergence.time = time_dt() - state_.start_render_time;
+  convergence.threshold = render_work.adaptive_sampling.threshold;
+  convergence.num_active_pixels = num_active_pixels;
+  convergence.num_pixels = num_pixels;
+  adaptive_sampling_convergence_.push_back(convergence);
+
+  VLOG_WORK << "Adaptive sampling active pixels: " << num_active_pixels << " of " << num_pixels
+            << " after " << convergence.num_samples << " samples.";
+
+  if (!is_noise_target_used() || convergence.threshold > noise_target_ || num_pixels == 0) {
+    return;
+  }
+
+  /* Fraction of pixels which are allowed to stay above the noise target. Avoids spending most of
+   * the render time on a few fireflies, which are better handled by the denoiser. */
+  const float noise_target_active_fraction = 0.001f;
+  const float active_fraction = float(num_active_pixels) / num_pixels;
+
+  if (active_fraction <= noise_target_active_fraction) {
+    VLOG_WORK << "Noise target " << noise_target_ << " reached after " << convergence.num_samples
+              << " samples.";
+    state_.noise_target_reached = true;
+    state_.path_trace_finished = true;
+    return;
+  }
+
+  /* Estimate remaining number of samples, assuming the fraction of active pixels falls off as a
+   * power of the number of samples, which follows from the error of the pixels falling off with
+   * the square root of the number of samples. The exponent is fitted to the previous check which
+   * used the same threshold. */
+  const int num_checks = adaptive_sampling_convergence_.size();
+  if (num_checks < 2) {
+    return;
+  }
+
+  const AdaptiveSamplingConvergence &prev = adaptive_sampling_convergence_[num_checks - 2];
+  if (prev.threshold != convergence.threshold || prev.num_samples >= convergence.num_samples ||
+      prev.num_active_pixels <= num_active_pixels) {
+    return;
+  }
+
+  const float prev_active_fraction = float(prev.num_active_pixels) / prev.num_pixels;
+  const float falloff = logf(prev_active_fraction / active_fraction) /
+                        logf(float(convergence.num_samples) / prev.num_samples);
+  const float samples_scale = powf(active_fraction / noise_target_active_fraction, 1.0f / falloff);
+
+  state_.noise_target_estimated_samples = min(
+      int(min(convergence.num_samples * samples_scale, float(INT_MAX))), num_samples_);
+
+  VLOG_WORK << "Estimated " << state_.noise_target_estimated_samples
+            << " samples to reach noise target " << noise_target_ << ".";
+}
+
+const vector<AdaptiveSamplingConvergence> &RenderScheduler::get_adaptive_sampling_convergence()
+    const
+{
+  return adaptive_sampling_convergence_;
+}
+
 void RenderScheduler::report_denoise_time(const RenderWork &render_work, double time)
 {
   denoise_time_.add_wall(time);
@@ -528,6 +656,13 @@ void RenderScheduler::report_denoise_time(const RenderWork &render_work, double
 
   denoise_time_.add_average(final_time_approx);
 
+  if (render_work.resolution_divider == pixel_size_) {
+    const int64_t num_pixels = int64_t(buffer_params_.width) * buffer_params_.height;
+    if (num_pixels) {
+      denoise_time_per_pixel_ = time / num_pixels;
+    }
+  }
+
   VLOG_WORK << "Average denoising time: " << denoise_time_.get_average() << " seconds.";
 }
 
@@ -607,6 +742,38 @@ string RenderScheduler::full_report() const
     result += "  Step: " + to_string(adaptive_sampling_.adaptive_step) + "\n";
     result += "  Min Samples: " + to_string(adaptive_sampling_.min_samples) + "\n";
     result += "  Threshold: " + to_string(adaptive_sampling_.threshold) + "\n";
+    if (is_noise_target_used()) {
+      result += "  Noise Target: " + to_string(noise_target_) + "\n";
+      result += "  Noise Target Reached: " + string_from_bool(state_.noise_target_reached) + "\n";
+      if (!state_.noise_target_reached && state_.noise_target_estimated_samples) {
+        result += "  Noise Target Estimated Samples: " +
+                  to_string(state_.noise_target_estimated_samples) + "\n";
+      }
+    }
+
+    /* Convergence over time, limited to a few evenly spaced checks to keep the report short. */
+    const int num_checks = adaptive_sampling_convergence_.size();
+    if (num_checks) {
+      const int max_report_checks = 10;
+      const int step = divide_up(num_checks, max_report_checks);
+
+      result += "  Convergence:\n";
+      result += string_printf(
+          "    %10s %10s %10s %10s\n", "Samples", "Time", "Threshold", "Active");
+      for (int i = 0; i < num_checks; i += step) {
+        /* Always report the last check, which shows the final convergence. */
+        const int index = (i + step >= num_checks) ? num_checks - 1 : i;
+        const AdaptiveSamplingConvergence &convergence = adaptive_sampling_convergence_[index];
+        const double active = (convergence.num_pixels) ?
+                                  100.0 * convergence.num_active_pixels / convergence.num_pixels :
+                                  0.0;
+        result += string_printf("    %10d %10.3f %10.4f %9.2f%%\n",
+                                convergence.num_samples,
+                                convergence.time,
+                                convergence.threshold,
+                                active);
+      }
+    }
   }
 
   result += "\nDenoiser:\n";
@@ -693,9 +860,10 @@ double RenderScheduler::guess_display_update_interval_in_seconds_for_num_samples
   double update_interval = guess_display_update_interval_in_seconds_for_num_samples_no_limit(
       num_rendered_samples);
 
-  if (time_limit_ != 0.0 && state_.start_render_time != 0.0) {
+  const double time_limit = get_path_trace_time_limit();
+  if (time_limit != 0.0 && state_.start_render_time != 0.0) {
     const double remaining_render_time = max(0.0,
-                                             time_limit_ - (time_dt() - state_.start_render_time));
+                                             time_limit - (time_dt() - state_.start_render_time));
 
     update_interval = min(update_interval, remaining_render_time);
   }
@@ -852,9 +1020,10 @@ int RenderScheduler::get_num_samples_to_path_trace() const
      * When time limit is not used the number of samples per render iteration is either increasing
      * or stays the same, so there is no need to clamp number of samples calculated for occupancy.
      */
-    if (time_limit_ != 0.0 && state_.start_render_time != 0.0) {
+    const double time_limit = get_path_trace_time_limit();
+    if (time_limit != 0.0 && state_.start_render_time != 0.0) {
       const double remaining_render_time = max(
-          0.0, time_limit_ - (time_dt() - state_.start_render_time));
+          0.0, time_limit - (time_dt() - state_.start_render_time));
       const double time_per_sample_average = path_trace_time_.get_average();
       const double predicted_render_time = num_samples_to_occupy * time_per_sample_average;
 
@@ -911,11 +1080,43 @@ bool RenderScheduler::work_need_adaptive_filter() const
 
 float RenderScheduler::work_adaptive_threshold() const
 {
+  /* Pixels which reached the noise target do not need more samples. */
+  const float threshold = is_noise_target_used() ? noise_target_ : adaptive_sampling_.threshold;
+
   if (!use_progressive_noise_floor_) {
-    return adaptive_sampling_.threshold;
+    return threshold;
+  }
+
+  return max(state_.adaptive_sampling_threshold, threshold);
+}
+
+bool RenderScheduler::is_noise_target_used() const
+{
+  return noise_target_ > 0.0f && adaptive_sampling_.use;
+}
+
+double RenderScheduler::get_path_trace_time_limit() const
+{
+  if (time_limit_ == 0.0 || !is_noise_target_used() || !denoiser_params_.use) {
+    return time_limit_;
   }
 
-  return max(state_.adaptive_sampling_threshold, adaptive_sampling_.threshold);
+  /* The time limit is a deadline for the final result, so stop path tracing early enough for the
+   * denoiser to finish in time. At least half of the time is always left for path tracing, to
+   * not be affected too much by a bad estimate. */
+  return max(time_limit_ - estimate_denoise_time(), time_limit_ * 0.5);
+}
+
+double RenderScheduler::work_denoise_time_budget(const RenderWork &render_work) const
+{
+  if (!render_work.tile.denoise || time_limit_ == 0.0 || !is_noise_target_used() ||
+      state_.start_render_time == 0.0) {
+    return 0.0;
+  }
+
+  /* Hand the time remaining until the deadline to the denoiser. When the noise target was
+   * reached early this is more than the time reserved for denoising. */
+  return max(time_limit_ - (time_dt() - state_.start_render_time), 0.0);
 }
 
 bool RenderScheduler::work_need_denoise(bool &delayed, bool &ready_to_display)
@@ -1052,6 +1253,28 @@ bool RenderScheduler::work_need_rebalance()
   return (time_dt() - state_.last_rebalance_time) > kRebalanceIntervalInSeconds;
 }
 
+bool RenderScheduler::work_need_checkpoint()
+{
+  if (checkpoint_interval_ == 0.0 || state_.resolution_divider != pixel_size_) {
+    return false;
+  }
+
+  const double time_now = time_dt();
+
+  if (state_.last_checkpoint_time == 0.0) {
+    /* Start counting the interval from the first work at the final resolution. */
+    state_.last_checkpoint_time = time_now;
+    return false;
+  }
+
+  if (time_now - state_.last_checkpoint_time < checkpoint_interval_) {
+    return false;
+  }
+
+  state_.last_checkpoint_time = time_now;
+  return true;
+}
+
 void RenderScheduler::update_start_resolution_divider()
 {
   if (default_start_resolution_divider_ == 0) {
@@ -1148,7 +1371,9 @@ bool RenderScheduler::work_report_reset_average(const RenderWork &render_work)
 
 void RenderScheduler::check_time_limit_reached()
 {
-  if (time_limit_ == 0.0) {
+  const double time_limit = get_path_trace_time_limit();
+
+  if (time_limit == 0.0) {
     /* No limit is enforced. */
     return;
   }
@@ -1160,7 +1385,7 @@ void RenderScheduler::check_time_limit_reached()
 
   const double current_time = time_dt();
 
-  if (current_time - state_.start_render_time < time_limit_) {
+  if (current_time - state_.start_render_time < time_limit) {
     /* Time limit is not reached yet. */
     return;
   }
@@ -7,9 +7,11 @@
 #include "integrator/denoiser.h" /* For DenoiseParams. */
 #include "session/buffers.h"
 #include "util/string.h"
+#include "util/vector.h"
 
 CCL_NAMESPACE_BEGIN
 
+class RenderCheckpoint;
 class SessionParams;
 class TileManager;
 
@@ -52,6 +54,10 @@ class RenderWork {
     bool write = false;
 
     bool denoise = false;
+
+    /* Time in seconds which is left for denoising before the render deadline is reached.
+     * Zero means the denoising time is not constrained. */
+    double denoise_time_budget = 0.0;
   } tile;
 
   /* Work related on the full-frame render buffer. */
@@ -61,6 +67,15 @@ class RenderWork {
     bool write = false;
   } full;
 
+  /* Work related on the render checkpoint. */
+  struct {
+    /* Initialize render buffers from the checkpoint which the scheduler has been resumed from. */
+    bool read = false;
+
+    /* Write render buffers and scheduler state to the checkpoint file. */
+    bool write = false;
+  } checkpoint;
+
   /* Display which is used to visualize render result. */
   struct {
     /* Display needs to be updated for the new render. */
@@ -121,6 +136,32 @@ class RenderScheduler {
   void set_time_limit(double time_limit);
   double get_time_limit() const;
 
+  /* Target noise level of the render, using the same metric as the adaptive sampling threshold.
+   * Zero disables the target.
+   *
+   * The render is finished when nearly all pixels reached the noise target or when the time
+   * limit is reached, whichever comes first. When both are used the time limit is treated as a
+   * deadline for the final result, and time is reserved for denoising within it. Only has effect
+   * when adaptive sampling is used, since the noise level is measured by its convergence check. */
+  void set_noise_target(float noise_target);
+  float get_noise_target() const;
+
+  /* Estimate of how long it takes to denoise the render buffer, based on previous denoising.
+   * Returns zero if there is no estimate available. */
+  double estimate_denoise_time() const;
+
+  /* Interval in seconds between render checkpoints of the path tracing progress.
+   * Zero disables checkpoints. */
+  void set_checkpoint_interval(double checkpoint_interval);
+
+  /* Fill in the scheduler state which is to be stored in a render checkpoint. */
+  void get_checkpoint_state(RenderCheckpoint &checkpoint) const;
+
+  /* Continue rendering from the state stored in the checkpoint.
+   * Is to be called after `reset()`. The next render work will read the render buffers from the
+   * checkpoint and continue path tracing from the first sample which is not in the checkpoint. */
+  void resume_from_checkpoint(const RenderCheckpoint &checkpoint);
+
   /* Get sample up to which rendering has been done.
    * This is an absolute 0-based value.
    *
@@ -179,6 +220,9 @@ class RenderScheduler {
   void report_path_trace_time(const RenderWork &render_work, double time, bool is_cancelled);
   void report_path_trace_occupancy(const RenderWork &render_work, float occupancy);
   void report_adaptive_filter_time(const RenderWork &render_work, double time, bool is_cancelled);
+  void report_adaptive_filter_active_pixels(const RenderWork &render_work,
+                                            int num_active_pixels,
+                                            int num_pixels);
   void report_denoise_time(const RenderWork &render_work, double time);
   void report_display_update_time(const RenderWork &render_work, double time);
   void report_rebalance_time(const RenderWork &render_work, double time, bool balance_changed);
@@ -187,6 +231,10 @@ class RenderScheduler {
    * times, and so on. */
   string full_report() const;
 
+  /* Convergence of adaptive sampling over time, one entry per convergence check of the current
+   * render. */
+  const vector<AdaptiveSamplingConvergence> &get_adaptive_sampling_convergence() const;
+
   void set_limit_samples_per_update(const int limit_samples);
 
  protected:
@@ -246,6 +294,15 @@ class RenderScheduler {
   /* Calculate threshold for adaptive sampling. */
   float work_adaptive_threshold() const;
 
+  /* Whether rendering towards the noise target is used. */
+  bool is_noise_target_used() const;
+
+  /* Time limit for path tracing, with the time reserved for denoising taken into account. */
+  double get_path_trace_time_limit() const;
+
+  /* Time which is available for denoising of the given work. */
+  double work_denoise_time_budget(const RenderWork &render_work) const;
+
   /* Check whether current work needs denoising.
    * Denoising is not needed if the denoiser is not configured, or when denoising is happening too
    * often.
@@ -265,6 +322,9 @@ class RenderScheduler {
   /* Check whether it is time to perform rebalancing for the render work, */
   bool work_need_rebalance();
 
+  /* Check whether it is time to write render checkpoint after the path tracing of the work. */
+  bool work_need_checkpoint();
+
   /* Check whether timing of the given work are usable to store timings in the `first_render_time_`
    * for the resolution divider calculation. */
   bool work_is_usable_for_first_render_estimation(const RenderWork &render_work);
@@ -371,6 +431,19 @@ class RenderScheduler {
     bool path_trace_finished = false;
     bool time_limit_reached = false;
 
+    /* Nearly all pixels reached the noise target. */
+    bool noise_target_reached = false;
+
+    /* Number of samples estimated to be needed to reach the noise target, extrapolated from the
+     * convergence of the previous checks. Zero when there is no estimate yet. */
+    int noise_target_estimated_samples = 0;
+
+    /* Render buffers are to be read from the checkpoint with the next work. */
+    bool need_checkpoint_read = false;
+
+    /* Point in time at which the last checkpoint has been written, or rendering has started. */
+    double last_checkpoint_time = 0.0;
+
     /* Time at which rendering started and finished. */
     double start_render_time = 0.0;
     double end_render_time = 0.0;
@@ -398,6 +471,8 @@ class RenderScheduler {
   TimeWithAverage display_update_time_;
   TimeWithAverage rebalance_time_;
 
+  vector<AdaptiveSamplingConvergence> adaptive_sampling_convergence_;
+
   /* Whether cryptomatte-related work will be scheduled. */
   bool need_schedule_cryptomatte_ = false;
 
@@ -418,6 +493,16 @@ class RenderScheduler {
    * Zero means no limit is applied. */
   double time_limit_ = 0.0;
 
+  /* Target noise level of the render. Zero means no target is used. */
+  float noise_target_ = 0.0f;
+
+  /* Measured time it takes to denoise a single pixel. Kept across resets so that the estimate is
+   * available for the consecutive renders. */
+  double denoise_time_per_pixel_ = 0.0;
+
+  /* Interval in seconds between render checkpoints. Zero means no checkpoints are written. */
+  double checkpoint_interval_ = 0.0;
+
   /* Headless rendering without interface. */
   bool headless_;
 
@@ -20,6 +20,10 @@ ShaderEval::ShaderEval(Device *device, Progress &progress) : device_(device), pr
   DCHECK_NE(device_, nullptr);
 }
 
+ShaderEval::~ShaderEval()
+{
+}
+
 bool ShaderEval::eval(const ShaderEvalType type,
                       const int max_num_inputs,
                       const int num_channels,
@@ -37,21 +41,30 @@ bool ShaderEval::eval(const ShaderEvalType type,
     }
     first_device = false;
 
-    device_vector<KernelShaderEvalInput> input(device, "ShaderEval input", MEM_READ_ONLY);
-    device_vector<float> output(device, "ShaderEval output", MEM_READ_WRITE);
+    if (!input_) {
+      input_ = make_unique<device_vector<KernelShaderEvalInput>>(
+          device, "ShaderEval input", MEM_READ_ONLY);
+      output_ = make_unique<device_vector<float>>(device, "ShaderEval output", MEM_READ_WRITE);
+    }
+
+    device_vector<KernelShaderEvalInput> &input = *input_;
+    device_vector<float> &output = *output_;
 
-    /* Allocate and copy device buffers. */
+    /* Allocate and copy device buffers. The input buffer only grows, so that evaluating many
+     * smaller meshes in a row does not reallocate it every time. Only the filled part of it is
+     * copied. */
     DCHECK_EQ(input.device, device);
     DCHECK_EQ(output.device, device);
-    DCHECK_LE(output.size(), input.size());
 
-    input.alloc(max_num_inputs);
+    if (input.size() < max_num_inputs) {
+      input.alloc(max_num_inputs);
+    }
     int num_points = fill_input(input);
     if (num_points == 0) {
       return;
     }
 
-    input.copy_to_device();
+    input.copy_to_device(num_points);
     output.alloc(num_points * num_channels);
     output.zero_to_device();
 
@@ -65,9 +78,6 @@ bool ShaderEval::eval(const ShaderEvalType type,
       output.copy_from_device(0, 1, output.size());
       read_output(output);
     }
-
-    input.free();
-    output.free();
   });
 
   return success;
@@ -79,41 +89,50 @@ bool ShaderEval::eval_cpu(Device *device,
                           device_vector<float> &output,
                           const int64_t work_size)
 {
-  vector<CPUKernelThreadGlobals> kernel_thread_globals;
-  device->get_cpu_kernel_thread_globals(kernel_thread_globals);
+  if (!kernel_thread_globals_) {
+    kernel_thread_globals_ = make_unique<vector<CPUKernelThreadGlobals>>();
+    device->get_cpu_kernel_thread_globals(*kernel_thread_globals_);
+  }
+  const vector<CPUKernelThreadGlobals> &kernel_thread_globals = *kernel_thread_globals_;
 
   /* Find required kernel function. */
   const CPUKernels &kernels = Device::get_cpu_kernels();
 
-  /* Simple parallel_for over all work items. */
+  /* Parallel for over blocks of work items, so that cancellation checks and thread globals
+   * lookup are done once per block rather than for every item. */
+  const int64_t block_size = 256;
   KernelShaderEvalInput *input_data = input.data();
   float *output_data = output.data();
   bool success = true;
 
   tbb::task_arena local_arena(device->info.cpu_threads);
   local_arena.execute([&]() {
-    parallel_for(int64_t(0), work_size, [&](int64_t work_index) {
-      /* TODO: is this fast enough? */
-      if (progress_.get_cancel()) {
-        success = false;
-        return;
-      }
-
-      const int thread_index = tbb::this_task_arena::current_thread_index();
-      const KernelGlobalsCPU *kg = &kernel_thread_globals[thread_index];
-
-      switch (type) {
-        case SHADER_EVAL_DISPLACE:
-          kernels.shader_eval_displace(kg, input_data, output_data, work_index);
-          break;
-        case SHADER_EVAL_BACKGROUND:
-          kernels.shader_eval_background(kg, input_data, output_data, work_index);
-          break;
-        case SHADER_EVAL_CURVE_SHADOW_TRANSPARENCY:
-          kernels.shader_eval_curve_shadow_transparency(kg, input_data, output_data, work_index);
-          break;
-      }
-    });
+    parallel_for(blocked_range<int64_t>(0, work_size, block_size),
+                 [&](const blocked_range<int64_t> &range) {
+                   if (progress_.get_cancel()) {
+                     success = false;
+                     return;
+                   }
+
+                   const int thread_index = tbb::this_task_arena::current_thread_index();
+                   const KernelGlobalsCPU *kg = &kernel_thread_globals[thread_index];
+
+                   for (int64_t work_index = range.begin(); work_index < range.end();
+                        work_index++) {
+                     switch (type) {
+                       case SHADER_EVAL_DISPLACE:
+                         kernels.shader_eval_displace(kg, input_data, output_data, work_index);
+                         break;
+                       case SHADER_EVAL_BACKGROUND:
+                         kernels.shader_eval_background(kg, input_data, output_data, work_index);
+                         break;
+                       case SHADER_EVAL_CURVE_SHADOW_TRANSPARENCY:
+                         kernels.shader_eval_curve_shadow_transparency(
+                             kg, input_data, output_data, work_index);
+                         break;
+                     }
+                   }
+                 });
   });
 
   return success;
@@ -140,7 +159,10 @@ bool ShaderEval::eval_gpu(Device *device,
   };
 
   /* Create device queue. */
-  unique_ptr<DeviceQueue> queue = device->gpu_queue_create();
+  if (!queue_) {
+    queue_ = device->gpu_queue_create();
+  }
+  DeviceQueue *queue = queue_.get();
   queue->init_execution();
 
   /* Execute work on GPU in chunk, so we can cancel.
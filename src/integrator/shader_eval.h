@@ -8,10 +8,14 @@
 #include "kernel/types.h"
 
 #include "util/function.h"
+#include "util/unique_ptr.h"
+#include "util/vector.h"
 
 CCL_NAMESPACE_BEGIN
 
+class CPUKernelThreadGlobals;
 class Device;
+class DeviceQueue;
 class Progress;
 
 enum ShaderEvalType {
@@ -20,10 +24,15 @@ enum ShaderEvalType {
   SHADER_EVAL_CURVE_SHADOW_TRANSPARENCY,
 };
 
-/* ShaderEval class performs shader evaluation for background light and displacement. */
+/* ShaderEval class performs shader evaluation for background light and displacement.
+ *
+ * Device buffers, the GPU queue and CPU thread globals are kept between evaluations, so a single
+ * ShaderEval can be used to evaluate many meshes or images in a row. Kernel data must not change
+ * while it is alive, since the CPU thread globals are a copy of the device kernel globals. */
 class ShaderEval {
  public:
   ShaderEval(Device *device, Progress &progress);
+  ~ShaderEval();
 
   /* Evaluate shader at points specified by KernelShaderEvalInput and write out
    * RGBA colors to output. */
@@ -47,6 +56,12 @@ class ShaderEval {
 
   Device *device_;
   Progress &progress_;
+
+  /* Reused between evaluations, created for the device that evaluates. */
+  unique_ptr<device_vector<KernelShaderEvalInput>> input_;
+  unique_ptr<device_vector<float>> output_;
+  unique_ptr<DeviceQueue> queue_;
+  unique_ptr<vector<CPUKernelThreadGlobals>> kernel_thread_globals_;
 };
 
 CCL_NAMESPACE_END
@@ -15,24 +15,19 @@ ccl_device_forceinline Transform bvh_unaligned_node_fetch_space(KernelGlobals kg
   return space;
 }
 
-ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals kg,
-                                                      const float3 P,
-                                                      const float3 idir,
-                                                      const float tmin,
-                                                      const float tmax,
-                                                      const int node_addr,
-                                                      const uint visibility,
-                                                      float dist[2])
+/* Intersect ray against both children of an aligned node, with bounds stored as
+ * (c0min, c1min, c0max, c1max) per axis. */
+ccl_device_forceinline int bvh_aligned_node_intersect_bounds(const float3 P,
+                                                             const float3 idir,
+                                                             const float tmin,
+                                                             const float tmax,
+                                                             const float4 node0,
+                                                             const float4 node1,
+                                                             const float4 node2,
+                                                             const float4 cnodes,
+                                                             const uint visibility,
+                                                             float dist[2])
 {
-
-  /* fetch node data */
-#ifdef __VISIBILITY_FLAG__
-  float4 cnodes = kernel_data_fetch(bvh_nodes, node_addr + 0);
-#endif
-  float4 node0 = kernel_data_fetch(bvh_nodes, node_addr + 1);
-  float4 node1 = kernel_data_fetch(bvh_nodes, node_addr + 2);
-  float4 node2 = kernel_data_fetch(bvh_nodes, node_addr + 3);
-
   /* intersect ray against child nodes */
   float c0lox = (node0.x - P.x) * idir.x;
   float c0hix = (node0.z - P.x) * idir.x;
@@ -64,6 +59,69 @@ ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals kg,
 #endif
 }
 
+/* Decode one axis of a quantized node: 8 bit plane offsets for both children,
+ * relative to the parent bounds origin, in units of a power of two scale. */
+ccl_device_forceinline float4 bvh_quantized_node_decode_axis(const float origin,
+                                                             const uint exponent,
+                                                             const uint planes)
+{
+  const float scale = __uint_as_float(exponent << 23);
+  return make_float4(origin + (float)(planes & 0xff) * scale,
+                     origin + (float)((planes >> 8) & 0xff) * scale,
+                     origin + (float)((planes >> 16) & 0xff) * scale,
+                     origin + (float)(planes >> 24) * scale);
+}
+
+ccl_device_forceinline int bvh_quantized_node_intersect(KernelGlobals kg,
+                                                        const float3 P,
+                                                        const float3 idir,
+                                                        const float tmin,
+                                                        const float tmax,
+                                                        const int node_addr,
+                                                        const float4 cnodes,
+                                                        const uint visibility,
+                                                        float dist[2])
+{
+  /* fetch node data */
+  const float4 origin = kernel_data_fetch(bvh_nodes, node_addr + 1);
+  const float4 planes = kernel_data_fetch(bvh_nodes, node_addr + 2);
+  const uint exponents = __float_as_uint(origin.w);
+
+  const float4 node0 = bvh_quantized_node_decode_axis(
+      origin.x, exponents & 0xff, __float_as_uint(planes.x));
+  const float4 node1 = bvh_quantized_node_decode_axis(
+      origin.y, (exponents >> 8) & 0xff, __float_as_uint(planes.y));
+  const float4 node2 = bvh_quantized_node_decode_axis(
+      origin.z, (exponents >> 16) & 0xff, __float_as_uint(planes.z));
+
+  return bvh_aligned_node_intersect_bounds(
+      P, idir, tmin, tmax, node0, node1, node2, cnodes, visibility, dist);
+}
+
+ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals kg,
+                                                      const float3 P,
+                                                      const float3 idir,
+                                                      const float tmin,
+                                                      const float tmax,
+                                                      const int node_addr,
+                                                      const uint visibility,
+                                                      float dist[2])
+{
+  /* fetch node data */
+  float4 cnodes = kernel_data_fetch(bvh_nodes, node_addr + 0);
+  if (__float_as_uint(cnodes.x) & PATH_RAY_NODE_QUANTIZED) {
+    return bvh_quantized_node_intersect(
+        kg, P, idir, tmin, tmax, node_addr, cnodes, visibility, dist);
+  }
+
+  float4 node0 = kernel_data_fetch(bvh_nodes, node_addr + 1);
+  float4 node1 = kernel_data_fetch(bvh_nodes, node_addr + 2);
+  float4 node2 = kernel_data_fetch(bvh_nodes, node_addr + 3);
+
+  return bvh_aligned_node_intersect_bounds(
+      P, idir, tmin, tmax, node0, node1, node2, cnodes, visibility, dist);
+}
+
 ccl_device_forceinline bool bvh_unaligned_node_intersect_child(KernelGlobals kg,
                                                                const float3 P,
                                                                const float3 dir,
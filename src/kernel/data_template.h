@@ -119,6 +119,8 @@ KERNEL_STRUCT_MEMBER(film, float, mist_falloff)
 KERNEL_STRUCT_MEMBER(film, int, pass_denoising_normal)
 KERNEL_STRUCT_MEMBER(film, int, pass_denoising_albedo)
 KERNEL_STRUCT_MEMBER(film, int, pass_denoising_depth)
+/* Passes which support it are stored in half float. */
+KERNEL_STRUCT_MEMBER(film, int, use_half_passes)
 /* AOVs. */
 KERNEL_STRUCT_MEMBER(film, int, pass_aov_color)
 KERNEL_STRUCT_MEMBER(film, int, pass_aov_value)
@@ -0,0 +1,270 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+/* Vectorized conversion of render buffer passes to display or output pixels.
+ *
+ * Converts 4 consecutive pixels at once for the passes which are the most commonly read: combined,
+ * depth and the float3 passes such as normal and albedo. The pixels are processed in SoA form,
+ * where every float4 holds one channel of 4 pixels. The operations match the scalar
+ * `film_get_pass_pixel_*()` functions, so the result is bit-wise identical to them. */
+
+#pragma once
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __KERNEL_SSE__
+
+#  define FILM_CONVERT_SIMD_WIDTH 4
+
+/* --------------------------------------------------------------------
+ * Common utilities.
+ */
+
+ccl_device_inline void film_transpose_simd(ccl_private float4 *ccl_restrict channels)
+{
+  _MM_TRANSPOSE4_PS(channels[0].m128, channels[1].m128, channels[2].m128, channels[3].m128);
+}
+
+ccl_device_inline float4 film_read_pass_float_simd(ccl_global const float *ccl_restrict in,
+                                                   const int buffer_stride)
+{
+  return make_float4(in[0], in[buffer_stride], in[2 * buffer_stride], in[3 * buffer_stride]);
+}
+
+ccl_device_inline int4 film_read_sample_count_simd(ccl_global const KernelFilmConvert
+                                                       *ccl_restrict kfilm_convert,
+                                                   ccl_global const float *ccl_restrict buffer,
+                                                   const int buffer_stride)
+{
+  ccl_global const float *in = buffer + kfilm_convert->pass_sample_count;
+  return make_int4(__float_as_int(in[0]),
+                   __float_as_int(in[buffer_stride]),
+                   __float_as_int(in[2 * buffer_stride]),
+                   __float_as_int(in[3 * buffer_stride]));
+}
+
+/* Same as film_get_scale_exposure(). */
+ccl_device_inline float4 film_get_scale_exposure_simd(ccl_global const KernelFilmConvert
+                                                          *ccl_restrict kfilm_convert,
+                                                      ccl_global const float *ccl_restrict buffer,
+                                                      const int buffer_stride)
+{
+  if (kfilm_convert->pass_sample_count == PASS_UNUSED) {
+    return make_float4(kfilm_convert->scale_exposure);
+  }
+
+  float4 scale = one_float4();
+  if (kfilm_convert->pass_use_filter) {
+    const int4 sample_count = film_read_sample_count_simd(kfilm_convert, buffer, buffer_stride);
+    scale = one_float4() / make_float4(sample_count);
+  }
+
+  if (kfilm_convert->pass_use_exposure) {
+    return scale * kfilm_convert->exposure;
+  }
+
+  return scale;
+}
+
+/* Same as film_get_scale_and_scale_exposure(), with the scales of pixels without samples set to
+ * zero. Returns mask of the pixels which have no samples. */
+ccl_device_inline int4
+film_get_scale_and_scale_exposure_simd(ccl_global const KernelFilmConvert *ccl_restrict
+                                           kfilm_convert,
+                                       ccl_global const float *ccl_restrict buffer,
+                                       const int buffer_stride,
+                                       ccl_private float4 *ccl_restrict scale,
+                                       ccl_private float4 *ccl_restrict scale_exposure)
+{
+  if (kfilm_convert->pass_sample_count == PASS_UNUSED) {
+    *scale = make_float4(kfilm_convert->scale);
+    *scale_exposure = make_float4(kfilm_convert->scale_exposure);
+    return make_int4(0);
+  }
+
+  const int4 sample_count = film_read_sample_count_simd(kfilm_convert, buffer, buffer_stride);
+  const int4 no_samples = int4(_mm_cmpeq_epi32(sample_count, _mm_setzero_si128()));
+
+  if (kfilm_convert->pass_use_filter) {
+    *scale = one_float4() / make_float4(sample_count);
+  }
+  else {
+    *scale = one_float4();
+  }
+
+  if (kfilm_convert->pass_use_exposure) {
+    *scale_exposure = *scale * kfilm_convert->exposure;
+  }
+  else {
+    *scale_exposure = *scale;
+  }
+
+  *scale = select(no_samples, zero_float4(), *scale);
+  *scale_exposure = select(no_samples, zero_float4(), *scale_exposure);
+
+  return no_samples;
+}
+
+/* --------------------------------------------------------------------
+ * Passes.
+ *
+ * Every pass has a function which checks whether the vectorized conversion supports the pass
+ * configuration, and a function which fills in channels of 4 pixels and returns the number of
+ * channels written, matching the number of components written by the scalar function.
+ */
+
+ccl_device_inline bool film_pass_simd_supported_depth(ccl_global const KernelFilmConvert
+                                                          *ccl_restrict /*kfilm_convert*/)
+{
+  return true;
+}
+
+ccl_device_inline int film_get_pass_pixels_simd_depth(ccl_global const KernelFilmConvert
+                                                          *ccl_restrict kfilm_convert,
+                                                      ccl_global const float *ccl_restrict buffer,
+                                                      const int buffer_stride,
+                                                      ccl_private float4 *ccl_restrict channels)
+{
+  const float4 scale_exposure = film_get_scale_exposure_simd(
+      kfilm_convert, buffer, buffer_stride);
+
+  const float4 f = film_read_pass_float_simd(buffer + kfilm_convert->pass_offset, buffer_stride);
+  const int4 is_zero = int4(_mm_castps_si128(_mm_cmpeq_ps(f, _mm_setzero_ps())));
+
+  channels[0] = select(is_zero, make_float4(1e10f), f * scale_exposure);
+
+  return 1;
+}
+
+ccl_device_inline bool film_pass_simd_supported_float3(ccl_global const KernelFilmConvert
+                                                           *ccl_restrict kfilm_convert)
+{
+  /* Packed half float storage is read by the scalar code. */
+  return !kfilm_convert->pass_use_half;
+}
+
+ccl_device_inline int film_get_pass_pixels_simd_float3(ccl_global const KernelFilmConvert
+                                                           *ccl_restrict kfilm_convert,
+                                                       ccl_global const float *ccl_restrict buffer,
+                                                       const int buffer_stride,
+                                                       ccl_private float4 *ccl_restrict channels)
+{
+  const float4 scale_exposure = film_get_scale_exposure_simd(
+      kfilm_convert, buffer, buffer_stride);
+
+  ccl_global const float *in = buffer + kfilm_convert->pass_offset;
+
+  channels[0] = film_read_pass_float_simd(in, buffer_stride) * scale_exposure;
+  channels[1] = film_read_pass_float_simd(in + 1, buffer_stride) * scale_exposure;
+  channels[2] = film_read_pass_float_simd(in + 2, buffer_stride) * scale_exposure;
+
+  /* Optional alpha channel. */
+  if (kfilm_convert->num_components < 4) {
+    return 3;
+  }
+
+  if (kfilm_convert->pass_combined != PASS_UNUSED) {
+    float4 scale, combined_scale_exposure;
+    film_get_scale_and_scale_exposure_simd(
+        kfilm_convert, buffer, buffer_stride, &scale, &combined_scale_exposure);
+
+    const float4 transparency = film_read_pass_float_simd(
+                                    buffer + kfilm_convert->pass_combined + 3, buffer_stride) *
+                                scale;
+    channels[3] = clamp(one_float4() - transparency, zero_float4(), one_float4());
+  }
+  else {
+    channels[3] = one_float4();
+  }
+
+  return 4;
+}
+
+ccl_device_inline bool film_pass_simd_supported_combined(ccl_global const KernelFilmConvert
+                                                             *ccl_restrict /*kfilm_convert*/)
+{
+  return true;
+}
+
+ccl_device_inline int film_get_pass_pixels_simd_combined(
+    ccl_global const KernelFilmConvert *ccl_restrict kfilm_convert,
+    ccl_global const float *ccl_restrict buffer,
+    const int buffer_stride,
+    ccl_private float4 *ccl_restrict channels)
+{
+  float4 scale, scale_exposure;
+  const int4 no_samples = film_get_scale_and_scale_exposure_simd(
+      kfilm_convert, buffer, buffer_stride, &scale, &scale_exposure);
+
+  /* The combined pass has 4 components, so it is safe to load all of them at once. */
+  ccl_global const float *in = buffer + kfilm_convert->pass_offset;
+  channels[0] = load_float4(in);
+  channels[1] = load_float4(in + buffer_stride);
+  channels[2] = load_float4(in + 2 * buffer_stride);
+  channels[3] = load_float4(in + 3 * buffer_stride);
+  film_transpose_simd(channels);
+
+  /* 3rd channel contains transparency = 1 - alpha for the combined pass. */
+  channels[0] = select(no_samples, zero_float4(), channels[0] * scale_exposure);
+  channels[1] = select(no_samples, zero_float4(), channels[1] * scale_exposure);
+  channels[2] = select(no_samples, zero_float4(), channels[2] * scale_exposure);
+  channels[3] = select(no_samples,
+                       zero_float4(),
+                       clamp(one_float4() - channels[3] * scale, zero_float4(), one_float4()));
+
+  return 4;
+}
+
+/* --------------------------------------------------------------------
+ * Destination.
+ */
+
+/* Write channels of 4 pixels to the float destination. */
+ccl_device_inline void film_write_pixels_simd(ccl_global const KernelFilmConvert
+                                                  *ccl_restrict kfilm_convert,
+                                              ccl_private float4 *ccl_restrict channels,
+                                              const int num_channels,
+                                              ccl_global float *ccl_restrict pixel,
+                                              const int pixel_stride)
+{
+  const int num_components = min(num_channels, kfilm_convert->num_components);
+
+  if (num_components == 4 && pixel_stride == 4) {
+    film_transpose_simd(channels);
+    for (int i = 0; i < FILM_CONVERT_SIMD_WIDTH; i++) {
+      _mm_storeu_ps(pixel + i * 4, channels[i].m128);
+    }
+    return;
+  }
+
+  for (int i = 0; i < FILM_CONVERT_SIMD_WIDTH; i++) {
+    for (int c = 0; c < num_components; c++) {
+      pixel[i * pixel_stride + c] = channels[c][i];
+    }
+  }
+}
+
+/* Write channels of 4 pixels to the half RGBA destination, applying the overlays. */
+ccl_device_inline void film_write_pixels_half_rgba_simd(ccl_global const KernelFilmConvert
+                                                            *ccl_restrict kfilm_convert,
+                                                        ccl_global const float *ccl_restrict
+                                                            buffer,
+                                                        const int buffer_stride,
+                                                        ccl_private float4 *ccl_restrict channels,
+                                                        ccl_global half4 *ccl_restrict pixel)
+{
+  film_transpose_simd(channels);
+
+  for (int i = 0; i < FILM_CONVERT_SIMD_WIDTH; i++) {
+    if (kfilm_convert->show_active_pixels) {
+      float pixel_rgba[4] = {channels[i].x, channels[i].y, channels[i].z, channels[i].w};
+      film_apply_pass_pixel_overlays_rgba(kfilm_convert, buffer + i * buffer_stride, pixel_rgba);
+      channels[i] = make_float4(pixel_rgba[0], pixel_rgba[1], pixel_rgba[2], pixel_rgba[3]);
+    }
+    pixel[i] = float4_to_half4_display(channels[i]);
+  }
+}
+
+#endif /* __KERNEL_SSE__ */
+
+CCL_NAMESPACE_END
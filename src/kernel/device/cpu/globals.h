@@ -36,6 +36,17 @@ template<typename T> struct kernel_array {
   int width;
 };
 
+/* Sums of the contributions to the passes stored as half float over a block of consecutive
+ * samples of one pixel, see film_fold_half_passes_block(). */
+typedef struct KernelHalfPassesBlock {
+  int first_sample;
+  int num_samples;
+
+  float3 normal;
+  float3 denoising_normal;
+  float3 denoising_albedo;
+} KernelHalfPassesBlock;
+
 typedef struct KernelGlobalsCPU {
 #define KERNEL_DATA_ARRAY(type, name) kernel_array<type> name;
 #include "kernel/data_arrays.h"
@@ -63,6 +74,9 @@ typedef struct KernelGlobalsCPU {
 
   /* **** Run-time data ****  */
 
+  /* Block of samples of the pixel which is being rendered by the thread. */
+  KernelHalfPassesBlock *half_passes_block = nullptr;
+
   ProfilingState profiler;
 } KernelGlobalsCPU;
 
@@ -37,6 +37,8 @@
 #    include "kernel/film/cryptomatte_passes.h"
 #    include "kernel/film/read.h"
 
+#    include "kernel/device/cpu/film.h"
+
 #    include "kernel/bake/bake.h"
 
 #else
@@ -281,22 +283,91 @@ void KERNEL_FUNCTION_FULL_NAME(cryptomatte_postprocess)(const KernelGlobalsCPU *
 
 #endif
 
-KERNEL_FILM_CONVERT_FUNCTION(depth, true)
+/* Passes which are the most commonly read are converted 4 pixels at a time, with the remaining
+ * pixels of the row converted by the scalar code. */
+#if !defined(KERNEL_STUB) && defined(__KERNEL_SSE__)
+
+#  define KERNEL_FILM_CONVERT_SIMD_FUNCTION(name, is_float) \
+    void KERNEL_FUNCTION_FULL_NAME(film_convert_##name)(const KernelFilmConvert *kfilm_convert, \
+                                                        const float *buffer, \
+                                                        float *pixel, \
+                                                        const int width, \
+                                                        const int buffer_stride, \
+                                                        const int pixel_stride) \
+    { \
+      int i = 0; \
+      if (film_pass_simd_supported_##name(kfilm_convert)) { \
+        for (; i + FILM_CONVERT_SIMD_WIDTH <= width; i += FILM_CONVERT_SIMD_WIDTH) { \
+          float4 channels[4]; \
+          const int num_channels = film_get_pass_pixels_simd_##name( \
+              kfilm_convert, buffer, buffer_stride, channels); \
+          film_write_pixels_simd(kfilm_convert, channels, num_channels, pixel, pixel_stride); \
+          buffer += FILM_CONVERT_SIMD_WIDTH * buffer_stride; \
+          pixel += FILM_CONVERT_SIMD_WIDTH * pixel_stride; \
+        } \
+      } \
+      for (; i < width; i++, buffer += buffer_stride, pixel += pixel_stride) { \
+        film_get_pass_pixel_##name(kfilm_convert, buffer, pixel); \
+      } \
+    } \
+    void KERNEL_FUNCTION_FULL_NAME(film_convert_half_rgba_##name)( \
+        const KernelFilmConvert *kfilm_convert, \
+        const float *buffer, \
+        half4 *pixel, \
+        const int width, \
+        const int buffer_stride) \
+    { \
+      int i = 0; \
+      if (film_pass_simd_supported_##name(kfilm_convert)) { \
+        for (; i + FILM_CONVERT_SIMD_WIDTH <= width; i += FILM_CONVERT_SIMD_WIDTH) { \
+          float4 channels[4] = {zero_float4(), zero_float4(), zero_float4(), one_float4()}; \
+          film_get_pass_pixels_simd_##name(kfilm_convert, buffer, buffer_stride, channels); \
+          if (is_float) { \
+            channels[1] = channels[0]; \
+            channels[2] = channels[0]; \
+          } \
+          film_write_pixels_half_rgba_simd( \
+              kfilm_convert, buffer, buffer_stride, channels, pixel); \
+          buffer += FILM_CONVERT_SIMD_WIDTH * buffer_stride; \
+          pixel += FILM_CONVERT_SIMD_WIDTH; \
+        } \
+      } \
+      for (; i < width; i++, buffer += buffer_stride, pixel++) { \
+        float pixel_rgba[4] = {0.0f, 0.0f, 0.0f, 1.0f}; \
+        film_get_pass_pixel_##name(kfilm_convert, buffer, pixel_rgba); \
+        if (is_float) { \
+          pixel_rgba[1] = pixel_rgba[0]; \
+          pixel_rgba[2] = pixel_rgba[0]; \
+        } \
+        film_apply_pass_pixel_overlays_rgba(kfilm_convert, buffer, pixel_rgba); \
+        *pixel = float4_to_half4_display( \
+            make_float4(pixel_rgba[0], pixel_rgba[1], pixel_rgba[2], pixel_rgba[3])); \
+      } \
+    }
+
+#else
+
+#  define KERNEL_FILM_CONVERT_SIMD_FUNCTION KERNEL_FILM_CONVERT_FUNCTION
+
+#endif
+
+KERNEL_FILM_CONVERT_SIMD_FUNCTION(depth, true)
 KERNEL_FILM_CONVERT_FUNCTION(mist, true)
 KERNEL_FILM_CONVERT_FUNCTION(sample_count, true)
 KERNEL_FILM_CONVERT_FUNCTION(float, true)
 
 KERNEL_FILM_CONVERT_FUNCTION(light_path, false)
-KERNEL_FILM_CONVERT_FUNCTION(float3, false)
+KERNEL_FILM_CONVERT_SIMD_FUNCTION(float3, false)
 
 KERNEL_FILM_CONVERT_FUNCTION(motion, false)
 KERNEL_FILM_CONVERT_FUNCTION(cryptomatte, false)
 KERNEL_FILM_CONVERT_FUNCTION(shadow_catcher, false)
 KERNEL_FILM_CONVERT_FUNCTION(shadow_catcher_matte_with_shadow, false)
-KERNEL_FILM_CONVERT_FUNCTION(combined, false)
+KERNEL_FILM_CONVERT_SIMD_FUNCTION(combined, false)
 KERNEL_FILM_CONVERT_FUNCTION(float4, false)
 
 #undef KERNEL_FILM_CONVERT_FUNCTION
+#undef KERNEL_FILM_CONVERT_SIMD_FUNCTION
 
 #undef KERNEL_INVOKE
 #undef DEFINE_INTEGRATOR_KERNEL
@@ -880,6 +880,7 @@ ccl_gpu_kernel(GPU_KERNEL_BLOCK_NUM_THREADS, GPU_KERNEL_MAX_REGISTERS)
                              int render_pass_sample_count,
                              int render_pass_denoising_albedo,
                              int render_pass_denoising_normal,
+                             int render_pass_denoising_use_half,
                              int render_pass_motion,
                              int full_x,
                              int full_y,
@@ -916,9 +917,19 @@ ccl_gpu_kernel(GPU_KERNEL_BLOCK_NUM_THREADS, GPU_KERNEL_MAX_REGISTERS)
     ccl_global const float *aledo_in = buffer + render_pass_denoising_albedo;
     ccl_global float *albedo_out = guiding_pixel + guiding_pass_albedo;
 
-    albedo_out[0] = aledo_in[0] * pixel_scale;
-    albedo_out[1] = aledo_in[1] * pixel_scale;
-    albedo_out[2] = aledo_in[2] * pixel_scale;
+    if (render_pass_denoising_use_half) {
+      /* Half passes hold the mean over samples already. */
+      const uint xy = __float_as_uint(aledo_in[0]);
+      const uint z = __float_as_uint(aledo_in[1]);
+      albedo_out[0] = half_storage_to_float(xy & 0xffff);
+      albedo_out[1] = half_storage_to_float(xy >> 16);
+      albedo_out[2] = half_storage_to_float(z & 0xffff);
+    }
+    else {
+      albedo_out[0] = aledo_in[0] * pixel_scale;
+      albedo_out[1] = aledo_in[1] * pixel_scale;
+      albedo_out[2] = aledo_in[2] * pixel_scale;
+    }
   }
 
   /* Normal pass. */
@@ -928,9 +939,18 @@ ccl_gpu_kernel(GPU_KERNEL_BLOCK_NUM_THREADS, GPU_KERNEL_MAX_REGISTERS)
     ccl_global const float *normal_in = buffer + render_pass_denoising_normal;
     ccl_global float *normal_out = guiding_pixel + guiding_pass_normal;
 
-    normal_out[0] = normal_in[0] * pixel_scale;
-    normal_out[1] = normal_in[1] * pixel_scale;
-    normal_out[2] = normal_in[2] * pixel_scale;
+    if (render_pass_denoising_use_half) {
+      const uint xy = __float_as_uint(normal_in[0]);
+      const uint z = __float_as_uint(normal_in[1]);
+      normal_out[0] = half_storage_to_float(xy & 0xffff);
+      normal_out[1] = half_storage_to_float(xy >> 16);
+      normal_out[2] = half_storage_to_float(z & 0xffff);
+    }
+    else {
+      normal_out[0] = normal_in[0] * pixel_scale;
+      normal_out[1] = normal_in[1] * pixel_scale;
+      normal_out[2] = normal_in[2] * pixel_scale;
+    }
   }
 
   /* Flow pass. */
@@ -71,7 +71,7 @@ ccl_device_inline void film_write_data_passes(KernelGlobals kg,
         average(surface_shader_alpha(kg, sd)) >= kernel_data.film.pass_alpha_threshold) {
       if (flag & PASSMASK(NORMAL)) {
         const float3 normal = surface_shader_average_normal(kg, sd);
-        film_write_pass_float3(buffer + kernel_data.film.pass_normal, normal);
+        film_write_aux_pass_float3(kg, buffer, kernel_data.film.pass_normal, normal);
       }
       if (flag & PASSMASK(ROUGHNESS)) {
         const float roughness = surface_shader_average_roughness(sd);
@@ -89,7 +89,8 @@ ccl_device_forceinline void film_write_denoising_features_surface(KernelGlobals
       normal = transform_direction(&worldtocamera, normal);
 
       const float3 denoising_normal = ensure_finite(normal);
-      film_write_pass_float3(buffer + kernel_data.film.pass_denoising_normal, denoising_normal);
+      film_write_aux_pass_float3(
+          kg, buffer, kernel_data.film.pass_denoising_normal, denoising_normal);
     }
 
     if (kernel_data.film.pass_denoising_albedo != PASS_UNUSED) {
@@ -97,7 +98,8 @@ ccl_device_forceinline void film_write_denoising_features_surface(KernelGlobals
           state, path, denoising_feature_throughput);
       const Spectrum denoising_albedo = ensure_finite(denoising_feature_throughput *
                                                       diffuse_albedo);
-      film_write_pass_spectrum(buffer + kernel_data.film.pass_denoising_albedo, denoising_albedo);
+      film_write_aux_pass_spectrum(
+          kg, buffer, kernel_data.film.pass_denoising_albedo, denoising_albedo);
     }
 
     INTEGRATOR_STATE_WRITE(state, path, flag) &= ~PATH_RAY_DENOISING_FEATURES;
@@ -124,13 +126,15 @@ ccl_device_forceinline void film_write_denoising_features_volume(KernelGlobals k
 
     /* Write view direction as normal. */
     const float3 denoising_normal = make_float3(0.0f, 0.0f, -1.0f);
-    film_write_pass_float3(buffer + kernel_data.film.pass_denoising_normal, denoising_normal);
+    film_write_aux_pass_float3(
+        kg, buffer, kernel_data.film.pass_denoising_normal, denoising_normal);
   }
 
   if (kernel_data.film.pass_denoising_albedo != PASS_UNUSED) {
     /* Write albedo. */
     const Spectrum denoising_albedo = ensure_finite(denoising_feature_throughput * albedo);
-    film_write_pass_spectrum(buffer + kernel_data.film.pass_denoising_albedo, denoising_albedo);
+    film_write_aux_pass_spectrum(
+        kg, buffer, kernel_data.film.pass_denoising_albedo, denoising_albedo);
   }
 }
 #endif /* __DENOISING_FEATURES__ */
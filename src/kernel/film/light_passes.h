@@ -359,7 +359,8 @@ ccl_device_inline void film_write_emission_or_background_pass(
       const Spectrum denoising_feature_throughput = INTEGRATOR_STATE(
           state, path, denoising_feature_throughput);
       const Spectrum denoising_albedo = denoising_feature_throughput * contribution;
-      film_write_pass_spectrum(buffer + kernel_data.film.pass_denoising_albedo, denoising_albedo);
+      film_write_aux_pass_spectrum(
+          kg, buffer, kernel_data.film.pass_denoising_albedo, denoising_albedo);
     }
   }
 #  endif /* __DENOISING_FEATURES__ */
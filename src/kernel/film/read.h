@@ -21,6 +21,21 @@ ccl_device_forceinline float film_transparency_to_alpha(float transparency)
   return saturatef(1.0f - transparency);
 }
 
+/* Read three components of a pass, which is either stored in full float or packed half float. */
+ccl_device_inline float3 film_read_pass_float3(ccl_global const KernelFilmConvert *ccl_restrict
+                                                   kfilm_convert,
+                                               ccl_global const float *ccl_restrict in)
+{
+  if (kfilm_convert->pass_use_half) {
+    const uint xy = __float_as_uint(in[0]);
+    const uint z = __float_as_uint(in[1]);
+    return make_float3(half_storage_to_float(xy & 0xffff),
+                       half_storage_to_float(xy >> 16),
+                       half_storage_to_float(z & 0xffff));
+  }
+  return make_float3(in[0], in[1], in[2]);
+}
+
 ccl_device_inline float film_get_scale(ccl_global const KernelFilmConvert *ccl_restrict
                                            kfilm_convert,
                                        ccl_global const float *ccl_restrict buffer)
@@ -230,11 +245,15 @@ ccl_device_inline void film_get_pass_pixel_float3(ccl_global const KernelFilmCon
   kernel_assert(kfilm_convert->num_components >= 3);
   kernel_assert(kfilm_convert->pass_offset != PASS_UNUSED);
 
-  const float scale_exposure = film_get_scale_exposure(kfilm_convert, buffer);
+  /* Passes stored as half float hold the mean over samples rather than the sum. */
+  const float scale_exposure = (kfilm_convert->pass_use_half) ?
+                                   (kfilm_convert->pass_use_exposure ? kfilm_convert->exposure :
+                                                                       1.0f) :
+                                   film_get_scale_exposure(kfilm_convert, buffer);
 
   ccl_global const float *in = buffer + kfilm_convert->pass_offset;
 
-  const float3 f = make_float3(in[0], in[1], in[2]) * scale_exposure;
+  const float3 f = film_read_pass_float3(kfilm_convert, in) * scale_exposure;
 
   pixel[0] = f.x;
   pixel[1] = f.y;
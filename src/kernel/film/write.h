@@ -76,6 +76,135 @@ ccl_device_inline void film_write_pass_float4(ccl_global float *ccl_restrict buf
 #endif
 }
 
+/* Accumulate in passes stored as half float. Three components are packed into the first two
+ * floats of the pass, two per float with the first one in the lower 16 bits.
+ *
+ * A running sum in half float loses contributions once they drop below half the precision of
+ * the sum, so these passes store the mean over the samples of the pixel instead. The CPU device
+ * renders consecutive samples of a pixel in a row on one thread. Contributions of such a block
+ * of samples are summed in float in the KernelHalfPassesBlock of the thread, and folded into
+ * the mean once at the end of the block. The mean is thus rounded to half float once per block
+ * rather than once per sample, and every sample of the pixel is taken into account.
+ *
+ * Half storage is only enabled for CPU devices, GPU kernels always write full float passes. */
+
+#ifndef __KERNEL_GPU__
+ccl_device_inline void film_reset_half_passes_block(ccl_private KernelHalfPassesBlock *block)
+{
+  block->first_sample = 0;
+  block->num_samples = 0;
+  block->normal = zero_float3();
+  block->denoising_normal = zero_float3();
+  block->denoising_albedo = zero_float3();
+}
+
+/* Count the given sample of the pixel in the current block. */
+
+ccl_device_inline void film_begin_half_passes_sample(KernelGlobals kg, const int pixel_sample)
+{
+  if (!kernel_data.film.use_half_passes) {
+    return;
+  }
+
+  ccl_private KernelHalfPassesBlock *block = kg->half_passes_block;
+  kernel_assert(block != nullptr);
+  kernel_assert(block->num_samples == 0 ||
+                block->first_sample + block->num_samples == pixel_sample);
+
+  if (block->num_samples == 0) {
+    block->first_sample = pixel_sample;
+  }
+  block->num_samples++;
+}
+
+ccl_device_inline void film_fold_half_pass(ccl_global float *ccl_restrict buffer,
+                                           const float3 sum,
+                                           const float num_prev_samples,
+                                           const float num_samples)
+{
+  const uint xy = __float_as_uint(buffer[0]);
+  const uint z = __float_as_uint(buffer[1]);
+  const float3 prev_mean = make_float3(half_storage_to_float(xy & 0xffff),
+                                       half_storage_to_float(xy >> 16),
+                                       half_storage_to_float(z & 0xffff));
+  const float3 mean = (prev_mean * num_prev_samples + sum) / num_samples;
+
+  buffer[0] = __uint_as_float(float_to_half_storage(mean.x) |
+                              (float_to_half_storage(mean.y) << 16));
+  buffer[1] = __uint_as_float(float_to_half_storage(mean.z));
+}
+
+/* Fold the sums of the current block into the means stored in the render buffer pixel, and
+ * start a new block. */
+
+ccl_device_inline void film_fold_half_passes_block(KernelGlobals kg,
+                                                   ccl_global float *ccl_restrict buffer)
+{
+  ccl_private KernelHalfPassesBlock *block = kg->half_passes_block;
+  if (block->num_samples == 0) {
+    return;
+  }
+
+  const float num_prev_samples = block->first_sample;
+  const float num_samples = block->first_sample + block->num_samples;
+
+  if (kernel_data.film.pass_normal != PASS_UNUSED) {
+    film_fold_half_pass(
+        buffer + kernel_data.film.pass_normal, block->normal, num_prev_samples, num_samples);
+  }
+  if (kernel_data.film.pass_denoising_normal != PASS_UNUSED) {
+    film_fold_half_pass(buffer + kernel_data.film.pass_denoising_normal,
+                        block->denoising_normal,
+                        num_prev_samples,
+                        num_samples);
+  }
+  if (kernel_data.film.pass_denoising_albedo != PASS_UNUSED) {
+    film_fold_half_pass(buffer + kernel_data.film.pass_denoising_albedo,
+                        block->denoising_albedo,
+                        num_prev_samples,
+                        num_samples);
+  }
+
+  film_reset_half_passes_block(block);
+}
+#endif
+
+/* Accumulate in auxiliary passes which are stored in half float when enabled in the film. Only
+ * used for passes which have `support_half` set in their PassInfo. */
+
+ccl_device_inline void film_write_aux_pass_float3(KernelGlobals kg,
+                                                  ccl_global float *ccl_restrict buffer,
+                                                  const int pass_offset,
+                                                  float3 value)
+{
+#ifndef __KERNEL_GPU__
+  if (kernel_data.film.use_half_passes) {
+    ccl_private KernelHalfPassesBlock *block = kg->half_passes_block;
+    if (pass_offset == kernel_data.film.pass_normal) {
+      block->normal += value;
+    }
+    else if (pass_offset == kernel_data.film.pass_denoising_normal) {
+      block->denoising_normal += value;
+    }
+    else {
+      kernel_assert(pass_offset == kernel_data.film.pass_denoising_albedo);
+      block->denoising_albedo += value;
+    }
+    return;
+  }
+#endif
+
+  film_write_pass_float3(buffer + pass_offset, value);
+}
+
+ccl_device_inline void film_write_aux_pass_spectrum(KernelGlobals kg,
+                                                    ccl_global float *ccl_restrict buffer,
+                                                    const int pass_offset,
+                                                    Spectrum value)
+{
+  film_write_aux_pass_float3(kg, buffer, pass_offset, spectrum_to_rgb(value));
+}
+
 /* Overwrite for passes that only write on sample 0. This assumes only a single thread will write
  * to this pixel and no atomics are needed. */
 
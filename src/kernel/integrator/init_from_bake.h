@@ -121,6 +121,9 @@ ccl_device bool integrator_init_from_bake(KernelGlobals kg,
   /* Always count the sample, even if the camera sample will reject the ray. */
   const int sample = film_write_sample(
       kg, state, render_buffer, scheduled_sample, tile->sample_offset);
+#ifndef __KERNEL_GPU__
+  film_begin_half_passes_sample(kg, sample - tile->sample_offset);
+#endif
 
   /* Setup render buffers. */
   const int index = INTEGRATOR_STATE(state, path, render_pixel_index);
@@ -228,7 +231,7 @@ ccl_device bool integrator_init_from_bake(KernelGlobals kg,
       return true;
     }
     else if (kernel_data.film.pass_normal != PASS_UNUSED && !(shader_flags & SD_HAS_BUMP)) {
-      film_write_pass_float3(buffer + kernel_data.film.pass_normal, N);
+      film_write_aux_pass_float3(kg, buffer, kernel_data.film.pass_normal, N);
       return true;
     }
 
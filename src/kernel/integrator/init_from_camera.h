@@ -72,6 +72,9 @@ ccl_device bool integrator_init_from_camera(KernelGlobals kg,
    * `scheduled_sample` will be different from actual number of samples in this pixel). */
   const int sample = film_write_sample(
       kg, state, render_buffer, scheduled_sample, tile->sample_offset);
+#ifndef __KERNEL_GPU__
+  film_begin_half_passes_sample(kg, sample - tile->sample_offset);
+#endif
 
   /* Initialize random number seed for path. */
   const uint rng_hash = path_rng_hash_init(kg, sample, x, y);
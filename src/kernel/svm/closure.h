@@ -142,29 +142,36 @@ ccl_device_noinline int svm_node_closure_bsdf(KernelGlobals kg,
       float roughness = stack_load_float(stack, roughness_offset);
       float specular_tint = stack_load_float(stack, specular_tint_offset);
       float anisotropic = stack_load_float(stack, anisotropic_offset);
-      float sheen = stack_load_float(stack, sheen_offset);
-      float sheen_tint = stack_load_float(stack, sheen_tint_offset);
-      float clearcoat = stack_load_float(stack, clearcoat_offset);
-      float clearcoat_roughness = stack_load_float(stack, clearcoat_roughness_offset);
-      float transmission = stack_load_float(stack, transmission_offset);
       float anisotropic_rotation = stack_load_float(stack, anisotropic_rotation_offset);
-      float transmission_roughness = stack_load_float(stack, transmission_roughness_offset);
-      float eta = fmaxf(stack_load_float(stack, eta_offset), 1e-5f);
 
       ClosureType distribution = (ClosureType)data_node2.y;
       ClosureType subsurface_method = (ClosureType)data_node2.z;
+      uint lobes = data_node2.w;
+
+      /* Parameters of lobes left out by the compiler are not on the stack. */
+      float sheen = 0.0f, sheen_tint = 0.0f;
+      if (lobes & NODE_PRINCIPLED_SHEEN) {
+        sheen = stack_load_float(stack, sheen_offset);
+        sheen_tint = stack_load_float(stack, sheen_tint_offset);
+      }
+
+      float clearcoat = 0.0f, clearcoat_roughness = 0.0f;
+      if (lobes & NODE_PRINCIPLED_CLEARCOAT) {
+        clearcoat = stack_load_float(stack, clearcoat_offset);
+        clearcoat_roughness = stack_load_float(stack, clearcoat_roughness_offset);
+      }
+
+      float transmission = 0.0f, transmission_roughness = 0.0f, eta = 1.0f;
+      if (lobes & NODE_PRINCIPLED_TRANSMISSION) {
+        transmission = stack_load_float(stack, transmission_offset);
+        transmission_roughness = stack_load_float(stack, transmission_roughness_offset);
+        eta = fmaxf(stack_load_float(stack, eta_offset), 1e-5f);
+      }
 
       /* rotate tangent */
       if (anisotropic_rotation != 0.0f)
         T = rotate_around_axis(T, N, anisotropic_rotation * M_2PI_F);
 
-      /* calculate ior */
-      float ior = (sd->flag & SD_BACKFACING) ? 1.0f / eta : eta;
-
-      // calculate fresnel for refraction
-      float cosNI = dot(N, sd->wi);
-      float fresnel = fresnel_dielectric_cos(cosNI, ior);
-
       // calculate weights of the diffuse and specular part
       float diffuse_weight = (1.0f - saturatef(metallic)) * (1.0f - saturatef(transmission));
 
@@ -184,7 +191,8 @@ ccl_device_noinline int svm_node_closure_bsdf(KernelGlobals kg,
       float3 clearcoat_normal = stack_valid(data_cn_ssr.x) ?
                                     stack_load_float3(stack, data_cn_ssr.x) :
                                     sd->N;
-      if (!(sd->type & PRIMITIVE_CURVE)) {
+      if ((lobes & NODE_PRINCIPLED_CLEARCOAT) && clearcoat > 0.0f &&
+          !(sd->type & PRIMITIVE_CURVE)) {
         clearcoat_normal = ensure_valid_reflection(sd->Ng, sd->wi, clearcoat_normal);
       }
       float3 subsurface_radius = stack_valid(data_cn_ssr.y) ?
@@ -352,6 +360,13 @@ ccl_device_noinline int svm_node_closure_bsdf(KernelGlobals kg,
           kernel_data.integrator.caustics_refractive || (path_flag & PATH_RAY_DIFFUSE) == 0) {
 #endif
         if (final_transmission > CLOSURE_WEIGHT_CUTOFF) {
+          /* calculate ior */
+          float ior = (sd->flag & SD_BACKFACING) ? 1.0f / eta : eta;
+
+          // calculate fresnel for refraction
+          float cosNI = dot(N, sd->wi);
+          float fresnel = fresnel_dielectric_cos(cosNI, ior);
+
           Spectrum glass_weight = weight * final_transmission;
           float3 cspec0 = base_color * specular_tint + make_float3(1.0f - specular_tint);
 
@@ -452,20 +467,23 @@ ccl_device_noinline int svm_node_closure_bsdf(KernelGlobals kg,
 #ifdef __CAUSTICS_TRICKS__
       if (kernel_data.integrator.caustics_reflective || (path_flag & PATH_RAY_DIFFUSE) == 0) {
 #endif
-        Spectrum clearcoat_weight = 0.25f * clearcoat * weight;
-        ccl_private MicrofacetBsdf *bsdf = (ccl_private MicrofacetBsdf *)bsdf_alloc(
-            sd, sizeof(MicrofacetBsdf), clearcoat_weight);
+        /* Clearcoat parameters are not computed when the clearcoat weight is zero. */
+        if ((lobes & NODE_PRINCIPLED_CLEARCOAT) && clearcoat > 0.0f) {
+          Spectrum clearcoat_weight = 0.25f * clearcoat * weight;
+          ccl_private MicrofacetBsdf *bsdf = (ccl_private MicrofacetBsdf *)bsdf_alloc(
+              sd, sizeof(MicrofacetBsdf), clearcoat_weight);
 
-        if (bsdf) {
-          bsdf->N = clearcoat_normal;
-          bsdf->T = zero_float3();
-          bsdf->ior = 1.5f;
+          if (bsdf) {
+            bsdf->N = clearcoat_normal;
+            bsdf->T = zero_float3();
+            bsdf->ior = 1.5f;
 
-          bsdf->alpha_x = clearcoat_roughness * clearcoat_roughness;
-          bsdf->alpha_y = clearcoat_roughness * clearcoat_roughness;
+            bsdf->alpha_x = clearcoat_roughness * clearcoat_roughness;
+            bsdf->alpha_y = clearcoat_roughness * clearcoat_roughness;
 
-          /* setup bsdf */
-          sd->flag |= bsdf_microfacet_ggx_clearcoat_setup(bsdf, sd);
+            /* setup bsdf */
+            sd->flag |= bsdf_microfacet_ggx_clearcoat_setup(bsdf, sd);
+          }
         }
 #ifdef __CAUSTICS_TRICKS__
       }
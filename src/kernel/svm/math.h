@@ -23,6 +23,47 @@ ccl_device_noinline void svm_node_math(KernelGlobals kg,
   stack_store_float(stack, result_stack_offset, result);
 }
 
+ccl_device_inline float svm_math_chain_operand(ccl_private float *stack,
+                                               uint kind,
+                                               uint value,
+                                               float previous)
+{
+  if (kind == NODE_MATH_CHAIN_PREVIOUS) {
+    return previous;
+  }
+  if (kind == NODE_MATH_CHAIN_CONSTANT) {
+    return __uint_as_float(value);
+  }
+  return stack_load_float(stack, value);
+}
+
+/* Evaluates a chain of math nodes where every node feeds only the next one. Intermediate results
+ * stay in a register instead of going through the stack, and unlinked inputs are stored inline
+ * instead of being loaded by separate value nodes. */
+ccl_device_noinline int svm_node_math_chain(KernelGlobals kg,
+                                            ccl_private float *stack,
+                                            uint num_steps,
+                                            uint result_stack_offset,
+                                            int offset)
+{
+  float result = 0.0f;
+
+  for (uint i = 0; i < num_steps; i++) {
+    uint4 step = read_node(kg, &offset);
+
+    uint type, a_kind, b_kind, c_kind;
+    svm_unpack_node_uchar4(step.x, &type, &a_kind, &b_kind, &c_kind);
+
+    float a = svm_math_chain_operand(stack, a_kind, step.y, result);
+    float b = svm_math_chain_operand(stack, b_kind, step.z, result);
+    float c = svm_math_chain_operand(stack, c_kind, step.w, result);
+    result = svm_math((NodeMathType)type, a, b, c);
+  }
+
+  stack_store_float(stack, result_stack_offset, result);
+  return offset;
+}
+
 ccl_device_noinline int svm_node_vector_math(KernelGlobals kg,
                                              ccl_private ShaderData *sd,
                                              ccl_private float *stack,
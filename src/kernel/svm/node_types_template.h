@@ -107,8 +107,12 @@ SHADER_NODE_TYPE(NODE_MIX_COLOR)
 SHADER_NODE_TYPE(NODE_MIX_FLOAT)
 SHADER_NODE_TYPE(NODE_MIX_VECTOR)
 SHADER_NODE_TYPE(NODE_MIX_VECTOR_NON_UNIFORM)
+SHADER_NODE_TYPE(NODE_MATH_CHAIN)
+SHADER_NODE_TYPE(NODE_VALUES)
 
 /* Padding for struct alignment. */
 SHADER_NODE_TYPE(NODE_PAD1)
+SHADER_NODE_TYPE(NODE_PAD2)
+SHADER_NODE_TYPE(NODE_PAD3)
 
 #undef SHADER_NODE_TYPE
@@ -597,6 +597,12 @@ ccl_device void svm_eval_nodes(KernelGlobals kg,
       SVM_CASE(NODE_MIX_VECTOR_NON_UNIFORM)
       svm_node_mix_vector_non_uniform(sd, stack, node.y, node.z);
       break;
+      SVM_CASE(NODE_MATH_CHAIN)
+      offset = svm_node_math_chain(kg, stack, node.y, node.z, offset);
+      break;
+      SVM_CASE(NODE_VALUES)
+      offset = svm_node_values(kg, stack, node.y, node.z, offset);
+      break;
       default:
         kernel_assert(!"Unknown node type was passed to the SVM machine");
         return;
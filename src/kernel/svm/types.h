@@ -183,6 +183,22 @@ typedef enum NodeMathType {
   NODE_MATH_SMOOTH_MAX,
 } NodeMathType;
 
+/* Where an operand of a step in NODE_MATH_CHAIN is read from. */
+typedef enum NodeMathChainOperand {
+  NODE_MATH_CHAIN_STACK = 0,
+  NODE_MATH_CHAIN_CONSTANT,
+  NODE_MATH_CHAIN_PREVIOUS,
+} NodeMathChainOperand;
+
+/* Lobes of the Principled BSDF which may contribute. The compiler leaves out lobes which are
+ * statically known to contribute nothing, after which their parameters are not loaded. */
+typedef enum NodePrincipledLobe {
+  NODE_PRINCIPLED_SUBSURFACE = (1 << 0),
+  NODE_PRINCIPLED_SHEEN = (1 << 1),
+  NODE_PRINCIPLED_CLEARCOAT = (1 << 2),
+  NODE_PRINCIPLED_TRANSMISSION = (1 << 3),
+} NodePrincipledLobe;
+
 typedef enum NodeVectorMathType {
   NODE_VECTOR_MATH_ADD,
   NODE_VECTOR_MATH_SUBTRACT,
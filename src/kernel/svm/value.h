@@ -31,4 +31,30 @@ ccl_device int svm_node_value_v(KernelGlobals kg,
   return offset;
 }
 
+/* Load the constant inputs of a node, stored as pairs of floats followed by vectors. */
+ccl_device_noinline int svm_node_values(KernelGlobals kg,
+                                        ccl_private float *stack,
+                                        uint num_floats,
+                                        uint num_vectors,
+                                        int offset)
+{
+  for (uint i = 0; i < num_floats; i += 2) {
+    const uint4 node = read_node(kg, &offset);
+    stack_store_float(stack, node.x, __uint_as_float(node.y));
+    if (i + 1 < num_floats) {
+      stack_store_float(stack, node.z, __uint_as_float(node.w));
+    }
+  }
+
+  for (uint i = 0; i < num_vectors; i++) {
+    const uint4 node = read_node(kg, &offset);
+    stack_store_float3(
+        stack,
+        node.x,
+        make_float3(__uint_as_float(node.y), __uint_as_float(node.z), __uint_as_float(node.w)));
+  }
+
+  return offset;
+}
+
 CCL_NAMESPACE_END
@@ -226,6 +226,10 @@ enum PathRayFlag : uint32_t {
    * So this can overlap with path flags. */
   PATH_RAY_NODE_UNALIGNED = (1U << 11U),
 
+  /* Special flag to tag quantized BVH nodes, which store child bounds as 8 bit offsets relative to
+   * the parent bounds. Like the flag above, only used in BVH nodes. */
+  PATH_RAY_NODE_QUANTIZED = (1U << 12U),
+
   /* --------------------------------------------------------------------
    * Path flags.
    */
@@ -1148,8 +1152,8 @@ typedef struct KernelFilmConvert {
 
   int is_denoised;
 
-  /* Padding. */
-  int pad1;
+  /* Pass is stored as packed half float. */
+  int pass_use_half;
 } KernelFilmConvert;
 static_assert_align(KernelFilmConvert, 16);
 
@@ -21,6 +21,13 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Half passes are accumulated over blocks of consecutive samples of a pixel rendered by one
+ * thread, see film_fold_half_passes_block(). Only CPU devices render pixels that way. */
+static bool film_use_half_passes(const Film *film, const Device *device)
+{
+  return film->get_use_half_passes() && device->info.type == DEVICE_CPU;
+}
+
 /* Pixel Filter */
 
 static float filter_func_box(float /*v*/, float /*width*/)
@@ -120,6 +127,8 @@ NODE_DEFINE(Film)
 
   SOCKET_BOOLEAN(use_approximate_shadow_catcher, "Use Approximate Shadow Catcher", false);
 
+  SOCKET_BOOLEAN(use_half_passes, "Use Half Passes", false);
+
   return type;
 }
 
@@ -158,6 +167,7 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
   kfilm->pass_flag = 0;
 
   kfilm->use_approximate_shadow_catcher = get_use_approximate_shadow_catcher();
+  kfilm->use_half_passes = film_use_half_passes(this, device);
 
   kfilm->light_pass_flag = 0;
   kfilm->pass_stride = 0;
@@ -218,14 +228,14 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
     if (pass->get_mode() == PassMode::DENOISED) {
       /* Generally we only storing offsets of the noisy passes. The display pass is an exception
        * since it is a read operation and not a write. */
-      kfilm->pass_stride += pass->get_info().num_components;
+      kfilm->pass_stride += pass->get_storage_size();
       continue;
     }
 
     /* Can't do motion pass if no motion vectors are available. */
     if (pass->get_type() == PASS_MOTION || pass->get_type() == PASS_MOTION_WEIGHT) {
       if (scene->need_motion() != Scene::MOTION_PASS) {
-        kfilm->pass_stride += pass->get_info().num_components;
+        kfilm->pass_stride += pass->get_storage_size();
         continue;
       }
     }
@@ -246,7 +256,7 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
         kfilm->pass_lightgroup = kfilm->pass_stride;
         have_lightgroup = true;
       }
-      kfilm->pass_stride += pass->get_info().num_components;
+      kfilm->pass_stride += pass->get_storage_size();
       continue;
     }
 
@@ -396,7 +406,7 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
         break;
     }
 
-    kfilm->pass_stride += pass->get_info().num_components;
+    kfilm->pass_stride += pass->get_storage_size();
   }
 
   /* update filter table */
@@ -694,6 +704,11 @@ void Film::finalize_passes(Scene *scene, const bool use_denoise)
     }
   }
 
+  const bool use_half_storage = film_use_half_passes(this, scene->device);
+  for (Pass *pass : new_passes) {
+    pass->use_half_storage_ = use_half_storage && pass->get_info().support_half;
+  }
+
   /* Order from by components and type, This is required to for AOVs and cryptomatte passes,
    * which the kernel assumes to be in order. Note this must use stable sort so cryptomatte
    * passes remain in the right order. */
@@ -50,6 +50,13 @@ class Film : public Node {
    * shadows can be alpha-overed onto a backdrop. */
   NODE_SOCKET_API(bool, use_approximate_shadow_catcher)
 
+  /* Store auxiliary passes with bounded per-sample values (such as normal and denoising albedo)
+   * in half float to reduce render buffer memory. These passes hold the mean over all samples of
+   * the pixel rather than the sum, with about three significant digits. Each thread accumulates
+   * the samples of a pixel in float and updates the mean once per render work, so this is only
+   * supported on CPU. */
+  NODE_SOCKET_API(bool, use_half_passes)
+
  private:
   size_t filter_table_offset_;
   bool prev_have_uv_pass = false;
@@ -3,9 +3,12 @@
 
 #include "bvh/bvh.h"
 #include "bvh/bvh2.h"
+#include "bvh/multi.h"
 
 #include "device/device.h"
 
+#include "integrator/shader_eval.h"
+
 #include "scene/attribute.h"
 #include "scene/camera.h"
 #include "scene/geometry.h"
@@ -233,6 +236,7 @@ void Geometry::compute_bvh(Device *device,
       bparams.bvh_layout = bvh_layout;
       bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
                                     params->use_bvh_unaligned_nodes;
+      bparams.use_quantized_nodes = params->use_bvh_quantized_nodes;
       bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
       bparams.num_motion_curve_steps = params->num_bvh_time_steps;
       bparams.num_motion_point_steps = params->num_bvh_time_steps;
@@ -1242,6 +1246,7 @@ void GeometryManager::device_update_bvh(Device *device,
   bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
   bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
                                 scene->params.use_bvh_unaligned_nodes;
+  bparams.use_quantized_nodes = scene->params.use_bvh_quantized_nodes;
   bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
   bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
   bparams.num_motion_point_steps = scene->params.num_bvh_time_steps;
@@ -1928,6 +1933,9 @@ void GeometryManager::device_update(Device *device,
     /* Copy constant data needed by shader evaluation. */
     device->const_copy_to("data", &dscene->data, sizeof(dscene->data));
 
+    /* Shared by all geometry, so that device buffers are reused between them. */
+    ShaderEval shader_eval(device, progress);
+
     scoped_callback_timer timer([scene](double time) {
       if (scene->update_stats) {
         scene->update_stats->geometry.times.add_entry({"device_update (displacement)", time});
@@ -1938,13 +1946,13 @@ void GeometryManager::device_update(Device *device,
       if (geom->is_modified()) {
         if (geom->is_mesh()) {
           Mesh *mesh = static_cast<Mesh *>(geom);
-          if (displace(device, scene, mesh, progress)) {
+          if (displace(shader_eval, scene, mesh, progress)) {
             displacement_done = true;
           }
         }
         else if (geom->geometry_type == Geometry::HAIR) {
           Hair *hair = static_cast<Hair *>(geom);
-          if (hair->update_shadow_transparency(device, scene, progress)) {
+          if (hair->update_shadow_transparency(shader_eval, scene, progress)) {
             curve_shadow_transparency_done = true;
           }
         }
@@ -2180,12 +2188,37 @@ bool GeometryManager::need_update() const
   return update_flags != UPDATE_NONE;
 }
 
+static void collect_bvh_statistics(const string &name, const BVH *bvh, RenderStats *stats)
+{
+  if (bvh == NULL) {
+    return;
+  }
+
+  const BVHLayout layout = bvh->params.bvh_layout;
+  if (layout == BVH_LAYOUT_MULTI_OPTIX || layout == BVH_LAYOUT_MULTI_OPTIX_EMBREE ||
+      layout == BVH_LAYOUT_MULTI_METAL || layout == BVH_LAYOUT_MULTI_METAL_EMBREE) {
+    /* Report every device specific BVH, they are built with different builders. */
+    const BVHMulti *multi_bvh = static_cast<const BVHMulti *>(bvh);
+    foreach (const BVH *sub_bvh, multi_bvh->sub_bvhs) {
+      collect_bvh_statistics(name, sub_bvh, stats);
+    }
+    return;
+  }
+
+  if (bvh->stats.is_valid()) {
+    stats->bvh.add_entry(NamedBVHStats(name, bvh->stats));
+  }
+}
+
 void GeometryManager::collect_statistics(const Scene *scene, RenderStats *stats)
 {
   foreach (Geometry *geometry, scene->geometry) {
     stats->mesh.geometry.add_entry(
         NamedSizeEntry(string(geometry->name.c_str()), geometry->get_total_size_in_bytes()));
+    collect_bvh_statistics(string(geometry->name.c_str()), geometry->bvh, stats);
   }
+
+  collect_bvh_statistics("Scene", scene->bvh, stats);
 }
 
 CCL_NAMESPACE_END
@@ -27,6 +27,7 @@ class RenderStats;
 class Scene;
 class SceneParams;
 class Shader;
+class ShaderEval;
 class Volume;
 struct PackedBVH;
 
@@ -214,7 +215,7 @@ class GeometryManager {
   void collect_statistics(const Scene *scene, RenderStats *stats);
 
  protected:
-  bool displace(Device *device, Scene *scene, Mesh *mesh, Progress &progress);
+  bool displace(ShaderEval &shader_eval, Scene *scene, Mesh *mesh, Progress &progress);
 
   void create_volume_mesh(const Scene *scene, Volume *volume, Progress &progress);
 
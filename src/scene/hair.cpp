@@ -563,7 +563,9 @@ bool Hair::need_shadow_transparency()
   return false;
 }
 
-bool Hair::update_shadow_transparency(Device *device, Scene *scene, Progress &progress)
+bool Hair::update_shadow_transparency(ShaderEval &shader_eval,
+                                      Scene *scene,
+                                      Progress &progress)
 {
   if (!need_shadow_transparency()) {
     /* If no shaders with shadow transparency, remove attribute. */
@@ -600,7 +602,6 @@ bool Hair::update_shadow_transparency(Device *device, Scene *scene, Progress &pr
   }
 
   /* Evaluate shader on device. */
-  ShaderEval shader_eval(device, progress);
   bool is_fully_opaque = false;
   shader_eval.eval(SHADER_EVAL_CURVE_SHADOW_TRANSPARENCY,
                    num_keys(),
@@ -143,7 +143,7 @@ class Hair : public Geometry {
 
   /* Attributes */
   bool need_shadow_transparency();
-  bool update_shadow_transparency(Device *device, Scene *scene, Progress &progress);
+  bool update_shadow_transparency(ShaderEval &shader_eval, Scene *scene, Progress &progress);
 };
 
 CCL_NAMESPACE_END
@@ -9,6 +9,7 @@
 #include "scene/scene.h"
 #include "scene/stats.h"
 
+#include "util/atomic.h"
 #include "util/foreach.h"
 #include "util/image.h"
 #include "util/image_impl.h"
@@ -27,6 +28,10 @@ CCL_NAMESPACE_BEGIN
 
 namespace {
 
+/* Counter for image load identifiers. It is shared by all image managers, so that a load
+ * identifier refers to the same image content anywhere in the process. */
+uint64_t image_load_counter = 0;
+
 /* Some helpers to silence warning in templated function. */
 bool isfinite(uchar /*value*/)
 {
@@ -197,6 +202,40 @@ device_texture *ImageHandle::image_memory(const int tile_index) const
   return img ? img->mem : NULL;
 }
 
+uint64_t ImageHandle::load_id(const int tile_index) const
+{
+  if (tile_index >= tile_slots.size()) {
+    return 0;
+  }
+
+  ImageManager::Image *img = manager->images[tile_slots[tile_index]];
+  return img ? img->load_id : 0;
+}
+
+string ImageHandle::file_identity(const int tile_index) const
+{
+  if (tile_index >= tile_slots.size()) {
+    return "";
+  }
+
+  ImageManager::Image *img = manager->images[tile_slots[tile_index]];
+  if (!img || img->loader->osl_filepath().empty()) {
+    return "";
+  }
+
+  const string filepath = img->loader->osl_filepath().string();
+  const ImageParams &params = img->params;
+  return string_printf("%s:%llu:%d:%d:%d:%d:%s:%g",
+                       filepath.c_str(),
+                       (unsigned long long)path_modified_time(filepath),
+                       (int)params.animated,
+                       (int)params.interpolation,
+                       (int)params.extension,
+                       (int)params.alpha_type,
+                       params.colorspace.c_str(),
+                       (double)params.frame);
+}
+
 VDBImageLoader *ImageHandle::vdb_loader(const int tile_index) const
 {
   if (tile_index >= tile_slots.size()) {
@@ -488,6 +527,7 @@ size_t ImageManager::add_image_slot(ImageLoader *loader,
   img->builtin = builtin;
   img->users = 1;
   img->mem = NULL;
+  img->load_id = 0;
 
   images[slot] = img;
 
@@ -713,6 +753,7 @@ void ImageManager::device_load_image(Device *device, Scene *scene, size_t slot,
 
   img->mem = new device_texture(
       device, img->mem_name.c_str(), slot, type, img->params.interpolation, img->params.extension);
+  img->load_id = atomic_add_and_fetch_uint64(&image_load_counter, 1);
   img->mem->info.use_transform_3d = img->metadata.use_transform_3d;
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
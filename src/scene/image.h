@@ -151,6 +151,16 @@ class ImageHandle {
   vector<int4> get_svm_slots() const;
   device_texture *image_memory(const int tile_index = 0) const;
 
+  /* Unique identifier of the last time the image was loaded, changes when the image is
+   * reloaded to detect that its content may have changed. Identifiers are unique within the
+   * process. */
+  uint64_t load_id(const int tile_index = 0) const;
+
+  /* Identity of the content of an image loaded from a file, made of the file path, its
+   * modification time and the image parameters. Empty for images from other sources, whose
+   * content can only be told apart by load_id(). */
+  string file_identity(const int tile_index = 0) const;
+
   VDBImageLoader *vdb_loader(const int tile_index = 0) const;
 
   ImageManager *get_manager() const;
@@ -206,6 +216,7 @@ class ImageManager {
 
     string mem_name;
     device_texture *mem;
+    uint64_t load_id;
 
     int users;
     thread_mutex mutex;
@@ -20,6 +20,8 @@
 #include "util/foreach.h"
 #include "util/hash.h"
 #include "util/log.h"
+#include "util/math_cdf.h"
+#include "util/md5.h"
 #include "util/path.h"
 #include "util/progress.h"
 #include "util/task.h"
@@ -50,7 +52,7 @@ static void shade_background_pixels(Device *device,
         /* Fill coordinates for shading. */
         KernelShaderEvalInput *d_input_data = d_input.data();
 
-        for (int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](const int y) {
           for (int x = 0; x < width; x++) {
             float u = (x + 0.5f) / width;
             float v = (y + 0.5f) / height;
@@ -62,7 +64,7 @@ static void shade_background_pixels(Device *device,
             in.v = v;
             d_input_data[x + y * width] = in;
           }
-        }
+        });
 
         return size;
       },
@@ -70,13 +72,13 @@ static void shade_background_pixels(Device *device,
         /* Copy output to pixel buffer. */
         float *d_output_data = d_output.data();
 
-        for (int y = 0; y < height; y++) {
+        parallel_for(0, height, [&](const int y) {
           for (int x = 0; x < width; x++) {
             pixels[y * width + x].x = d_output_data[(y * width + x) * num_channels + 0];
             pixels[y * width + x].y = d_output_data[(y * width + x) * num_channels + 1];
             pixels[y * width + x].z = d_output_data[(y * width + x) * num_channels + 2];
           }
-        }
+        });
       });
 }
 
@@ -268,43 +270,89 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
-void LightManager::device_update_distribution(Device *,
-                                              DeviceScene *dscene,
-                                              Scene *scene,
-                                              Progress &progress)
+static int object_light_shader_flag(Object *object)
 {
-  KernelIntegrator *kintegrator = &dscene->data.integrator;
+  int shader_flag = 0;
 
-  /* Update CDF over lights. */
-  progress.set_status("Updating Lights", "Computing distribution");
+  if (!(object->get_visibility() & PATH_RAY_CAMERA)) {
+    shader_flag |= SHADER_EXCLUDE_CAMERA;
+  }
+  if (!(object->get_visibility() & PATH_RAY_DIFFUSE)) {
+    shader_flag |= SHADER_EXCLUDE_DIFFUSE;
+  }
+  if (!(object->get_visibility() & PATH_RAY_GLOSSY)) {
+    shader_flag |= SHADER_EXCLUDE_GLOSSY;
+  }
+  if (!(object->get_visibility() & PATH_RAY_TRANSMIT)) {
+    shader_flag |= SHADER_EXCLUDE_TRANSMIT;
+  }
+  if (!(object->get_visibility() & PATH_RAY_VOLUME_SCATTER)) {
+    shader_flag |= SHADER_EXCLUDE_SCATTER;
+  }
+  if (!(object->get_is_shadow_catcher())) {
+    shader_flag |= SHADER_EXCLUDE_SHADOW_CATCHER;
+  }
 
-  /* Counts emissive triangles in the scene. */
-  size_t num_triangles = 0;
+  return shader_flag;
+}
+
+void LightManager::update_emissive_triangles(Scene *scene, Progress &progress)
+{
+  if (emissive_triangles.valid) {
+    return;
+  }
+
+  emissive_triangles.clear();
+  emissive_triangles.object_lookup_offsets.resize(scene->objects.size(), 0);
 
+  /* Keep track of the index of triangles that are emissive. */
+  size_t total_triangles = 0;
+  int object_id = 0;
   foreach (Object *object, scene->objects) {
     if (progress.get_cancel())
       return;
 
     if (!object_usable_as_light(object)) {
+      object_id++;
       continue;
     }
 
-    /* Count emissive triangles. */
+    emissive_triangles.object_lookup_offsets[object_id] = total_triangles;
+
     Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
-    size_t mesh_num_triangles = mesh->num_triangles();
+    int mesh_num_triangles = static_cast<int>(mesh->num_triangles());
 
-    for (size_t i = 0; i < mesh_num_triangles; i++) {
+    for (int i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->get_shader()[i];
       Shader *shader = (shader_index < mesh->get_used_shaders().size()) ?
                            static_cast<Shader *>(mesh->get_used_shaders()[shader_index]) :
                            scene->default_surface;
 
       if (shader->emission_sampling != EMISSION_SAMPLING_NONE) {
-        num_triangles++;
+        emissive_triangles.triangles.emplace_back(i, object_id);
       }
     }
+
+    total_triangles += mesh_num_triangles;
+    object_id++;
   }
 
+  emissive_triangles.total_triangles = total_triangles;
+  emissive_triangles.valid = true;
+}
+
+void LightManager::device_update_distribution(Device *,
+                                              DeviceScene *dscene,
+                                              Scene *scene,
+                                              Progress &progress)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+  /* Update CDF over lights. */
+  progress.set_status("Updating Lights", "Computing distribution");
+
+  /* Counts emissive triangles in the scene. */
+  const size_t num_triangles = emissive_triangles.triangles.size();
   const size_t num_lights = kintegrator->num_lights;
   const size_t num_distribution = num_triangles + num_lights;
 
@@ -318,83 +366,66 @@ void LightManager::device_update_distribution(Device *,
     return;
   }
 
-  /* Emission area. */
-  KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
-  float totarea = 0.0f;
-
-  /* Triangles. */
-  size_t offset = 0;
-  int j = 0;
-
-  foreach (Object *object, scene->objects) {
-    if (progress.get_cancel())
-      return;
-
-    if (!object_usable_as_light(object)) {
-      j++;
-      continue;
-    }
-    /* Sum area. */
-    Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
-    bool transform_applied = mesh->transform_applied;
-    Transform tfm = object->get_tfm();
-    int object_id = j;
+  /* Emission area of triangles, cached with the emissive triangles. */
+  vector<KernelLightDistribution> &triangle_distribution = emissive_triangles.distribution;
+  if (triangle_distribution.size() != num_triangles) {
+    triangle_distribution.resize(num_triangles);
+    float totarea = 0.0f;
+    int last_object_id = -1;
+    Mesh *mesh = nullptr;
+    Transform tfm;
     int shader_flag = 0;
 
-    if (!(object->get_visibility() & PATH_RAY_CAMERA)) {
-      shader_flag |= SHADER_EXCLUDE_CAMERA;
-    }
-    if (!(object->get_visibility() & PATH_RAY_DIFFUSE)) {
-      shader_flag |= SHADER_EXCLUDE_DIFFUSE;
-    }
-    if (!(object->get_visibility() & PATH_RAY_GLOSSY)) {
-      shader_flag |= SHADER_EXCLUDE_GLOSSY;
-    }
-    if (!(object->get_visibility() & PATH_RAY_TRANSMIT)) {
-      shader_flag |= SHADER_EXCLUDE_TRANSMIT;
-    }
-    if (!(object->get_visibility() & PATH_RAY_VOLUME_SCATTER)) {
-      shader_flag |= SHADER_EXCLUDE_SCATTER;
-    }
-    if (!(object->get_is_shadow_catcher())) {
-      shader_flag |= SHADER_EXCLUDE_SHADOW_CATCHER;
-    }
-
-    size_t mesh_num_triangles = mesh->num_triangles();
-    for (size_t i = 0; i < mesh_num_triangles; i++) {
-      int shader_index = mesh->get_shader()[i];
-      Shader *shader = (shader_index < mesh->get_used_shaders().size()) ?
-                           static_cast<Shader *>(mesh->get_used_shaders()[shader_index]) :
-                           scene->default_surface;
+    for (size_t offset = 0; offset < num_triangles; offset++) {
+      const int i = emissive_triangles.triangles[offset].first;
+      const int object_id = emissive_triangles.triangles[offset].second;
 
-      if (shader->emission_sampling != EMISSION_SAMPLING_NONE) {
-        distribution[offset].totarea = totarea;
-        distribution[offset].prim = i + mesh->prim_offset;
-        distribution[offset].mesh_light.shader_flag = shader_flag;
-        distribution[offset].mesh_light.object_id = object_id;
-        offset++;
-
-        Mesh::Triangle t = mesh->get_triangle(i);
-        if (!t.valid(&mesh->get_verts()[0])) {
-          continue;
-        }
-        float3 p1 = mesh->get_verts()[t.v[0]];
-        float3 p2 = mesh->get_verts()[t.v[1]];
-        float3 p3 = mesh->get_verts()[t.v[2]];
-
-        if (!transform_applied) {
-          p1 = transform_point(&tfm, p1);
-          p2 = transform_point(&tfm, p2);
-          p3 = transform_point(&tfm, p3);
+      if (object_id != last_object_id) {
+        if (progress.get_cancel()) {
+          triangle_distribution.clear();
+          return;
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        Object *object = scene->objects[object_id];
+        mesh = static_cast<Mesh *>(object->get_geometry());
+        tfm = object->get_tfm();
+        shader_flag = object_light_shader_flag(object);
+        last_object_id = object_id;
       }
+
+      triangle_distribution[offset].totarea = totarea;
+      triangle_distribution[offset].prim = i + mesh->prim_offset;
+      triangle_distribution[offset].mesh_light.shader_flag = shader_flag;
+      triangle_distribution[offset].mesh_light.object_id = object_id;
+
+      /* Sum area. */
+      Mesh::Triangle t = mesh->get_triangle(i);
+      if (!t.valid(&mesh->get_verts()[0])) {
+        continue;
+      }
+      float3 p1 = mesh->get_verts()[t.v[0]];
+      float3 p2 = mesh->get_verts()[t.v[1]];
+      float3 p3 = mesh->get_verts()[t.v[2]];
+
+      if (!mesh->transform_applied) {
+        p1 = transform_point(&tfm, p1);
+        p2 = transform_point(&tfm, p2);
+        p3 = transform_point(&tfm, p3);
+      }
+
+      totarea += triangle_area(p1, p2, p3);
     }
 
-    j++;
+    emissive_triangles.total_area = totarea;
   }
 
+  KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
+
+  /* Triangles. */
+  std::copy(triangle_distribution.begin(), triangle_distribution.end(), distribution);
+  size_t offset = num_triangles;
+  float totarea = emissive_triangles.total_area;
+
   const float trianglearea = totarea;
 
   /* Lights. */
@@ -466,6 +497,10 @@ void LightManager::device_update_tree(Device *,
   KernelIntegrator *kintegrator = &dscene->data.integrator;
 
   if (!kintegrator->use_light_tree) {
+    light_tree.reset();
+    light_tree_prims.clear();
+    light_tree_light_prims.clear();
+
     dscene->light_tree_nodes.free();
     dscene->light_tree_emitters.free();
     dscene->light_to_tree.free();
@@ -482,7 +517,6 @@ void LightManager::device_update_tree(Device *,
   light_prims.reserve(kintegrator->num_distribution);
   vector<LightTreePrimitive> distant_lights;
   distant_lights.reserve(kintegrator->num_distant_lights);
-  vector<uint> object_lookup_offsets(scene->objects.size());
 
   /* When we keep track of the light index, only contributing lights will be added to the device.
    * Therefore, we want to keep track of the light's index on the device.
@@ -504,38 +538,25 @@ void LightManager::device_update_tree(Device *,
     scene_light_index++;
   }
 
-  /* Similarly, we also want to keep track of the index of triangles that are emissive. */
-  size_t total_triangles = 0;
-  int object_id = 0;
-  foreach (Object *object, scene->objects) {
-    if (progress.get_cancel())
-      return;
-
-    if (!object_usable_as_light(object)) {
-      object_id++;
-      continue;
-    }
-
-    object_lookup_offsets[object_id] = total_triangles;
-
-    /* Count emissive triangles. */
-    Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
-    int mesh_num_triangles = static_cast<int>(mesh->num_triangles());
-
-    for (int i = 0; i < mesh_num_triangles; i++) {
-      int shader_index = mesh->get_shader()[i];
-      Shader *shader = (shader_index < mesh->get_used_shaders().size()) ?
-                           static_cast<Shader *>(mesh->get_used_shaders()[shader_index]) :
-                           scene->default_surface;
-
-      if (shader->emission_sampling != EMISSION_SAMPLING_NONE) {
-        light_prims.emplace_back(scene, i, object_id);
-      }
-    }
-
-    total_triangles += mesh_num_triangles;
-    object_id++;
+  /* Similarly, we also want to keep track of the index of triangles that are emissive.
+   * The primitives of emissive triangles are cached, and constructed in parallel since computing
+   * their bounds requires reading the mesh of every triangle. */
+  const vector<std::pair<int, int>> &triangles = emissive_triangles.triangles;
+  vector<LightTreePrimitive> &triangle_prims = emissive_triangles.tree_prims;
+  if (triangle_prims.size() != triangles.size()) {
+    triangle_prims.resize(triangles.size());
+    parallel_for(blocked_range<size_t>(0, triangles.size(), 1024),
+                 [&](const blocked_range<size_t> &r) {
+                   for (size_t i = r.begin(); i != r.end(); i++) {
+                     triangle_prims[i] = LightTreePrimitive(
+                         scene, triangles[i].first, triangles[i].second);
+                   }
+                 });
   }
+  light_prims.insert(light_prims.end(), triangle_prims.begin(), triangle_prims.end());
+
+  const vector<uint> &object_lookup_offsets = emissive_triangles.object_lookup_offsets;
+  const size_t total_triangles = emissive_triangles.total_triangles;
 
   /* Append distant lights to the end of `light_prims` */
   std::move(distant_lights.begin(), distant_lights.end(), std::back_inserter(light_prims));
@@ -545,7 +566,7 @@ void LightManager::device_update_tree(Device *,
 
   /* TODO: For now, we'll start with a smaller number of max lights in a node.
    * More benchmarking is needed to determine what number works best. */
-  LightTree light_tree(light_prims, kintegrator->num_distant_lights, 8);
+  light_tree = make_unique<LightTree>(light_prims, kintegrator->num_distant_lights, 8);
 
   /* We want to create separate arrays corresponding to triangles and lights,
    * which will be used to index back into the light tree for PDF calculations. */
@@ -559,7 +580,7 @@ void LightManager::device_update_tree(Device *,
   }
 
   /* First initialize the light tree's nodes. */
-  const vector<LightTreeNode> &linearized_bvh = light_tree.get_nodes();
+  const vector<LightTreeNode> &linearized_bvh = light_tree->get_nodes();
   KernelLightTreeNode *light_tree_nodes = dscene->light_tree_nodes.alloc(linearized_bvh.size());
   KernelLightTreeEmitter *light_tree_emitters = dscene->light_tree_emitters.alloc(
       light_prims.size());
@@ -593,30 +614,11 @@ void LightManager::device_update_tree(Device *,
         if (prim.is_triangle()) {
           light_tree_emitters[emitter_index].mesh_light.object_id = prim.object_id;
 
-          int shader_flag = 0;
           Object *object = scene->objects[prim.object_id];
           Mesh *mesh = static_cast<Mesh *>(object->get_geometry());
           Shader *shader = static_cast<Shader *>(
               mesh->get_used_shaders()[mesh->get_shader()[prim.prim_id]]);
-
-          if (!(object->get_visibility() & PATH_RAY_CAMERA)) {
-            shader_flag |= SHADER_EXCLUDE_CAMERA;
-          }
-          if (!(object->get_visibility() & PATH_RAY_DIFFUSE)) {
-            shader_flag |= SHADER_EXCLUDE_DIFFUSE;
-          }
-          if (!(object->get_visibility() & PATH_RAY_GLOSSY)) {
-            shader_flag |= SHADER_EXCLUDE_GLOSSY;
-          }
-          if (!(object->get_visibility() & PATH_RAY_TRANSMIT)) {
-            shader_flag |= SHADER_EXCLUDE_TRANSMIT;
-          }
-          if (!(object->get_visibility() & PATH_RAY_VOLUME_SCATTER)) {
-            shader_flag |= SHADER_EXCLUDE_SCATTER;
-          }
-          if (!(object->get_is_shadow_catcher())) {
-            shader_flag |= SHADER_EXCLUDE_SHADOW_CATCHER;
-          }
+          const int shader_flag = object_light_shader_flag(object);
 
           light_tree_emitters[emitter_index].prim = prim.prim_id + mesh->prim_offset;
           light_tree_emitters[emitter_index].mesh_light.shader_flag = shader_flag;
@@ -645,46 +647,210 @@ void LightManager::device_update_tree(Device *,
   dscene->light_to_tree.copy_to_device();
   dscene->object_lookup_offset.copy_to_device();
   dscene->triangle_to_tree.copy_to_device();
+
+  /* Keep the primitives in tree order for refitting. */
+  light_tree_light_prims.clear();
+  light_tree_light_prims.resize(scene->lights.size(), -1);
+  for (int i = 0; i < light_prims.size(); i++) {
+    if (!light_prims[i].is_triangle()) {
+      light_tree_light_prims[light_prims[i].object_id] = i;
+    }
+  }
+  light_tree_prims = std::move(light_prims);
+}
+
+static bool light_tree_prim_bounds_equal(const LightTreePrimitive &a, const LightTreePrimitive &b)
+{
+  return a.energy == b.energy && a.centroid == b.centroid && a.bbox.min == b.bbox.min &&
+         a.bbox.max == b.bbox.max && a.bcone.axis == b.bcone.axis &&
+         a.bcone.theta_o == b.bcone.theta_o && a.bcone.theta_e == b.bcone.theta_e;
+}
+
+bool LightManager::device_update_tree_refit(DeviceScene *dscene, Scene *scene)
+{
+  if (!light_tree || dscene->light_tree_nodes.size() != light_tree->get_nodes().size()) {
+    return false;
+  }
+
+  /* Recompute the primitives of all lights, and refit the tree for the ones that changed. */
+  vector<int> modified_prims;
+  int device_light_index = 0;
+  int scene_light_index = 0;
+  foreach (Light *light, scene->lights) {
+    if (light->is_enabled) {
+      const int prim_index = light_tree_light_prims[scene_light_index];
+      const LightTreePrimitive prim(scene, ~device_light_index, scene_light_index);
+      if (!light_tree_prim_bounds_equal(prim, light_tree_prims[prim_index])) {
+        light_tree_prims[prim_index] = prim;
+        modified_prims.push_back(prim_index);
+      }
+
+      device_light_index++;
+    }
+
+    scene_light_index++;
+  }
+
+  /* Refitting keeps the topology of the tree, which degrades sampling quality when many lights
+   * move. Rebuild in that case. */
+  if (modified_prims.size() > max(light_tree_prims.size() / 8, size_t(8))) {
+    return false;
+  }
+
+  VLOG_INFO << "Refitting light tree for " << modified_prims.size() << " modified lights.";
+
+  if (modified_prims.empty()) {
+    return true;
+  }
+
+  const vector<int> modified_nodes = light_tree->refit(light_tree_prims, modified_prims);
+  const vector<LightTreeNode> &nodes = light_tree->get_nodes();
+
+  KernelLightTreeNode *light_tree_nodes = dscene->light_tree_nodes.data();
+  for (const int index : modified_nodes) {
+    const LightTreeNode &node = nodes[index];
+
+    light_tree_nodes[index].energy = node.energy;
+
+    light_tree_nodes[index].bbox.min = node.bbox.min;
+    light_tree_nodes[index].bbox.max = node.bbox.max;
+
+    light_tree_nodes[index].bcone.axis = node.bcone.axis;
+    light_tree_nodes[index].bcone.theta_o = node.bcone.theta_o;
+    light_tree_nodes[index].bcone.theta_e = node.bcone.theta_e;
+  }
+
+  KernelLightTreeEmitter *light_tree_emitters = dscene->light_tree_emitters.data();
+  for (const int emitter_index : modified_prims) {
+    const LightTreePrimitive &prim = light_tree_prims[emitter_index];
+
+    light_tree_emitters[emitter_index].energy = prim.energy;
+    light_tree_emitters[emitter_index].theta_o = prim.bcone.theta_o;
+    light_tree_emitters[emitter_index].theta_e = prim.bcone.theta_e;
+  }
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_emitters.copy_to_device();
+
+  return true;
 }
 
 static void background_cdf(
     int start, int end, int res_x, int res_y, const vector<float3> *pixels, float2 *cond_cdf)
 {
   int cdf_width = res_x + 1;
+  vector<float> values(res_x);
+  vector<float> cdf(cdf_width);
+
   /* Conditional CDFs (rows, U direction). */
   for (int i = start; i < end; i++) {
     float sin_theta = sinf(M_PI_F * (i + 0.5f) / res_y);
-    float3 env_color = (*pixels)[i * res_x];
-    float ave_luminance = average(env_color);
-
-    cond_cdf[i * cdf_width].x = ave_luminance * sin_theta;
-    cond_cdf[i * cdf_width].y = 0.0f;
+    for (int j = 0; j < res_x; j++) {
+      values[j] = average((*pixels)[i * res_x + j]) * sin_theta;
+    }
 
-    for (int j = 1; j < res_x; j++) {
-      env_color = (*pixels)[i * res_x + j];
-      ave_luminance = average(env_color);
+    const float cdf_total = util_cdf_prefix_sum(values.data(), res_x, 1.0f / res_x, cdf.data());
+    util_cdf_normalize(cdf.data(), res_x, cdf_total);
 
-      cond_cdf[i * cdf_width + j].x = ave_luminance * sin_theta;
-      cond_cdf[i * cdf_width + j].y = cond_cdf[i * cdf_width + j - 1].y +
-                                      cond_cdf[i * cdf_width + j - 1].x / res_x;
+    for (int j = 0; j < res_x; j++) {
+      cond_cdf[i * cdf_width + j] = make_float2(values[j], cdf[j]);
     }
 
-    const float cdf_total = cond_cdf[i * cdf_width + res_x - 1].y +
-                            cond_cdf[i * cdf_width + res_x - 1].x / res_x;
-
     /* stuff the total into the brightness value for the last entry, because
      * we are going to normalize the CDFs to 0.0 to 1.0 afterwards */
-    cond_cdf[i * cdf_width + res_x].x = cdf_total;
+    cond_cdf[i * cdf_width + res_x] = make_float2(cdf_total, 1.0f);
+  }
+}
+
+/* Hash of everything the background importance map depends on. Maps are only shared between
+ * scenes when the hash identifies the content of all images by their file, since load
+ * identifiers of other images are unique to one load. */
+static string background_map_hash(Scene *scene, Shader *shader, const int2 res, bool &shareable)
+{
+  MD5Hash md5;
+  shareable = true;
+  foreach (ShaderNode *node, shader->graph->nodes) {
+    node->hash(md5);
+    foreach (ShaderInput *input, node->inputs) {
+      int link_id = (input->link) ? input->link->parent->id : 0;
+      md5.append((uint8_t *)&link_id, sizeof(link_id));
+      md5.append((input->link) ? input->link->name().c_str() : "");
+    }
 
-    if (cdf_total > 0.0f) {
-      const float cdf_total_inv = 1.0f / cdf_total;
-      for (int j = 1; j < res_x; j++) {
-        cond_cdf[i * cdf_width + j].y *= cdf_total_inv;
+    if (node->special_type == SHADER_SPECIAL_TYPE_OSL) {
+      /* Hash takes into account socket values, to detect changes
+       * in the code of the node we need an exception. */
+      OSLNode *oslnode = static_cast<OSLNode *>(node);
+      md5.append(oslnode->bytecode_hash);
+    }
+    else if (node->special_type == SHADER_SPECIAL_TYPE_IMAGE_SLOT) {
+      /* Detect changes in the content of images. */
+      ImageSlotTextureNode *image_node = static_cast<ImageSlotTextureNode *>(node);
+      for (int tile = 0; tile < image_node->handle.num_tiles(); tile++) {
+        const string file_identity = image_node->handle.file_identity(tile);
+        if (!file_identity.empty()) {
+          md5.append(file_identity);
+        }
+        else {
+          const uint64_t load_id = image_node->handle.load_id(tile);
+          md5.append((uint8_t *)&load_id, sizeof(load_id));
+          shareable = false;
+        }
       }
     }
+  }
+  md5.append((uint8_t *)&scene->params.texture_limit, sizeof(scene->params.texture_limit));
+  md5.append((uint8_t *)&res, sizeof(res));
+  return md5.get_hex();
+}
 
-    cond_cdf[i * cdf_width + res_x].y = 1.0f;
+/* The most recently built shareable background importance map, so that sessions rendering the
+ * same world, such as consecutive frames or render layers, reuse it. It is released as soon as a
+ * scene without background light is updated. */
+static struct {
+  thread_mutex mutex;
+  string hash;
+  vector<float2> marginal_cdf;
+  vector<float2> conditional_cdf;
+} background_map_cache;
+
+static bool background_map_cache_lookup(const string &map_hash, DeviceScene *dscene)
+{
+  thread_scoped_lock lock(background_map_cache.mutex);
+  if (background_map_cache.hash != map_hash) {
+    return false;
   }
+
+  const vector<float2> &marginal_cdf = background_map_cache.marginal_cdf;
+  const vector<float2> &conditional_cdf = background_map_cache.conditional_cdf;
+  std::copy(marginal_cdf.begin(),
+            marginal_cdf.end(),
+            dscene->light_background_marginal_cdf.alloc(marginal_cdf.size()));
+  std::copy(conditional_cdf.begin(),
+            conditional_cdf.end(),
+            dscene->light_background_conditional_cdf.alloc(conditional_cdf.size()));
+  return true;
+}
+
+static void background_map_cache_clear()
+{
+  thread_scoped_lock lock(background_map_cache.mutex);
+  background_map_cache.hash.clear();
+  background_map_cache.marginal_cdf.free_memory();
+  background_map_cache.conditional_cdf.free_memory();
+}
+
+static void background_map_cache_store(const string &map_hash, DeviceScene *dscene)
+{
+  const device_vector<float2> &marginal_cdf = dscene->light_background_marginal_cdf;
+  const device_vector<float2> &conditional_cdf = dscene->light_background_conditional_cdf;
+
+  thread_scoped_lock lock(background_map_cache.mutex);
+  background_map_cache.hash = map_hash;
+  background_map_cache.marginal_cdf.assign(marginal_cdf.data(),
+                                           marginal_cdf.data() + marginal_cdf.size());
+  background_map_cache.conditional_cdf.assign(conditional_cdf.data(),
+                                              conditional_cdf.data() + conditional_cdf.size());
 }
 
 void LightManager::device_update_background(Device *device,
@@ -712,6 +878,11 @@ void LightManager::device_update_background(Device *device,
 
   /* no background light found, signal renderer to skip sampling */
   if (!background_light || !background_light->is_enabled) {
+    dscene->light_background_marginal_cdf.free();
+    dscene->light_background_conditional_cdf.free();
+    last_background_map_hash.clear();
+    background_map_cache_clear();
+
     kbackground->map_res_x = 0;
     kbackground->map_res_y = 0;
     kbackground->use_mis = (kbackground->portal_weight > 0.0f);
@@ -802,39 +973,78 @@ void LightManager::device_update_background(Device *device,
   kbackground->map_res_x = res.x;
   kbackground->map_res_y = res.y;
 
-  vector<float3> pixels;
-  shade_background_pixels(device, dscene, res.x, res.y, pixels, progress);
+  /* The importance map of the previous update is reused when the background shader, its images
+   * and the resolution are unchanged. */
+  int cdf_width = res.x + 1;
+  bool map_shareable;
+  const string map_hash = background_map_hash(scene, shader, res, map_shareable);
+  if (map_hash == last_background_map_hash &&
+      dscene->light_background_marginal_cdf.size() == res.y + 1 &&
+      dscene->light_background_conditional_cdf.size() == cdf_width * res.y) {
+    VLOG_WORK << "Reusing background importance map";
+  }
+  else if (map_shareable && background_map_cache_lookup(map_hash, dscene)) {
+    VLOG_WORK << "Using cached background importance map";
 
-  if (progress.get_cancel())
-    return;
+    dscene->light_background_marginal_cdf.copy_to_device();
+    dscene->light_background_conditional_cdf.copy_to_device();
 
-  /* build row distributions and column distribution for the infinite area environment light */
-  int cdf_width = res.x + 1;
-  float2 *marg_cdf = dscene->light_background_marginal_cdf.alloc(res.y + 1);
-  float2 *cond_cdf = dscene->light_background_conditional_cdf.alloc(cdf_width * res.y);
+    last_background_map_hash = map_hash;
+  }
+  else {
+    last_background_map_hash.clear();
+
+    vector<float3> pixels;
+    shade_background_pixels(device, dscene, res.x, res.y, pixels, progress);
+
+    if (progress.get_cancel())
+      return;
 
-  double time_start = time_dt();
+    /* build row distributions and column distribution for the infinite area environment light */
+    float2 *marg_cdf = dscene->light_background_marginal_cdf.alloc(res.y + 1);
+    float2 *cond_cdf = dscene->light_background_conditional_cdf.alloc(cdf_width * res.y);
 
-  /* Create CDF in parallel. */
-  const int rows_per_task = divide_up(10240, res.x);
-  parallel_for(blocked_range<size_t>(0, res.y, rows_per_task),
-               [&](const blocked_range<size_t> &r) {
-                 background_cdf(r.begin(), r.end(), res.x, res.y, &pixels, cond_cdf);
-               });
+    double time_start = time_dt();
 
-  /* marginal CDFs (column, V direction, sum of rows) */
-  marg_cdf[0].x = cond_cdf[res.x].x;
-  marg_cdf[0].y = 0.0f;
+    /* Create CDF in parallel. */
+    const int rows_per_task = divide_up(10240, res.x);
+    parallel_for(blocked_range<size_t>(0, res.y, rows_per_task),
+                 [&](const blocked_range<size_t> &r) {
+                   background_cdf(r.begin(), r.end(), res.x, res.y, &pixels, cond_cdf);
+                 });
 
-  for (int i = 1; i < res.y; i++) {
-    marg_cdf[i].x = cond_cdf[i * cdf_width + res.x].x;
-    marg_cdf[i].y = marg_cdf[i - 1].y + marg_cdf[i - 1].x / res.y;
-  }
+    /* marginal CDFs (column, V direction, sum of rows) */
+    vector<float> values(res.y);
+    vector<float> cdf(res.y + 1);
+    for (int i = 0; i < res.y; i++) {
+      values[i] = cond_cdf[i * cdf_width + res.x].x;
+    }
 
-  float cdf_total = marg_cdf[res.y - 1].y + marg_cdf[res.y - 1].x / res.y;
-  marg_cdf[res.y].x = cdf_total;
+    const float cdf_total = util_cdf_prefix_sum(values.data(), res.y, 1.0f / res.y, cdf.data());
+    util_cdf_normalize(cdf.data(), res.y, cdf_total);
+
+    for (int i = 0; i < res.y; i++) {
+      marg_cdf[i] = make_float2(values[i], cdf[i]);
+    }
+    marg_cdf[res.y] = make_float2(cdf_total, 1.0f);
+
+    VLOG_WORK << "Background MIS build time " << time_dt() - time_start << "\n";
+
+    /* update device */
+    dscene->light_background_marginal_cdf.copy_to_device();
+    dscene->light_background_conditional_cdf.copy_to_device();
+
+    if (map_shareable) {
+      background_map_cache_store(map_hash, dscene);
+    }
+    else {
+      background_map_cache_clear();
+    }
+    last_background_map_hash = map_hash;
+  }
 
-  float map_average_radiance = cdf_total * M_PI_2_F;
+  /* The total is stored in the last entry of the marginal CDF. */
+  const float map_average_radiance = dscene->light_background_marginal_cdf[res.y].x * M_PI_2_F;
   if (sun_average_radiance > 0.0f) {
     /* The weighting here is just a heuristic that was empirically determined.
      * The sun's average radiance is much higher than the map's average radiance,
@@ -846,18 +1056,6 @@ void LightManager::device_update_background(Device *device,
   else {
     background_light->set_average_radiance(map_average_radiance);
   }
-
-  if (cdf_total > 0.0f)
-    for (int i = 1; i < res.y; i++)
-      marg_cdf[i].y /= cdf_total;
-
-  marg_cdf[res.y].y = 1.0f;
-
-  VLOG_WORK << "Background MIS build time " << time_dt() - time_start << "\n";
-
-  /* update device */
-  dscene->light_background_marginal_cdf.copy_to_device();
-  dscene->light_background_conditional_cdf.copy_to_device();
 }
 
 void LightManager::device_update_lights(Device *device, DeviceScene *dscene, Scene *scene)
@@ -1151,7 +1349,24 @@ void LightManager::device_update(Device *device,
   /* Detect which lights are enabled, also determines if we need to update the background. */
   test_enabled_lights(scene);
 
-  device_free(device, dscene, need_update_background);
+  /* Emissive triangles only need to be gathered again when meshes, objects or shaders changed. */
+  if (update_flags & (MESH_NEED_REBUILD | EMISSIVE_MESH_MODIFIED | OBJECT_MANAGER |
+                      SHADER_COMPILED | SHADER_MODIFIED)) {
+    emissive_triangles.clear();
+  }
+
+  /* When only properties of lights were modified and the same lights are enabled, the light
+   * distribution is unchanged and the light tree can be refit. */
+  vector<int> enabled_lights = get_enabled_lights(scene);
+  const bool use_light_tree = scene->integrator->get_use_light_tree() &&
+                              device->info.has_light_tree;
+  const bool only_lights_modified = (update_flags & ~LIGHT_MODIFIED) == 0 &&
+                                    enabled_lights == last_enabled_lights &&
+                                    use_light_tree == bool(dscene->data.integrator.use_light_tree);
+  last_enabled_lights.clear();
+
+  /* The background importance map is freed by device_update_background when it is not reused. */
+  device_free(device, dscene, false, !only_lights_modified);
 
   device_update_lights(device, dscene, scene);
   if (progress.get_cancel())
@@ -1163,35 +1378,64 @@ void LightManager::device_update(Device *device,
       return;
   }
 
-  device_update_distribution(device, dscene, scene, progress);
+  update_emissive_triangles(scene, progress);
   if (progress.get_cancel())
     return;
 
-  device_update_tree(device, dscene, scene, progress);
-  if (progress.get_cancel())
-    return;
+  if (!only_lights_modified) {
+    device_update_distribution(device, dscene, scene, progress);
+    if (progress.get_cancel())
+      return;
+  }
+
+  if (!(only_lights_modified && use_light_tree && device_update_tree_refit(dscene, scene))) {
+    device_update_tree(device, dscene, scene, progress);
+    if (progress.get_cancel())
+      return;
+  }
 
   device_update_ies(dscene);
   if (progress.get_cancel())
     return;
 
+  last_enabled_lights = std::move(enabled_lights);
   update_flags = UPDATE_NONE;
   need_update_background = false;
 }
 
-void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
+vector<int> LightManager::get_enabled_lights(Scene *scene)
 {
-  /* to-do: check if the light tree member variables need to be wrapped in a conditional too*/
-  dscene->light_tree_nodes.free();
-  dscene->light_tree_emitters.free();
-  dscene->light_to_tree.free();
-  dscene->triangle_to_tree.free();
+  vector<int> enabled_lights;
+  enabled_lights.reserve(scene->lights.size());
+  foreach (Light *light, scene->lights) {
+    enabled_lights.push_back(light->is_enabled ? int(light->light_type) : -1);
+  }
+  return enabled_lights;
+}
 
-  dscene->light_distribution.free();
+void LightManager::device_free(Device *,
+                               DeviceScene *dscene,
+                               const bool free_background,
+                               const bool free_light_sampling)
+{
+  if (free_light_sampling) {
+    /* to-do: check if the light tree member variables need to be wrapped in a conditional too*/
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_emitters.free();
+    dscene->light_to_tree.free();
+    dscene->triangle_to_tree.free();
+
+    dscene->light_distribution.free();
+
+    light_tree.reset();
+    light_tree_prims.clear();
+    light_tree_light_prims.clear();
+  }
   dscene->lights.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
     dscene->light_background_conditional_cdf.free();
+    last_background_map_hash.clear();
   }
   dscene->ies_lights.free();
 }
@@ -16,6 +16,7 @@
 #include "util/ies.h"
 #include "util/thread.h"
 #include "util/types.h"
+#include "util/unique_ptr.h"
 #include "util/vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -115,7 +116,10 @@ class LightManager {
   void remove_ies(int slot);
 
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
-  void device_free(Device *device, DeviceScene *dscene, const bool free_background = true);
+  void device_free(Device *device,
+                   DeviceScene *dscene,
+                   const bool free_background = true,
+                   const bool free_light_sampling = true);
 
   void tag_update(Scene *scene, uint32_t flag);
 
@@ -137,6 +141,7 @@ class LightManager {
                                   Scene *scene,
                                   Progress &progress);
   void device_update_tree(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+  bool device_update_tree_refit(DeviceScene *dscene, Scene *scene);
   void device_update_background(Device *device,
                                 DeviceScene *dscene,
                                 Scene *scene,
@@ -146,6 +151,12 @@ class LightManager {
   /* Check whether light manager can use the object as a light-emissive. */
   bool object_usable_as_light(Object *object);
 
+  /* Gather the emissive triangles of all objects, unless still cached from a previous update. */
+  void update_emissive_triangles(Scene *scene, Progress &progress);
+
+  /* Signature of the enabled lights, see `last_enabled_lights`. */
+  vector<int> get_enabled_lights(Scene *scene);
+
   struct IESSlot {
     IESFile ies;
     uint hash;
@@ -158,6 +169,47 @@ class LightManager {
   bool last_background_enabled;
   int last_background_resolution;
 
+  /* Hash of the background shader graph, its images and the resolution the background
+   * importance map on the device was built for, empty if there is no map. */
+  string last_background_map_hash;
+
+  /* Emissive triangles are cached across updates, since gathering them requires reading every
+   * mesh in the scene. They are invalidated when meshes, objects or shaders are modified. */
+  struct EmissiveTriangles {
+    bool valid = false;
+
+    /* Triangle and object index of every emissive triangle, in scene order. */
+    vector<std::pair<int, int>> triangles;
+    /* Offset of the triangles of every object in the `triangle_to_tree` lookup table. */
+    vector<uint> object_lookup_offsets;
+    size_t total_triangles = 0;
+
+    /* Light tree primitives, created on demand when the light tree is used. */
+    vector<LightTreePrimitive> tree_prims;
+
+    /* Light distribution with non-normalized cumulative area, created on demand when the
+     * light distribution is used. */
+    vector<KernelLightDistribution> distribution;
+    float total_area = 0.0f;
+
+    void clear()
+    {
+      *this = EmissiveTriangles();
+    }
+  } emissive_triangles;
+
+  /* Light tree of the last update, along with its primitives in tree order and the index of
+   * the primitive of every scene light (-1 for disabled lights). Used to refit the tree when
+   * only properties of lights were modified. */
+  unique_ptr<LightTree> light_tree;
+  vector<LightTreePrimitive> light_tree_prims;
+  vector<int> light_tree_light_prims;
+
+  /* Enabled state and type of every light in the last complete update (-1 for disabled lights).
+   * The light distribution and tree only depend on which lights are enabled and whether they
+   * are distant, so they can be reused when this is unchanged. */
+  vector<int> last_enabled_lights;
+
   uint32_t update_flags;
 };
 
@@ -2,8 +2,12 @@
  * Copyright 2011-2022 Blender Foundation */
 
 #include "scene/light_tree.h"
+#include "scene/light.h"
 #include "scene/mesh.h"
 #include "scene/object.h"
+#include "scene/scene.h"
+
+#include "util/task.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -196,6 +200,69 @@ LightTreePrimitive::LightTreePrimitive(Scene *scene, int prim_id, int object_id)
   }
 }
 
+/* Parallel reduction over the primitives in [start, end).
+ *
+ * Ranges larger than REDUCE_CHUNK_SIZE are split into fixed size chunks which are reduced in
+ * parallel, and the partial results are then combined in chunk order. Orientation bounds
+ * merging and floating point sums are not associative, so the chunks must not depend on the
+ * number of threads for the result to be deterministic. */
+template<typename T, typename ReduceFunc, typename CombineFunc>
+static T light_tree_reduce(const int start,
+                           const int end,
+                           const T &identity,
+                           const ReduceFunc &reduce,
+                           const CombineFunc &combine)
+{
+  const int chunk_size = LightTree::REDUCE_CHUNK_SIZE;
+  const int num_chunks = divide_up(end - start, chunk_size);
+
+  if (num_chunks <= 1) {
+    T result = identity;
+    reduce(start, end, result);
+    return result;
+  }
+
+  vector<T> partial(num_chunks, identity);
+  parallel_for(0, num_chunks, [&](const int chunk) {
+    const int chunk_start = start + chunk * chunk_size;
+    const int chunk_end = min(chunk_start + chunk_size, end);
+    reduce(chunk_start, chunk_end, partial[chunk]);
+  });
+
+  T result = partial[0];
+  for (int chunk = 1; chunk < num_chunks; chunk++) {
+    combine(result, partial[chunk]);
+  }
+  return result;
+}
+
+/* Bounds of a range of primitives, used to create a node. */
+struct LightTreeRangeBounds {
+  BoundBox bbox = BoundBox::empty;
+  OrientationBounds bcone = OrientationBounds::empty;
+  BoundBox centroid_bbox = BoundBox::empty;
+  float energy = 0.0f;
+};
+
+/* Buckets of all three dimensions, used to find the split with the lowest cost. */
+struct LightTreeBuckets {
+  LightTreeBucketInfo buckets[3][LightTreeBucketInfo::num_buckets];
+};
+
+/* Append the nodes of a subtree that was built into its own array, offsetting the child
+ * indices of interior nodes by the position of the subtree in `nodes`. */
+static void light_tree_append_subtree(vector<LightTreeNode> &nodes,
+                                      const vector<LightTreeNode> &subtree)
+{
+  const int offset = nodes.size();
+  for (const LightTreeNode &node : subtree) {
+    nodes.push_back(node);
+    if (!node.is_leaf()) {
+      nodes.back().right_child_index += offset;
+    }
+  }
+}
+
 LightTree::LightTree(vector<LightTreePrimitive> &prims,
                      const int &num_distant_lights,
                      uint max_lights_in_leaf)
@@ -210,8 +277,8 @@ LightTree::LightTree(vector<LightTreePrimitive> &prims,
   /* The amount of nodes is estimated to be twice the amount of primitives */
   nodes_.reserve(2 * num_prims);
 
-  nodes_.emplace_back();                             /* root node */
-  recursive_build(0, num_local_lights, prims, 0, 1); /* build tree */
+  nodes_.emplace_back();                                     /* root node */
+  recursive_build(0, num_local_lights, prims, 0, 1, nodes_); /* build tree */
   nodes_[0].make_interior(nodes_.size());
 
   /* All distant lights are grouped to one node (right child of the root node) */
@@ -226,6 +293,22 @@ LightTree::LightTree(vector<LightTreePrimitive> &prims,
   nodes_.back().make_leaf(num_local_lights, num_distant_lights);
 
   nodes_.shrink_to_fit();
+
+  /* Children are always stored after their parent, with the left child directly following it. */
+  node_parents_.resize(nodes_.size(), -1);
+  prim_leaves_.resize(num_prims, -1);
+  for (int index = 0; index < nodes_.size(); index++) {
+    const LightTreeNode &node = nodes_[index];
+    if (node.is_leaf()) {
+      for (int i = 0; i < node.num_prims; i++) {
+        prim_leaves_[node.first_prim_index + i] = index;
+      }
+    }
+    else {
+      node_parents_[index + 1] = index;
+      node_parents_[node.right_child_index] = index;
+    }
+  }
 }
 
 const vector<LightTreeNode> &LightTree::get_nodes() const
@@ -233,26 +316,96 @@ const vector<LightTreeNode> &LightTree::get_nodes() const
   return nodes_;
 }
 
-int LightTree::recursive_build(
-    int start, int end, vector<LightTreePrimitive> &prims, uint bit_trail, int depth)
+vector<int> LightTree::refit(const vector<LightTreePrimitive> &prims,
+                             const vector<int> &modified_prims)
 {
-  BoundBox bbox = BoundBox::empty;
-  OrientationBounds bcone = OrientationBounds::empty;
-  BoundBox centroid_bounds = BoundBox::empty;
-  float energy_total = 0.0;
-  int num_prims = end - start;
-  int current_index = nodes_.size();
+  /* Gather the modified leaves and all their ancestors, except for the root node which is not
+   * used for sampling. */
+  vector<int> modified_nodes;
+  for (const int prim : modified_prims) {
+    for (int index = prim_leaves_[prim]; index > 0; index = node_parents_[index]) {
+      modified_nodes.push_back(index);
+    }
+  }
 
-  for (int i = start; i < end; i++) {
-    const LightTreePrimitive &prim = prims.at(i);
-    bbox.grow(prim.bbox);
-    bcone = merge(bcone, prim.bcone);
-    centroid_bounds.grow(prim.centroid);
+  /* Update in reverse order, so that children are updated before their parents. */
+  std::sort(modified_nodes.begin(), modified_nodes.end(), std::greater<int>());
+  modified_nodes.erase(std::unique(modified_nodes.begin(), modified_nodes.end()),
+                       modified_nodes.end());
 
-    energy_total += prim.energy;
+  const int distant_index = nodes_[0].right_child_index;
+
+  for (const int index : modified_nodes) {
+    LightTreeNode &node = nodes_[index];
+
+    BoundBox bbox = BoundBox::empty;
+    OrientationBounds bcone = OrientationBounds::empty;
+    float energy_total = 0.0f;
+
+    if (node.is_leaf()) {
+      for (int i = node.first_prim_index; i < node.first_prim_index + node.num_prims; i++) {
+        const LightTreePrimitive &prim = prims[i];
+        bbox.grow(prim.bbox);
+        bcone = merge(bcone, prim.bcone);
+        energy_total += prim.energy;
+      }
+      if (index == distant_index) {
+        /* Distant lights have no spatial bounds. */
+        bbox = BoundBox::empty;
+      }
+    }
+    else {
+      const LightTreeNode &left = nodes_[index + 1];
+      const LightTreeNode &right = nodes_[node.right_child_index];
+      bbox = merge(left.bbox, right.bbox);
+      bcone = merge(left.bcone, right.bcone);
+      energy_total = left.energy + right.energy;
+    }
+
+    node.bbox = bbox;
+    node.bcone = bcone;
+    node.energy = energy_total;
   }
 
-  nodes_.emplace_back(bbox, bcone, energy_total, bit_trail);
+  return modified_nodes;
+}
+
+int LightTree::recursive_build(int start,
+                               int end,
+                               vector<LightTreePrimitive> &prims,
+                               uint bit_trail,
+                               int depth,
+                               vector<LightTreeNode> &nodes)
+{
+  int num_prims = end - start;
+  int current_index = nodes.size();
+
+  const LightTreeRangeBounds bounds = light_tree_reduce(
+      start,
+      end,
+      LightTreeRangeBounds(),
+      [&](const int range_start, const int range_end, LightTreeRangeBounds &result) {
+        for (int i = range_start; i < range_end; i++) {
+          const LightTreePrimitive &prim = prims[i];
+          result.bbox.grow(prim.bbox);
+          result.bcone = merge(result.bcone, prim.bcone);
+          result.centroid_bbox.grow(prim.centroid);
+          result.energy += prim.energy;
+        }
+      },
+      [](LightTreeRangeBounds &result, const LightTreeRangeBounds &other) {
+        result.bbox.grow(other.bbox);
+        result.bcone = merge(result.bcone, other.bcone);
+        result.centroid_bbox.grow(other.centroid_bbox);
+        result.energy += other.energy;
+      });
+
+  const BoundBox &bbox = bounds.bbox;
+  const OrientationBounds &bcone = bounds.bcone;
+  const BoundBox &centroid_bounds = bounds.centroid_bbox;
+  const float energy_total = bounds.energy;
+
+  nodes.emplace_back(bbox, bcone, energy_total, bit_trail);
 
   bool try_splitting = num_prims > 1 && len(centroid_bounds.size()) > 0.0f;
   int split_dim = -1, split_bucket = 0, num_left_prims = 0;
@@ -283,13 +436,38 @@ int LightTree::recursive_build(
       middle = (start + end) / 2;
     }
 
-    [[maybe_unused]] int left_index = recursive_build(start, middle, prims, bit_trail, depth + 1);
-    int right_index = recursive_build(middle, end, prims, bit_trail | (1u << depth), depth + 1);
-    assert(left_index == current_index + 1);
-    nodes_[current_index].make_interior(right_index);
+    const uint right_bit_trail = bit_trail | (1u << depth);
+    int right_index;
+
+    if (num_prims < THREAD_TASK_SIZE) {
+      /* Local build. */
+      [[maybe_unused]] int left_index = recursive_build(
+          start, middle, prims, bit_trail, depth + 1, nodes);
+      right_index = recursive_build(middle, end, prims, right_bit_trail, depth + 1, nodes);
+      assert(left_index == current_index + 1);
+    }
+    else {
+      /* Threaded build. The right subtree is built into its own array by a task, while the
+       * left subtree is built in place. Both work on disjoint primitive ranges. Appending the
+       * right subtree afterwards gives the same depth-first layout as the local build. */
+      vector<LightTreeNode> right_nodes;
+      right_nodes.reserve(2 * (end - middle));
+
+      TaskPool pool;
+      pool.push([&] {
+        recursive_build(middle, end, prims, right_bit_trail, depth + 1, right_nodes);
+      });
+      recursive_build(start, middle, prims, bit_trail, depth + 1, nodes);
+      pool.wait_work();
+
+      right_index = nodes.size();
+      light_tree_append_subtree(nodes, right_nodes);
+    }
+
+    nodes[current_index].make_interior(right_index);
   }
   else {
-    nodes_[current_index].make_leaf(start, num_prims);
+    nodes[current_index].make_leaf(start, num_prims);
   }
   return current_index;
 }
@@ -318,34 +496,62 @@ float LightTree::min_split_saoh(const BoundBox &centroid_bbox,
   const float3 extent = centroid_bbox.size();
   const float max_extent = max4(extent.x, extent.y, extent.z, 0.0f);
 
+  /* Fill in buckets with primitives, for all dimensions at once so that the primitives are
+   * only traversed once. If the centroid bounding box is 0 along a given dimension, skip it. */
+  const LightTreeBuckets all_buckets = light_tree_reduce(
+      start,
+      end,
+      LightTreeBuckets(),
+      [&](const int range_start, const int range_end, LightTreeBuckets &result) {
+        for (int dim = 0; dim < 3; dim++) {
+          if (extent[dim] == 0.0f) {
+            continue;
+          }
+
+          const float inv_extent = 1 / extent[dim];
+          LightTreeBucketInfo *buckets = result.buckets[dim];
+
+          for (int i = range_start; i < range_end; i++) {
+            const LightTreePrimitive &prim = prims[i];
+
+            /* Place primitive into the appropriate bucket,
+             * where the centroid box is split into equal partitions. */
+            int bucket_idx = LightTreeBucketInfo::num_buckets *
+                             (prim.centroid[dim] - centroid_bbox.min[dim]) * inv_extent;
+            if (bucket_idx == LightTreeBucketInfo::num_buckets) {
+              bucket_idx = LightTreeBucketInfo::num_buckets - 1;
+            }
+
+            buckets[bucket_idx].count++;
+            buckets[bucket_idx].energy += prim.energy;
+            buckets[bucket_idx].bbox.grow(prim.bbox);
+            buckets[bucket_idx].bcone = merge(buckets[bucket_idx].bcone, prim.bcone);
+          }
+        }
+      },
+      [](LightTreeBuckets &result, const LightTreeBuckets &other) {
+        for (int dim = 0; dim < 3; dim++) {
+          for (int i = 0; i < LightTreeBucketInfo::num_buckets; i++) {
+            LightTreeBucketInfo &bucket = result.buckets[dim][i];
+            const LightTreeBucketInfo &other_bucket = other.buckets[dim][i];
+            bucket.count += other_bucket.count;
+            bucket.energy += other_bucket.energy;
+            bucket.bbox.grow(other_bucket.bbox);
+            bucket.bcone = merge(bucket.bcone, other_bucket.bcone);
+          }
+        }
+      });
+
   /* Check each dimension to find the minimum splitting cost. */
   float min_cost = FLT_MAX;
   for (int dim = 0; dim < 3; dim++) {
     /* If the centroid bounding box is 0 along a given dimension, skip it. */
-    if (centroid_bbox.size()[dim] == 0.0f) {
+    if (extent[dim] == 0.0f) {
       continue;
     }
 
-    const float inv_extent = 1 / (centroid_bbox.size()[dim]);
-
-    /* Fill in buckets with primitives. */
-    vector<LightTreeBucketInfo> buckets(LightTreeBucketInfo::num_buckets);
-    for (int i = start; i < end; i++) {
-      const LightTreePrimitive &prim = prims[i];
-
-      /* Place primitive into the appropriate bucket,
-       * where the centroid box is split into equal partitions. */
-      int bucket_idx = LightTreeBucketInfo::num_buckets *
-                       (prim.centroid[dim] - centroid_bbox.min[dim]) * inv_extent;
-      if (bucket_idx == LightTreeBucketInfo::num_buckets) {
-        bucket_idx = LightTreeBucketInfo::num_buckets - 1;
-      }
-
-      buckets[bucket_idx].count++;
-      buckets[bucket_idx].energy += prim.energy;
-      buckets[bucket_idx].bbox.grow(prim.bbox);
-      buckets[bucket_idx].bcone = merge(buckets[bucket_idx].bcone, prim.bcone);
-    }
+    const float inv_extent = 1 / extent[dim];
+    const LightTreeBucketInfo *buckets = all_buckets.buckets[dim];
 
     /* Calculate the cost of splitting at each point between partitions. */
     vector<float> bucket_costs(LightTreeBucketInfo::num_buckets - 1);
@@ -4,15 +4,14 @@
 #ifndef __LIGHT_TREE_H__
 #define __LIGHT_TREE_H__
 
-#include "scene/light.h"
-#include "scene/scene.h"
-
 #include "util/boundbox.h"
 #include "util/types.h"
 #include "util/vector.h"
 
 CCL_NAMESPACE_BEGIN
 
+class Scene;
+
 /* Orientation Bounds
  *
  * Bounds the normal axis of the lights,
@@ -65,6 +64,9 @@ struct LightTreePrimitive {
   OrientationBounds bcone;
   BoundBox bbox;
 
+  /* Default constructed primitives are uninitialized, they are used to pre-allocate arrays
+   * which are filled in parallel. */
+  LightTreePrimitive() = default;
   LightTreePrimitive(Scene *scene, int prim_id, int object_id);
 
   inline bool is_triangle() const
@@ -134,6 +136,10 @@ class LightTree {
   vector<LightTreeNode> nodes_;
   uint max_lights_in_leaf_;
 
+  /* Parent of every node and leaf of every primitive, used for refitting. */
+  vector<int> node_parents_;
+  vector<int> prim_leaves_;
+
  public:
   LightTree(vector<LightTreePrimitive> &prims,
             const int &num_distant_lights,
@@ -141,9 +147,26 @@ class LightTree {
 
   const vector<LightTreeNode> &get_nodes() const;
 
+  /* Refit the tree after the primitives with the given indices were modified in place.
+   * Only the leaves containing them and their ancestors are updated, the topology of the tree
+   * is kept. Returns the indices of the updated nodes. */
+  vector<int> refit(const vector<LightTreePrimitive> &prims, const vector<int> &modified_prims);
+
+  /* Threads.
+   *
+   * Subtrees with more primitives than THREAD_TASK_SIZE are built in parallel. Bounds and
+   * split buckets of large primitive ranges are reduced in parallel, in chunks of
+   * REDUCE_CHUNK_SIZE primitives. The chunk size does not depend on the number of threads,
+   * so the tree is identical for any number of threads. */
+  enum { THREAD_TASK_SIZE = 4096, REDUCE_CHUNK_SIZE = 4096 };
+
  private:
-  int recursive_build(
-      int start, int end, vector<LightTreePrimitive> &prims, uint bit_trail, int depth);
+  int recursive_build(int start,
+                      int end,
+                      vector<LightTreePrimitive> &prims,
+                      uint bit_trail,
+                      int depth,
+                      vector<LightTreeNode> &nodes);
   float min_split_saoh(const BoundBox &centroid_bbox,
                        int start,
                        int end,
@@ -150,7 +150,10 @@ static void read_shader_output(const Scene *scene,
   }
 }
 
-bool GeometryManager::displace(Device *device, Scene *scene, Mesh *mesh, Progress &progress)
+bool GeometryManager::displace(ShaderEval &shader_eval,
+                               Scene *scene,
+                               Mesh *mesh,
+                               Progress &progress)
 {
   /* verify if we have a displacement shader */
   if (!mesh->has_true_displacement()) {
@@ -178,7 +181,6 @@ bool GeometryManager::displace(Device *device, Scene *scene, Mesh *mesh, Progres
   }
 
   /* Evaluate shader on device. */
-  ShaderEval shader_eval(device, progress);
   if (!shader_eval.eval(SHADER_EVAL_DISPLACE,
                         num_verts,
                         3,
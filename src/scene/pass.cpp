@@ -134,7 +134,7 @@ NODE_DEFINE(Pass)
   return type;
 }
 
-Pass::Pass() : Node(get_node_type()), is_auto_(false)
+Pass::Pass() : Node(get_node_type()), is_auto_(false), use_half_storage_(false)
 {
 }
 
@@ -148,6 +148,11 @@ bool Pass::is_written() const
   return get_info().is_written;
 }
 
+int Pass::get_storage_size() const
+{
+  return pass_storage_size(get_info().num_components, use_half_storage_);
+}
+
 PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bool is_lightgroup)
 {
   PassInfo pass_info;
@@ -180,6 +185,7 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
       break;
     case PASS_NORMAL:
       pass_info.num_components = 3;
+      pass_info.support_half = true;
       break;
     case PASS_ROUGHNESS:
       pass_info.num_components = 1;
@@ -282,9 +288,11 @@ PassInfo Pass::get_info(const PassType type, const bool include_albedo, const bo
 
     case PASS_DENOISING_NORMAL:
       pass_info.num_components = 3;
+      pass_info.support_half = true;
       break;
     case PASS_DENOISING_ALBEDO:
       pass_info.num_components = 3;
+      pass_info.support_half = true;
       break;
     case PASS_DENOISING_DEPTH:
       pass_info.num_components = 1;
@@ -413,7 +421,7 @@ int Pass::get_offset(const vector<Pass *> &passes, const Pass *pass)
       }
     }
     if (current_pass->is_written()) {
-      pass_offset += current_pass->get_info().num_components;
+      pass_offset += current_pass->get_storage_size();
     }
   }
 
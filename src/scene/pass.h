@@ -43,8 +43,19 @@ struct PassInfo {
 
   /* Pass supports denoising. */
   bool support_denoise = false;
+
+  /* Pass accumulates bounded per-sample values, so that it can be stored in half float when
+   * lower precision render buffers are requested. */
+  bool support_half = false;
 };
 
+/* Number of floats a pass occupies in the render buffer.
+ * Components of passes stored in half float are packed in pairs into a single float. */
+inline int pass_storage_size(const int num_components, const bool use_half_storage)
+{
+  return use_half_storage ? (num_components + 1) / 2 : num_components;
+}
+
 class Pass : public Node {
  public:
   NODE_DECLARE
@@ -64,11 +75,23 @@ class Pass : public Node {
    * pixels allocated to save memory. */
   bool is_written() const;
 
+  /* The pass is stored in half float in the render buffer. */
+  inline bool get_use_half_storage() const
+  {
+    return use_half_storage_;
+  }
+
+  /* Number of floats the pass occupies in the render buffer. */
+  int get_storage_size() const;
+
  protected:
   /* The has been created automatically as a requirement to various rendering functionality (such
    * as adaptive sampling). */
   bool is_auto_;
 
+  /* Set by the film for passes which support half float storage when it is enabled. */
+  bool use_half_storage_;
+
  public:
   static const NodeEnum *get_type_enum();
   static const NodeEnum *get_mode_enum();
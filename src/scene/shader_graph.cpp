@@ -10,6 +10,7 @@
 
 #include "util/algorithm.h"
 #include "util/foreach.h"
+#include "util/hash.h"
 #include "util/log.h"
 #include "util/md5.h"
 #include "util/queue.h"
@@ -28,11 +29,55 @@ bool check_node_inputs_has_links(const ShaderNode *node)
   return false;
 }
 
-bool check_node_inputs_traversed(const ShaderNode *node, const ShaderNodeSet &done)
+/* Hash settings of the node and its input links. */
+void hash_node(MD5Hash &md5, ShaderNode *node)
+{
+  node->hash(md5);
+  foreach (ShaderInput *input, node->inputs) {
+    int link_id = (input->link) ? input->link->parent->id : 0;
+    md5.append((uint8_t *)&link_id, sizeof(link_id));
+    md5.append((input->link) ? input->link->name().c_str() : "");
+  }
+
+  if (node->special_type == SHADER_SPECIAL_TYPE_OSL) {
+    /* Hash takes into account socket values, to detect changes
+     * in the code of the node we need an exception. */
+    OSLNode *oslnode = static_cast<OSLNode *>(node);
+    md5.append(oslnode->bytecode_hash);
+  }
+}
+
+/* Set of nodes of a graph stored as flags indexed by node id, which is cheaper to query and
+ * update than a ShaderNodeSet for traversals of the whole graph. Nodes can be added to the graph
+ * while the set is in use, the storage grows as needed. */
+class ShaderNodeIDSet {
+ public:
+  explicit ShaderNodeIDSet(const size_t num_node_ids) : flags(num_node_ids, false)
+  {
+  }
+
+  bool contains(const ShaderNode *node) const
+  {
+    return size_t(node->id) < flags.size() && flags[node->id];
+  }
+
+  void insert(const ShaderNode *node)
+  {
+    if (size_t(node->id) >= flags.size()) {
+      flags.resize(node->id + 1, false);
+    }
+    flags[node->id] = true;
+  }
+
+ private:
+  vector<bool> flags;
+};
+
+bool check_node_inputs_traversed(const ShaderNode *node, const ShaderNodeIDSet &done)
 {
   foreach (const ShaderInput *in, node->inputs) {
     if (in->link) {
-      if (done.find(in->link->parent) == done.end()) {
+      if (!done.contains(in->link->parent)) {
         return false;
       }
     }
@@ -40,6 +85,65 @@ bool check_node_inputs_traversed(const ShaderNode *node, const ShaderNodeSet &do
   return true;
 }
 
+uint hash_float_value(const float value)
+{
+  /* Negative and positive zero compare equal. */
+  return hash_uint(__float_as_uint(value + 0.0f));
+}
+
+uint hash_float3_value(const float3 value)
+{
+  return hash_uint3(
+      hash_float_value(value.x), hash_float_value(value.y), hash_float_value(value.z));
+}
+
+/* Hash of the settings and input links of the node used to find candidates for deduplication.
+ * Nodes which are equal according to ShaderNode::equals() have the same hash. Socket types which
+ * are rarely used by nodes are not included in the hash, leaving it up to the full comparison. */
+uint deduplicate_hash(ShaderNode *node)
+{
+  uint hash = hash_uint2(hash_uint(uint(uintptr_t(node->type))), node->bump);
+
+  auto hash_socket_value = [node](const SocketType &socket) -> uint {
+    switch (socket.type) {
+      case SocketType::BOOLEAN:
+        return hash_uint(node->get_bool(socket));
+      case SocketType::INT:
+      case SocketType::ENUM:
+        return hash_uint(node->get_int(socket));
+      case SocketType::UINT:
+        return hash_uint(node->get_uint(socket));
+      case SocketType::FLOAT:
+        return hash_float_value(node->get_float(socket));
+      case SocketType::COLOR:
+      case SocketType::VECTOR:
+      case SocketType::POINT:
+      case SocketType::NORMAL:
+        return hash_float3_value(node->get_float3(socket));
+      default:
+        return 0;
+    }
+  };
+
+  foreach (const SocketType &socket, node->type->inputs) {
+    if (!(socket.flags & SocketType::LINKABLE)) {
+      hash = hash_uint2(hash, hash_socket_value(socket));
+    }
+  }
+
+  foreach (const ShaderInput *input, node->inputs) {
+    if (input->link) {
+      const uintptr_t link = uintptr_t(input->link);
+      hash = hash_uint3(hash, uint(link), uint(uint64_t(link) >> 32));
+    }
+    else {
+      hash = hash_uint2(hash, hash_socket_value(input->socket_type));
+    }
+  }
+
+  return hash;
+}
+
 } /* namespace */
 
 /* Sockets */
@@ -525,7 +629,7 @@ void ShaderGraph::remove_proxy_nodes()
  */
 void ShaderGraph::constant_fold(Scene *scene)
 {
-  ShaderNodeSet done, scheduled;
+  ShaderNodeIDSet done(num_node_ids), scheduled(num_node_ids);
   queue<ShaderNode *> traverse_queue;
 
   bool has_displacement = (output()->input("Displacement")->link != NULL);
@@ -550,7 +654,7 @@ void ShaderGraph::constant_fold(Scene *scene)
        * when possible. Do it before disconnect.
        */
       foreach (ShaderInput *input, output->links) {
-        if (scheduled.find(input->parent) != scheduled.end()) {
+        if (scheduled.contains(input->parent)) {
           /* Node might not be optimized yet but scheduled already
            * by other dependencies. No need to re-schedule it.
            */
@@ -600,8 +704,8 @@ void ShaderGraph::deduplicate_nodes()
    *   already deduplicated.
    */
 
-  ShaderNodeSet scheduled, done;
-  map<ustring, ShaderNodeSet> candidates;
+  ShaderNodeIDSet scheduled(num_node_ids), done(num_node_ids);
+  unordered_map<uint, vector<ShaderNode *>> candidates;
   queue<ShaderNode *> traverse_queue;
   int num_deduplicated = 0;
 
@@ -622,7 +726,7 @@ void ShaderGraph::deduplicate_nodes()
     foreach (ShaderOutput *output, node->outputs) {
       foreach (ShaderInput *input, output->links) {
         has_output_links = true;
-        if (scheduled.find(input->parent) != scheduled.end()) {
+        if (scheduled.contains(input->parent)) {
           /* Node might not be optimized yet but scheduled already
            * by other dependencies. No need to re-schedule it.
            */
@@ -639,10 +743,12 @@ void ShaderGraph::deduplicate_nodes()
     if (!has_output_links) {
       continue;
     }
-    /* Try to merge this node with another one. */
+    /* Try to merge this node with another one. Candidates are grouped by hash of their settings
+     * and links, so only nodes which are likely to be equal are compared. */
+    vector<ShaderNode *> &node_candidates = candidates[deduplicate_hash(node)];
     ShaderNode *merge_with = NULL;
-    foreach (ShaderNode *other_node, candidates[node->type->name]) {
-      if (node != other_node && node->equals(*other_node)) {
+    foreach (ShaderNode *other_node, node_candidates) {
+      if (node != other_node && node->type == other_node->type && node->equals(*other_node)) {
         merge_with = other_node;
         break;
       }
@@ -655,7 +761,7 @@ void ShaderGraph::deduplicate_nodes()
       num_deduplicated++;
     }
     else {
-      candidates[node->type->name].insert(node);
+      node_candidates.push_back(node);
     }
   }
 
@@ -675,7 +781,7 @@ void ShaderGraph::verify_volume_output()
     return;
   }
   bool has_valid_volume = false;
-  ShaderNodeSet scheduled;
+  ShaderNodeIDSet scheduled(num_node_ids);
   queue<ShaderNode *> traverse_queue;
   /* Schedule volume output. */
   traverse_queue.push(volume_in->link->parent);
@@ -693,7 +799,7 @@ void ShaderGraph::verify_volume_output()
       if (input->link == NULL) {
         continue;
       }
-      if (scheduled.find(input->link->parent) != scheduled.end()) {
+      if (scheduled.contains(input->link->parent)) {
         continue;
       }
       traverse_queue.push(input->link->parent);
@@ -746,22 +852,32 @@ void ShaderGraph::compute_displacement_hash()
 
   MD5Hash md5;
   foreach (ShaderNode *node, nodes_displace) {
-    node->hash(md5);
-    foreach (ShaderInput *input, node->inputs) {
-      int link_id = (input->link) ? input->link->parent->id : 0;
-      md5.append((uint8_t *)&link_id, sizeof(link_id));
-      md5.append((input->link) ? input->link->name().c_str() : "");
-    }
+    hash_node(md5, node);
+  }
+
+  displacement_hash = md5.get_hex();
+}
+
+string ShaderGraph::compute_hash()
+{
+  /* Compute hash of all nodes of the graph, to detect graphs which compile into the same
+   * program. In addition to the settings of the nodes this includes state which is not stored
+   * in sockets but is used by the compilation. */
+  MD5Hash md5;
+  foreach (ShaderNode *node, nodes) {
+    hash_node(md5, node);
 
-    if (node->special_type == SHADER_SPECIAL_TYPE_OSL) {
-      /* Hash takes into account socket values, to detect changes
-       * in the code of the node we need an exception. */
-      OSLNode *oslnode = static_cast<OSLNode *>(node);
-      md5.append(oslnode->bytecode_hash);
+    md5.append((uint8_t *)&node->id, sizeof(node->id));
+    md5.append((uint8_t *)&node->bump, sizeof(node->bump));
+
+    if (node->special_type == SHADER_SPECIAL_TYPE_OUTPUT_AOV) {
+      OutputAOVNode *aov_node = static_cast<OutputAOVNode *>(node);
+      md5.append((uint8_t *)&aov_node->offset, sizeof(aov_node->offset));
+      md5.append((uint8_t *)&aov_node->is_color, sizeof(aov_node->is_color));
     }
   }
 
-  displacement_hash = md5.get_hex();
+  return md5.get_hex();
 }
 
 void ShaderGraph::clean(Scene *scene)
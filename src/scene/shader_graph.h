@@ -211,6 +211,22 @@ class ShaderNode : public Node {
   {
     return false;
   }
+
+  /* Check whether the node acquires scene resources such as image slots when it is compiled.
+   * Programs of graphs with such nodes are not shared with other graphs. */
+  virtual bool has_compile_resources()
+  {
+    return false;
+  }
+
+  /* Get the input which has to be above zero for the given input to be used by the closure, or
+   * NULL if the input is always used. The SVM compiler skips computing such inputs at runtime
+   * when their weight is zero. */
+  virtual ShaderInput *get_input_weight(ShaderInput * /*input*/)
+  {
+    return NULL;
+  }
+
   vector<ShaderInput *> inputs;
   vector<ShaderOutput *> outputs;
 
@@ -317,6 +333,8 @@ class ShaderGraph : public NodeOwner {
 
   void remove_proxy_nodes();
   void compute_displacement_hash();
+  /* Hash of all nodes and links, graphs with equal hash compile into the same SVM program. */
+  string compute_hash();
   void simplify(Scene *scene);
   void finalize(Scene *scene,
                 bool do_bump = false,
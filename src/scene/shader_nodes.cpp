@@ -2944,24 +2944,60 @@ void PrincipledBsdfNode::compile(SVMCompiler &compiler,
 
   compiler.add_node(NODE_CLOSURE_SET_WEIGHT, weight);
 
+  /* Leave out lobes which are statically known to contribute nothing, so their parameters are
+   * neither put on the stack nor loaded by the kernel. A fully metallic material has no diffuse
+   * and transmission part, which also disables sheen. */
+  const bool is_metallic = !p_metallic->link && get_float(p_metallic->socket_type) >= 1.0f;
+  uint lobes = 0;
+  if (p_subsurface->link || get_float(p_subsurface->socket_type) != 0.0f) {
+    lobes |= NODE_PRINCIPLED_SUBSURFACE;
+  }
+  if (!is_metallic &&
+      (p_sheen->link || get_float(p_sheen->socket_type) > CLOSURE_WEIGHT_CUTOFF)) {
+    lobes |= NODE_PRINCIPLED_SHEEN;
+  }
+  if (p_clearcoat->link || get_float(p_clearcoat->socket_type) > 0.0f) {
+    lobes |= NODE_PRINCIPLED_CLEARCOAT;
+  }
+  if (!is_metallic &&
+      (p_transmission->link || get_float(p_transmission->socket_type) > 0.0f)) {
+    lobes |= NODE_PRINCIPLED_TRANSMISSION;
+  }
+
+  const bool use_subsurface = (lobes & NODE_PRINCIPLED_SUBSURFACE);
+  const bool use_sheen = (lobes & NODE_PRINCIPLED_SHEEN);
+  const bool use_clearcoat = (lobes & NODE_PRINCIPLED_CLEARCOAT);
+  const bool use_transmission = (lobes & NODE_PRINCIPLED_TRANSMISSION);
+
   int normal_offset = compiler.stack_assign_if_linked(normal_in);
-  int clearcoat_normal_offset = compiler.stack_assign_if_linked(clearcoat_normal_in);
+  int clearcoat_normal_offset = (use_clearcoat) ?
+                                    compiler.stack_assign_if_linked(clearcoat_normal_in) :
+                                    SVM_STACK_INVALID;
   int tangent_offset = compiler.stack_assign_if_linked(tangent_in);
   int specular_offset = compiler.stack_assign(p_specular);
   int roughness_offset = compiler.stack_assign(p_roughness);
   int specular_tint_offset = compiler.stack_assign(p_specular_tint);
   int anisotropic_offset = compiler.stack_assign(p_anisotropic);
-  int sheen_offset = compiler.stack_assign(p_sheen);
-  int sheen_tint_offset = compiler.stack_assign(p_sheen_tint);
-  int clearcoat_offset = compiler.stack_assign(p_clearcoat);
-  int clearcoat_roughness_offset = compiler.stack_assign(p_clearcoat_roughness);
-  int ior_offset = compiler.stack_assign(p_ior);
-  int transmission_offset = compiler.stack_assign(p_transmission);
-  int transmission_roughness_offset = compiler.stack_assign(p_transmission_roughness);
+  int sheen_offset = (use_sheen) ? compiler.stack_assign(p_sheen) : SVM_STACK_INVALID;
+  int sheen_tint_offset = (use_sheen) ? compiler.stack_assign(p_sheen_tint) : SVM_STACK_INVALID;
+  int clearcoat_offset = (use_clearcoat) ? compiler.stack_assign(p_clearcoat) :
+                                           SVM_STACK_INVALID;
+  int clearcoat_roughness_offset = (use_clearcoat) ? compiler.stack_assign(p_clearcoat_roughness) :
+                                                     SVM_STACK_INVALID;
+  int ior_offset = (use_transmission) ? compiler.stack_assign(p_ior) : SVM_STACK_INVALID;
+  int transmission_offset = (use_transmission) ? compiler.stack_assign(p_transmission) :
+                                                 SVM_STACK_INVALID;
+  int transmission_roughness_offset = (use_transmission) ?
+                                          compiler.stack_assign(p_transmission_roughness) :
+                                          SVM_STACK_INVALID;
   int anisotropic_rotation_offset = compiler.stack_assign(p_anisotropic_rotation);
-  int subsurface_radius_offset = compiler.stack_assign(p_subsurface_radius);
-  int subsurface_ior_offset = compiler.stack_assign(p_subsurface_ior);
-  int subsurface_anisotropy_offset = compiler.stack_assign(p_subsurface_anisotropy);
+  int subsurface_radius_offset = (use_subsurface) ? compiler.stack_assign(p_subsurface_radius) :
+                                                    SVM_STACK_INVALID;
+  int subsurface_ior_offset = (use_subsurface) ? compiler.stack_assign(p_subsurface_ior) :
+                                                 SVM_STACK_INVALID;
+  int subsurface_anisotropy_offset = (use_subsurface) ?
+                                         compiler.stack_assign(p_subsurface_anisotropy) :
+                                         SVM_STACK_INVALID;
 
   compiler.add_node(NODE_CLOSURE_BSDF,
                     compiler.encode_uchar4(closure,
@@ -2985,7 +3021,7 @@ void PrincipledBsdfNode::compile(SVMCompiler &compiler,
                                            transmission_roughness_offset),
                     distribution,
                     subsurface_method,
-                    SVM_STACK_INVALID);
+                    lobes);
 
   float3 bc_default = get_float3(base_color_in->socket_type);
 
@@ -3002,8 +3038,9 @@ void PrincipledBsdfNode::compile(SVMCompiler &compiler,
 
   float3 ss_default = get_float3(subsurface_color_in->socket_type);
 
-  compiler.add_node(((subsurface_color_in->link) ? compiler.stack_assign(subsurface_color_in) :
-                                                   SVM_STACK_INVALID),
+  compiler.add_node(((use_subsurface && subsurface_color_in->link) ?
+                         compiler.stack_assign(subsurface_color_in) :
+                         SVM_STACK_INVALID),
                     __float_as_int(ss_default.x),
                     __float_as_int(ss_default.y),
                     __float_as_int(ss_default.z));
@@ -3049,6 +3086,29 @@ bool PrincipledBsdfNode::has_bssrdf_bump()
   return has_surface_bssrdf() && has_bump();
 }
 
+ShaderInput *PrincipledBsdfNode::get_input_weight(ShaderInput *input)
+{
+  /* Parameters of lobes which are not evaluated when the lobe weight is zero. The subsurface
+   * color is not included, it is mixed into the base color. */
+  const ustring name = input->name();
+
+  if (name == "Subsurface Radius" || name == "Subsurface IOR" ||
+      name == "Subsurface Anisotropy") {
+    return this->input("Subsurface");
+  }
+  if (name == "Sheen Tint") {
+    return this->input("Sheen");
+  }
+  if (name == "Clearcoat Roughness" || name == "Clearcoat Normal") {
+    return this->input("Clearcoat");
+  }
+  if (name == "Transmission Roughness" || name == "IOR") {
+    return this->input("Transmission");
+  }
+
+  return NULL;
+}
+
 /* Translucent BSDF Closure */
 
 NODE_DEFINE(TranslucentBsdfNode)
@@ -78,6 +78,11 @@ class ImageSlotTextureNode : public TextureNode {
     special_type = SHADER_SPECIAL_TYPE_IMAGE_SLOT;
   }
 
+  virtual bool has_compile_resources()
+  {
+    return true;
+  }
+
   virtual bool equals(const ShaderNode &other)
   {
     const ImageSlotTextureNode &other_node = (const ImageSlotTextureNode &)other;
@@ -169,6 +174,11 @@ class SkyTextureNode : public TextureNode {
   NODE_SOCKET_API(float3, vector)
   ImageHandle handle;
 
+  bool has_compile_resources()
+  {
+    return true;
+  }
+
   float get_sun_size()
   {
     /* Clamping for numerical precision. */
@@ -354,6 +364,11 @@ class PointDensityTextureNode : public ShaderNode {
     return true;
   }
 
+  bool has_compile_resources()
+  {
+    return true;
+  }
+
   /* Parameters. */
   NODE_SOCKET_API(ustring, filename)
   NODE_SOCKET_API(NodeTexVoxelSpace, space)
@@ -380,6 +395,11 @@ class IESLightNode : public TextureNode {
   ~IESLightNode();
   ShaderNode *clone(ShaderGraph *graph) const;
 
+  bool has_compile_resources()
+  {
+    return true;
+  }
+
   NODE_SOCKET_API(ustring, filename)
   NODE_SOCKET_API(ustring, ies)
 
@@ -531,6 +551,7 @@ class PrincipledBsdfNode : public BsdfBaseNode {
   void expand(ShaderGraph *graph);
   bool has_surface_bssrdf();
   bool has_bssrdf_bump();
+  ShaderInput *get_input_weight(ShaderInput *input);
   void compile(SVMCompiler &compiler,
                ShaderInput *metallic,
                ShaderInput *subsurface,
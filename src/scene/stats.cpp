@@ -33,6 +33,12 @@ bool namedTimeSampleEntryComparator(const NamedNestedSampleStats &a,
   return a.sum_samples > b.sum_samples;
 }
 
+bool namedBVHStatsComparator(const NamedBVHStats &a, const NamedBVHStats &b)
+{
+  /* We sort in descending order. */
+  return a.stats.total_memory() > b.stats.total_memory();
+}
+
 bool namedSampleCountPairComparator(const NamedSampleCountPair &a, const NamedSampleCountPair &b)
 {
   return a.samples > b.samples;
@@ -239,6 +245,111 @@ string ImageStats::full_report(int indent_level)
   return result;
 }
 
+/* BVH statistics. */
+
+NamedBVHStats::NamedBVHStats(const string &name, const BVHStats &stats) : name(name), stats(stats)
+{
+}
+
+string NamedBVHStats::full_report(int indent_level) const
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const string double_indent = indent + indent;
+  string result = "";
+  result += string_printf("%s%s (%s):\n", indent.c_str(), name.c_str(), stats.builder);
+  result += string_printf("%s  Build time: %fs\n", indent.c_str(), stats.build_time);
+
+  if (stats.num_nodes != 0) {
+    result += string_printf("%s  SAH cost: %f\n", indent.c_str(), (double)stats.sah_cost);
+    result += string_printf("%s  Nodes: %s (inner %s, leaf %s, unaligned %s)\n",
+                            indent.c_str(),
+                            string_human_readable_number(stats.num_nodes).c_str(),
+                            string_human_readable_number(stats.num_inner_nodes).c_str(),
+                            string_human_readable_number(stats.num_leaf_nodes).c_str(),
+                            string_human_readable_number(stats.num_unaligned_nodes).c_str());
+    result += string_printf("%s  Maximum depth: %d\n", indent.c_str(), stats.max_depth);
+  }
+
+  result += string_printf("%s  References: %s (original %s, duplicated %.2f%%)\n",
+                          indent.c_str(),
+                          string_human_readable_number(stats.num_references).c_str(),
+                          string_human_readable_number(stats.num_original_references).c_str(),
+                          (double)stats.duplication_ratio() * 100.0);
+
+  if (stats.total_memory() != 0) {
+    result += string_printf("%s  Memory: %s\n",
+                            indent.c_str(),
+                            string_human_readable_size(stats.total_memory()).c_str());
+    result += string_printf("%s%-32s %s\n",
+                            double_indent.c_str(),
+                            "Aligned inner nodes",
+                            string_human_readable_size(stats.aligned_node_memory).c_str());
+    result += string_printf("%s%-32s %s\n",
+                            double_indent.c_str(),
+                            "Unaligned inner nodes",
+                            string_human_readable_size(stats.unaligned_node_memory).c_str());
+    result += string_printf("%s%-32s %s\n",
+                            double_indent.c_str(),
+                            "Leaf nodes",
+                            string_human_readable_size(stats.leaf_node_memory).c_str());
+    result += string_printf("%s%-32s %s\n",
+                            double_indent.c_str(),
+                            "Primitive references",
+                            string_human_readable_size(stats.primitive_memory).c_str());
+  }
+
+  if (!stats.leaf_size_histogram.empty()) {
+    result += indent + "  Leaf size histogram:\n";
+    for (size_t i = 0; i < stats.leaf_size_histogram.size(); i++) {
+      if (stats.leaf_size_histogram[i] != 0) {
+        result += string_printf("%s%4d primitives: %s\n",
+                                double_indent.c_str(),
+                                (int)i,
+                                string_human_readable_number(stats.leaf_size_histogram[i]).c_str());
+      }
+    }
+  }
+
+  if (!stats.depth_histogram.empty()) {
+    result += indent + "  Leaf depth histogram:\n";
+    for (size_t i = 0; i < stats.depth_histogram.size(); i++) {
+      if (stats.depth_histogram[i] != 0) {
+        result += string_printf("%sdepth %4d: %s\n",
+                                double_indent.c_str(),
+                                (int)i,
+                                string_human_readable_number(stats.depth_histogram[i]).c_str());
+      }
+    }
+  }
+
+  return result;
+}
+
+BVHTreeStats::BVHTreeStats() : total_memory(0)
+{
+}
+
+void BVHTreeStats::add_entry(const NamedBVHStats &entry)
+{
+  total_memory += entry.stats.total_memory();
+  entries.push_back(entry);
+}
+
+string BVHTreeStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += string_printf("%sTotal memory: %s (%s)\n",
+                          indent.c_str(),
+                          string_human_readable_size(total_memory).c_str(),
+                          string_human_readable_number(total_memory).c_str());
+  sort(entries.begin(), entries.end(), namedBVHStatsComparator);
+  foreach (const NamedBVHStats &entry, entries) {
+    result += entry.full_report(indent_level + 1);
+  }
+  return result;
+}
+
 /* Overall statistics. */
 
 RenderStats::RenderStats()
@@ -302,6 +413,7 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "BVH statistics:\n" + bvh.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
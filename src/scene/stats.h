@@ -6,6 +6,8 @@
 
 #include "scene/scene.h"
 
+#include "bvh/bvh.h"
+
 #include "util/stats.h"
 #include "util/string.h"
 #include "util/vector.h"
@@ -160,6 +162,35 @@ class ImageStats {
   NamedSizeStats textures;
 };
 
+/* Statistics of a single BVH tree. */
+class NamedBVHStats {
+ public:
+  NamedBVHStats(const string &name, const BVHStats &stats);
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0) const;
+
+  string name;
+  BVHStats stats;
+};
+
+/* Statistics about the BVH trees of the scene: the top level BVH and the
+ * BVHs of instanced geometry. */
+class BVHTreeStats {
+ public:
+  BVHTreeStats();
+
+  void add_entry(const NamedBVHStats &entry);
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Total memory of all trees. */
+  size_t total_memory;
+
+  vector<NamedBVHStats> entries;
+};
+
 /* Render process statistics. */
 class RenderStats {
  public:
@@ -175,6 +206,7 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  BVHTreeStats bvh;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
@@ -15,6 +15,7 @@
 
 #include "util/foreach.h"
 #include "util/log.h"
+#include "util/murmurhash.h"
 #include "util/progress.h"
 #include "util/task.h"
 
@@ -34,20 +35,116 @@ void SVMShaderManager::reset(Scene * /*scene*/)
 {
 }
 
+/* Check whether programs compiled from the graph can be shared with other graphs. */
+static bool shader_graph_has_compile_resources(ShaderGraph *graph)
+{
+  foreach (ShaderNode *node, graph->nodes) {
+    if (node->has_compile_resources()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SVMShaderManager::Program::store_shader_flags(const Shader *shader)
+{
+  has_surface = shader->has_surface;
+  has_surface_transparent = shader->has_surface_transparent;
+  has_surface_raytrace = shader->has_surface_raytrace;
+  has_surface_bssrdf = shader->has_surface_bssrdf;
+  has_surface_spatial_varying = shader->has_surface_spatial_varying;
+  has_bump = shader->has_bump;
+  has_bssrdf_bump = shader->has_bssrdf_bump;
+  has_volume = shader->has_volume;
+  has_volume_spatial_varying = shader->has_volume_spatial_varying;
+  has_volume_attribute_dependency = shader->has_volume_attribute_dependency;
+  has_displacement = shader->has_displacement;
+  has_integrator_dependency = shader->has_integrator_dependency;
+}
+
+void SVMShaderManager::Program::restore_shader_flags(Shader *shader) const
+{
+  shader->has_surface = has_surface;
+  shader->has_surface_transparent = has_surface_transparent;
+  shader->has_surface_raytrace = has_surface_raytrace;
+  shader->has_surface_bssrdf = has_surface_bssrdf;
+  shader->has_surface_spatial_varying = has_surface_spatial_varying;
+  shader->has_bump = has_bump;
+  shader->has_bssrdf_bump = has_bssrdf_bump;
+  shader->has_volume = has_volume;
+  shader->has_volume_spatial_varying = has_volume_spatial_varying;
+  shader->has_volume_attribute_dependency = has_volume_attribute_dependency;
+  shader->has_displacement = has_displacement;
+  shader->has_integrator_dependency = has_integrator_dependency;
+}
+
+bool SVMShaderManager::Program::nodes_equal(const Program &other) const
+{
+  if (this == &other) {
+    return true;
+  }
+  return nodes_hash == other.nodes_hash && svm_nodes.size() == other.svm_nodes.size() &&
+         memcmp(svm_nodes.data(), other.svm_nodes.data(), sizeof(int4) * svm_nodes.size()) == 0;
+}
+
 void SVMShaderManager::device_update_shader(Scene *scene,
                                             Shader *shader,
                                             Progress *progress,
-                                            array<int4> *svm_nodes)
+                                            ShaderProgram *shader_program)
 {
   if (progress->get_cancel()) {
     return;
   }
   assert(shader->graph);
 
+  const double time_start = time_dt();
+
   SVMCompiler::Summary summary;
   SVMCompiler compiler(scene);
   compiler.background = (shader == scene->background->get_shader(scene));
-  compiler.compile(shader, *svm_nodes, 0, &summary);
+  compiler.finalize(shader, &summary);
+
+  shader_program->background = compiler.background;
+
+  /* Look up program of a graph with the same structure, compiled with the same settings. */
+  string hash;
+  if (!shader_graph_has_compile_resources(shader->graph)) {
+    hash = shader->graph->compute_hash() +
+           string_printf(":%d:%d:%d",
+                         compiler.background,
+                         int(shader->get_displacement_method()),
+                         shader->reference_count() != 0);
+
+    thread_scoped_lock lock(program_cache_mutex);
+    const auto it = program_cache.find(hash);
+    if (it != program_cache.end()) {
+      shader_program->program = it->second;
+      lock.unlock();
+
+      shader_program->program->restore_shader_flags(shader);
+      shader->estimate_emission();
+
+      VLOG_WORK << "Using cached SVM program for shader " << shader->name << " ("
+                << shader_program->program->num_instructions << " instructions)";
+      return;
+    }
+  }
+
+  std::shared_ptr<Program> program = std::make_shared<Program>();
+  compiler.generate(shader, program->svm_nodes, 0, &summary);
+  program->store_shader_flags(shader);
+  program->num_instructions = summary.num_svm_instructions;
+  program->nodes_hash = util_murmur_hash3(
+      program->svm_nodes.data(), sizeof(int4) * program->svm_nodes.size(), 0);
+
+  summary.time_total = time_dt() - time_start;
+
+  if (!hash.empty()) {
+    thread_scoped_lock lock(program_cache_mutex);
+    program_cache[hash] = program;
+  }
+
+  shader_program->program = program;
 
   VLOG_WORK << "Compilation summary:\n"
             << "Shader name: " << shader->name << "\n"
@@ -74,19 +171,36 @@ void SVMShaderManager::device_update_specific(Device *device,
 
   double start_time = time_dt();
 
-  /* test if we need to update */
-  device_free(device, dscene, scene);
+  /* Integrator settings are used when simplifying graphs, so shaders which depend on them are to
+   * be compiled again when the integrator is modified. */
+  const bool integrator_modified = (update_flags & INTEGRATOR_MODIFIED) != 0;
 
-  /* Build all shaders. */
+  /* Build modified shaders, other shaders keep their program from the previous update. */
   TaskPool task_pool;
-  vector<array<int4>> shader_svm_nodes(num_shaders);
+  vector<ShaderProgram> shader_svm_programs(num_shaders);
+  vector<bool> shader_compiled(num_shaders, false);
+  int num_compiled = 0;
   for (int i = 0; i < num_shaders; i++) {
+    Shader *shader = scene->shaders[i];
+    const bool background = (shader == scene->background->get_shader(scene));
+
+    const auto it = shader_programs.find(shader);
+    if (it != shader_programs.end() && !shader->is_modified() &&
+        it->second.background == background &&
+        !(integrator_modified && shader->has_integrator_dependency))
+    {
+      shader_svm_programs[i] = it->second;
+      continue;
+    }
+
     task_pool.push(function_bind(&SVMShaderManager::device_update_shader,
                                  this,
                                  scene,
-                                 scene->shaders[i],
+                                 shader,
                                  &progress,
-                                 &shader_svm_nodes[i]));
+                                 &shader_svm_programs[i]));
+    shader_compiled[i] = true;
+    num_compiled++;
   }
   task_pool.wait_work();
 
@@ -94,60 +208,141 @@ void SVMShaderManager::device_update_specific(Device *device,
     return;
   }
 
-  /* The global node list contains a jump table (one node per shader)
-   * followed by the nodes of all shaders. */
-  int svm_nodes_size = num_shaders;
+  /* Shaders which compiled into the same nodes share them, with their jump table entries pointing
+   * to the same location in the global node list. */
+  vector<std::shared_ptr<Program>> programs;
+  vector<int> shader_program_index(num_shaders);
+  unordered_multimap<uint32_t, int> program_index_by_hash;
   for (int i = 0; i < num_shaders; i++) {
-    /* Since we're not copying the local jump node, the size ends up being one node lower. */
-    svm_nodes_size += shader_svm_nodes[i].size() - 1;
+    const std::shared_ptr<Program> &program = shader_svm_programs[i].program;
+
+    int program_index = -1;
+    const auto range = program_index_by_hash.equal_range(program->nodes_hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (programs[it->second]->nodes_equal(*program)) {
+        program_index = it->second;
+        break;
+      }
+    }
+
+    if (program_index == -1) {
+      program_index = programs.size();
+      programs.push_back(program);
+      program_index_by_hash.emplace(program->nodes_hash, program_index);
+    }
+
+    shader_program_index[i] = program_index;
   }
 
-  int4 *svm_nodes = dscene->svm_nodes.alloc(svm_nodes_size);
+  const int num_programs = programs.size();
+
+  /* The global node list contains a jump table (one node per shader)
+   * followed by the nodes of all programs. When the programs are used by the same shaders and
+   * have the same size as the ones in the current list, only the nodes of the programs which
+   * changed are replaced. */
+  bool update_layout = (device_shader_program_index != shader_program_index);
+  for (int i = 0; i < num_programs && !update_layout; i++) {
+    if (device_programs[i]->svm_nodes.size() != programs[i]->svm_nodes.size()) {
+      update_layout = true;
+    }
+  }
+
+  if (update_layout) {
+    device_programs.resize(num_programs);
+    device_program_offsets.resize(num_programs);
+    device_shader_program_index = shader_program_index;
+
+    int svm_nodes_size = num_shaders;
+    for (int i = 0; i < num_programs; i++) {
+      /* Since we're not copying the local jump node, the size ends up being one node lower. */
+      device_program_offsets[i] = svm_nodes_size;
+      svm_nodes_size += programs[i]->svm_nodes.size() - 1;
+    }
+
+    dscene->svm_nodes.alloc(svm_nodes_size);
+  }
+
+  int4 *svm_nodes = dscene->svm_nodes.data();
+
+  /* Copy the nodes of each program into the correct location. */
+  vector<bool> program_updated(num_programs, update_layout);
+  int num_updated = 0;
+  for (int i = 0; i < num_programs; i++) {
+    const std::shared_ptr<Program> &program = programs[i];
+
+    if (!update_layout && device_programs[i]->nodes_equal(*program)) {
+      device_programs[i] = program;
+      continue;
+    }
+
+    const int program_size = program->svm_nodes.size() - 1;
+    memcpy(svm_nodes + device_program_offsets[i],
+           &program->svm_nodes[1],
+           sizeof(int4) * program_size);
+
+    device_programs[i] = program;
+    program_updated[i] = true;
+    num_updated++;
+  }
 
-  int node_offset = num_shaders;
   for (int i = 0; i < num_shaders; i++) {
     Shader *shader = scene->shaders[i];
 
+    if (shader_compiled[i] || update_layout) {
+      if (shader->emission_sampling != EMISSION_SAMPLING_NONE) {
+        scene->light_manager->tag_update(scene, LightManager::SHADER_COMPILED);
+      }
+    }
     shader->clear_modified();
-    if (shader->emission_sampling != EMISSION_SAMPLING_NONE) {
-      scene->light_manager->tag_update(scene, LightManager::SHADER_COMPILED);
+
+    const int program_index = shader_program_index[i];
+    if (!program_updated[program_index]) {
+      continue;
     }
 
     /* Update the global jump table.
      * Each compiled shader starts with a jump node that has offsets local
      * to the shader, so copy those and add the offset into the global node list. */
+    const int node_offset = device_program_offsets[program_index];
     int4 &global_jump_node = svm_nodes[shader->id];
-    int4 &local_jump_node = shader_svm_nodes[i][0];
+    const int4 &local_jump_node = programs[program_index]->svm_nodes[0];
 
     global_jump_node.x = NODE_SHADER_JUMP;
     global_jump_node.y = local_jump_node.y - 1 + node_offset;
     global_jump_node.z = local_jump_node.z - 1 + node_offset;
     global_jump_node.w = local_jump_node.w - 1 + node_offset;
+  }
 
-    node_offset += shader_svm_nodes[i].size() - 1;
+  if (update_layout || num_updated) {
+    dscene->svm_nodes.copy_to_device();
   }
 
-  /* Copy the nodes of each shader into the correct location. */
-  svm_nodes += num_shaders;
+  /* Remember programs of the current shaders, forgetting about shaders which were removed. */
+  shader_programs.clear();
   for (int i = 0; i < num_shaders; i++) {
-    int shader_size = shader_svm_nodes[i].size() - 1;
-
-    memcpy(svm_nodes, &shader_svm_nodes[i][1], sizeof(int4) * shader_size);
-    svm_nodes += shader_size;
+    shader_programs[scene->shaders[i]] = shader_svm_programs[i];
   }
 
-  if (progress.get_cancel()) {
-    return;
+  /* Keep programs which are no longer used for a while, but do not let the cache grow without
+   * bounds while editing shaders. */
+  if (program_cache.size() > 2 * size_t(num_shaders)) {
+    for (auto it = program_cache.begin(); it != program_cache.end();) {
+      if (it->second.use_count() == 1) {
+        it = program_cache.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
   }
 
-  dscene->svm_nodes.copy_to_device();
-
   device_update_common(device, dscene, scene, progress);
 
   update_flags = UPDATE_NONE;
 
-  VLOG_INFO << "Shader manager updated " << num_shaders << " shaders in " << time_dt() - start_time
-            << " seconds.";
+  VLOG_INFO << "Shader manager updated " << num_shaders << " shaders, compiled " << num_compiled
+            << ", stored " << num_programs << " unique programs and replaced " << num_updated
+            << " in the node list, in " << time_dt() - start_time << " seconds.";
 }
 
 void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *scene)
@@ -155,6 +350,10 @@ void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *s
   device_free_common(device, dscene, scene);
 
   dscene->svm_nodes.free();
+
+  device_programs.clear();
+  device_program_offsets.clear();
+  device_shader_program_index.clear();
 }
 
 /* Graph Compiler */
@@ -162,6 +361,8 @@ void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *s
 SVMCompiler::SVMCompiler(Scene *scene) : scene(scene)
 {
   max_stack_use = 0;
+  num_instructions = 0;
+  num_fused_nodes = 0;
   current_type = SHADER_TYPE_SURFACE;
   current_shader = NULL;
   current_graph = NULL;
@@ -256,22 +457,25 @@ int SVMCompiler::stack_assign(ShaderInput *input)
     else {
       Node *node = input->parent;
 
-      /* not linked to output -> add nodes to load default value */
+      /* not linked to output -> queue load of default value, which is emitted together with
+       * the other constant inputs of the node */
       input->stack_offset = stack_find_offset(input->type());
 
       if (input->type() == SocketType::FLOAT) {
-        add_node(NODE_VALUE_F,
-                 __float_as_int(node->get_float(input->socket_type)),
-                 input->stack_offset);
+        pending_float_values.push_back(
+            make_int2(input->stack_offset, __float_as_int(node->get_float(input->socket_type))));
       }
       else if (input->type() == SocketType::INT) {
-        add_node(NODE_VALUE_F, node->get_int(input->socket_type), input->stack_offset);
+        pending_float_values.push_back(
+            make_int2(input->stack_offset, node->get_int(input->socket_type)));
       }
       else if (input->type() == SocketType::VECTOR || input->type() == SocketType::NORMAL ||
                input->type() == SocketType::POINT || input->type() == SocketType::COLOR) {
-
-        add_node(NODE_VALUE_V, input->stack_offset);
-        add_node(NODE_VALUE_V, node->get_float3(input->socket_type));
+        const float3 value = node->get_float3(input->socket_type);
+        pending_vector_values.push_back(make_int4(input->stack_offset,
+                                                  __float_as_int(value.x),
+                                                  __float_as_int(value.y),
+                                                  __float_as_int(value.z)));
       }
       else /* should not get called for closure */
         assert(0);
@@ -372,26 +576,76 @@ uint SVMCompiler::encode_uchar4(uint x, uint y, uint z, uint w)
   return (x) | (y << 8) | (z << 16) | (w << 24);
 }
 
+void SVMCompiler::flush_value_nodes()
+{
+  const int num_floats = pending_float_values.size();
+  const int num_vectors = pending_vector_values.size();
+  if (num_floats + num_vectors == 0) {
+    return;
+  }
+
+  if (num_floats + num_vectors == 1) {
+    /* A single constant is loaded by its own node, which is not any larger. */
+    svm_node_types_used[(num_floats) ? NODE_VALUE_F : NODE_VALUE_V] = true;
+    num_instructions++;
+    if (num_floats) {
+      const int2 value = pending_float_values[0];
+      current_svm_nodes.push_back_slow(make_int4(NODE_VALUE_F, value.y, value.x, 0));
+    }
+    else {
+      const int4 value = pending_vector_values[0];
+      current_svm_nodes.push_back_slow(make_int4(NODE_VALUE_V, value.x, 0, 0));
+      current_svm_nodes.push_back_slow(make_int4(NODE_VALUE_V, value.y, value.z, value.w));
+    }
+  }
+  else {
+    /* Load all constant inputs of the node with one instruction, two floats per node. */
+    svm_node_types_used[NODE_VALUES] = true;
+    num_instructions++;
+    current_svm_nodes.push_back_slow(make_int4(NODE_VALUES, num_floats, num_vectors, 0));
+    for (int i = 0; i < num_floats; i += 2) {
+      const int2 a = pending_float_values[i];
+      const int2 b = (i + 1 < num_floats) ? pending_float_values[i + 1] : make_int2(0, 0);
+      current_svm_nodes.push_back_slow(make_int4(a.x, a.y, b.x, b.y));
+    }
+    for (const int4 &value : pending_vector_values) {
+      current_svm_nodes.push_back_slow(value);
+    }
+  }
+
+  pending_float_values.clear();
+  pending_vector_values.clear();
+}
+
 void SVMCompiler::add_node(int a, int b, int c, int d)
 {
+  flush_value_nodes();
   current_svm_nodes.push_back_slow(make_int4(a, b, c, d));
 }
 
 void SVMCompiler::add_node(ShaderNodeType type, int a, int b, int c)
 {
+  flush_value_nodes();
   svm_node_types_used[type] = true;
+  num_instructions++;
   current_svm_nodes.push_back_slow(make_int4(type, a, b, c));
 }
 
 void SVMCompiler::add_node(ShaderNodeType type, const float3 &f)
 {
+  flush_value_nodes();
   svm_node_types_used[type] = true;
+  /* NODE_VALUE_V stores its value in a second node which is not an instruction. */
+  if (type != NODE_VALUE_V) {
+    num_instructions++;
+  }
   current_svm_nodes.push_back_slow(
       make_int4(type, __float_as_int(f.x), __float_as_int(f.y), __float_as_int(f.z)));
 }
 
 void SVMCompiler::add_node(const float4 &f)
 {
+  flush_value_nodes();
   current_svm_nodes.push_back_slow(make_int4(
       __float_as_int(f.x), __float_as_int(f.y), __float_as_int(f.z), __float_as_int(f.w)));
 }
@@ -451,6 +705,108 @@ void SVMCompiler::generate_node(ShaderNode *node, ShaderNodeSet &done)
   }
 }
 
+bool SVMCompiler::generate_math_chain(ShaderNode *node,
+                                      const ShaderNodeSet &nodes,
+                                      CompilerState *state)
+{
+  const NodeType *math_node_type = MathNode::get_node_type();
+  if (node->type != math_node_type) {
+    return false;
+  }
+
+  ShaderNodeSet &done = state->nodes_done;
+  vector<bool> &done_flag = state->nodes_done_flag;
+
+  /* Follow the output as long as its only user is another math node which is compiled as part of
+   * the same set of nodes, and of which all other inputs are available. The input linked to the
+   * previous node of the chain is stored along with the node. */
+  vector<ShaderNode *> chain;
+  vector<ShaderInput *> chain_inputs;
+  chain.push_back(node);
+  chain_inputs.push_back(NULL);
+
+  for (ShaderNode *current = node;;) {
+    ShaderOutput *value_out = current->output("Value");
+    if (value_out->links.size() != 1) {
+      break;
+    }
+
+    ShaderInput *next_in = value_out->links[0];
+    ShaderNode *next = next_in->parent;
+    if (next->type != math_node_type || done_flag[next->id] || nodes.find(next) == nodes.end()) {
+      break;
+    }
+
+    bool inputs_done = true;
+    foreach (ShaderInput *input, next->inputs) {
+      if (input != next_in && input->link && !done_flag[input->link->parent->id]) {
+        inputs_done = false;
+      }
+    }
+    if (!inputs_done) {
+      break;
+    }
+
+    chain.push_back(next);
+    chain_inputs.push_back(next_in);
+    current = next;
+  }
+
+  if (chain.size() < 2) {
+    return false;
+  }
+
+  /* Encode one step per node. The result of the previous step is kept in a register, unlinked
+   * inputs are stored inline instead of being loaded onto the stack by separate value nodes. */
+  const char *input_names[3] = {"Value1", "Value2", "Value3"};
+  vector<int4> steps;
+
+  for (size_t i = 0; i < chain.size(); i++) {
+    MathNode *math_node = static_cast<MathNode *>(chain[i]);
+    uint kind[3];
+    int value[3];
+
+    for (int j = 0; j < 3; j++) {
+      ShaderInput *input = math_node->input(input_names[j]);
+
+      if (input == chain_inputs[i]) {
+        kind[j] = NODE_MATH_CHAIN_PREVIOUS;
+        value[j] = 0;
+      }
+      else if (input->link) {
+        kind[j] = NODE_MATH_CHAIN_STACK;
+        value[j] = stack_assign(input);
+      }
+      else {
+        kind[j] = NODE_MATH_CHAIN_CONSTANT;
+        value[j] = __float_as_int(math_node->get_float(input->socket_type));
+      }
+    }
+
+    steps.push_back(make_int4(encode_uchar4(math_node->get_math_type(), kind[0], kind[1], kind[2]),
+                              value[0],
+                              value[1],
+                              value[2]));
+  }
+
+  add_node(NODE_MATH_CHAIN, steps.size(), stack_assign(chain.back()->output("Value")));
+  foreach (const int4 &step, steps) {
+    add_node(step.x, step.y, step.z, step.w);
+  }
+
+  foreach (ShaderNode *chain_node, chain) {
+    done.insert(chain_node);
+    done_flag[chain_node->id] = true;
+  }
+  foreach (ShaderNode *chain_node, chain) {
+    stack_clear_users(chain_node, done);
+  }
+
+  num_fused_nodes += chain.size();
+
+  return true;
+}
+
 void SVMCompiler::generate_svm_nodes(const ShaderNodeSet &nodes, CompilerState *state)
 {
   ShaderNodeSet &done = state->nodes_done;
@@ -470,9 +826,11 @@ void SVMCompiler::generate_svm_nodes(const ShaderNodeSet &nodes, CompilerState *
           }
         }
         if (inputs_done) {
-          generate_node(node, done);
-          done.insert(node);
-          done_flag[node->id] = true;
+          if (!generate_math_chain(node, nodes, state)) {
+            generate_node(node, done);
+            done.insert(node);
+            done_flag[node->id] = true;
+          }
         }
         else {
           nodes_done = false;
@@ -493,13 +851,16 @@ void SVMCompiler::generate_closure_node(ShaderNode *node, CompilerState *state)
 
   /* execute dependencies for closure */
   foreach (ShaderInput *in, node->inputs) {
-    if (in->link != NULL) {
+    ShaderInput *weight_in = node->get_input_weight(in);
+    if (in->link != NULL && !(weight_in && weight_in->link)) {
       ShaderNodeSet dependencies;
       find_dependencies(dependencies, state->nodes_done, in);
       generate_svm_nodes(dependencies, state);
     }
   }
 
+  generate_weighted_dependencies(node, state);
+
   /* closure mix weight */
   const char *weight_name = (current_type == SHADER_TYPE_VOLUME) ? "VolumeMixWeight" :
                                                                    "SurfaceMixWeight";
@@ -529,6 +890,100 @@ void SVMCompiler::generate_closure_node(ShaderNode *node, CompilerState *state)
   }
 }
 
+/* Check whether all users of the node are either in the given set or are one of the given inputs
+ * of the closure node. */
+static bool node_used_only_by(ShaderNode *node,
+                              const ShaderNodeSet &users,
+                              ShaderNode *closure_node,
+                              const vector<ShaderInput *> &closure_inputs)
+{
+  foreach (ShaderOutput *output, node->outputs) {
+    foreach (ShaderInput *input, output->links) {
+      if (input->parent == closure_node) {
+        if (std::find(closure_inputs.begin(), closure_inputs.end(), input) ==
+            closure_inputs.end()) {
+          return false;
+        }
+      }
+      else if (users.find(input->parent) == users.end()) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void SVMCompiler::generate_weighted_dependencies(ShaderNode *node, CompilerState *state)
+{
+  /* Find the weights with a runtime value, inputs with a constant weight are generated along
+   * with the other dependencies of the closure. */
+  vector<ShaderInput *> weights;
+  foreach (ShaderInput *in, node->inputs) {
+    ShaderInput *weight_in = (in->link) ? node->get_input_weight(in) : NULL;
+    if (weight_in && weight_in->link &&
+        std::find(weights.begin(), weights.end(), weight_in) == weights.end()) {
+      weights.push_back(weight_in);
+    }
+  }
+
+  foreach (ShaderInput *weight_in, weights) {
+    vector<ShaderInput *> weighted_inputs;
+    ShaderNodeSet dependencies;
+    foreach (ShaderInput *in, node->inputs) {
+      if (in->link && node->get_input_weight(in) == weight_in) {
+        weighted_inputs.push_back(in);
+        find_dependencies(dependencies, state->nodes_done, in);
+      }
+    }
+
+    /* Only nodes which are used for nothing but these inputs can be skipped. Others, including
+     * the nodes they depend on, are needed unconditionally. */
+    ShaderNodeSet exclusive = dependencies;
+    bool changed;
+    do {
+      changed = false;
+      for (ShaderNodeSet::iterator it = exclusive.begin(); it != exclusive.end();) {
+        if (state->aov_nodes.find(*it) != state->aov_nodes.end() ||
+            !node_used_only_by(*it, exclusive, node, weighted_inputs)) {
+          it = exclusive.erase(it);
+          changed = true;
+        }
+        else {
+          ++it;
+        }
+      }
+    } while (changed);
+
+    ShaderNodeSet shared;
+    ShaderNodeIDComparator node_id_comp;
+    set_difference(dependencies.begin(),
+                   dependencies.end(),
+                   exclusive.begin(),
+                   exclusive.end(),
+                   std::inserter(shared, shared.begin()),
+                   node_id_comp);
+    generate_svm_nodes(shared, state);
+
+    if (!exclusive.empty()) {
+      /* Add instruction to skip the nodes if the weight is zero. */
+      const int weight_offset = stack_assign(weight_in);
+      flush_value_nodes();
+      svm_node_types_used[NODE_JUMP_IF_ZERO] = true;
+      num_instructions++;
+      current_svm_nodes.push_back_slow(make_int4(NODE_JUMP_IF_ZERO, 0, weight_offset, 0));
+      int node_jump_skip_index = current_svm_nodes.size() - 1;
+
+      generate_svm_nodes(exclusive, state);
+
+      /* Fill in jump instruction location to be after the nodes. */
+      flush_value_nodes();
+      current_svm_nodes[node_jump_skip_index].y = current_svm_nodes.size() -
+                                                  node_jump_skip_index - 1;
+    }
+  }
+}
+
 void SVMCompiler::generated_shared_closure_nodes(ShaderNode *root_node,
                                                  ShaderNode *node,
                                                  CompilerState *state,
@@ -664,13 +1119,17 @@ void SVMCompiler::generate_multi_closure(ShaderNode *root_node,
         /* Add instruction to skip closure and its dependencies if mix
          * weight is zero.
          */
+        const int facin_offset = stack_assign(facin);
+        flush_value_nodes();
         svm_node_types_used[NODE_JUMP_IF_ONE] = true;
-        current_svm_nodes.push_back_slow(make_int4(NODE_JUMP_IF_ONE, 0, stack_assign(facin), 0));
+        num_instructions++;
+        current_svm_nodes.push_back_slow(make_int4(NODE_JUMP_IF_ONE, 0, facin_offset, 0));
         int node_jump_skip_index = current_svm_nodes.size() - 1;
 
         generate_multi_closure(root_node, cl1in->link->parent, state);
 
         /* Fill in jump instruction location to be after closure. */
+        flush_value_nodes();
         current_svm_nodes[node_jump_skip_index].y = current_svm_nodes.size() -
                                                     node_jump_skip_index - 1;
       }
@@ -680,13 +1139,17 @@ void SVMCompiler::generate_multi_closure(ShaderNode *root_node,
         /* Add instruction to skip closure and its dependencies if mix
          * weight is zero.
          */
+        const int facin_offset = stack_assign(facin);
+        flush_value_nodes();
         svm_node_types_used[NODE_JUMP_IF_ZERO] = true;
-        current_svm_nodes.push_back_slow(make_int4(NODE_JUMP_IF_ZERO, 0, stack_assign(facin), 0));
+        num_instructions++;
+        current_svm_nodes.push_back_slow(make_int4(NODE_JUMP_IF_ZERO, 0, facin_offset, 0));
         int node_jump_skip_index = current_svm_nodes.size() - 1;
 
         generate_multi_closure(root_node, cl2in->link->parent, state);
 
         /* Fill in jump instruction location to be after closure. */
+        flush_value_nodes();
         current_svm_nodes[node_jump_skip_index].y = current_svm_nodes.size() -
                                                     node_jump_skip_index - 1;
       }
@@ -758,6 +1221,10 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   /* clear all compiler state */
   memset((void *)&active_stack, 0, sizeof(active_stack));
   current_svm_nodes.clear();
+  pending_float_values.clear();
+  pending_vector_values.clear();
+  const int start_num_instructions = num_instructions;
+  const int start_num_fused_nodes = num_fused_nodes;
 
   foreach (ShaderNode *node, graph->nodes) {
     foreach (ShaderInput *input, node->inputs)
@@ -832,9 +1299,14 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
     add_node(NODE_LEAVE_BUMP_EVAL, bump_state_offset);
   }
 
+  /* Bump shaders have no end node, so make sure all constant loads are emitted. */
+  flush_value_nodes();
+
   /* if compile failed, generate empty shader */
   if (compile_failed) {
     current_svm_nodes.clear();
+    num_instructions = start_num_instructions;
+    num_fused_nodes = start_num_fused_nodes;
     compile_failed = false;
   }
 
@@ -845,28 +1317,45 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   }
 }
 
-void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary)
+bool SVMCompiler::shader_has_bump(Shader *shader)
 {
-  svm_node_types_used[NODE_SHADER_JUMP] = true;
-  svm_nodes.push_back_slow(make_int4(NODE_SHADER_JUMP, 0, 0, 0));
-
-  /* copy graph for shader with bump mapping */
   ShaderNode *output = shader->graph->output();
-  int start_num_svm_nodes = svm_nodes.size();
+  return (shader->get_displacement_method() != DISPLACE_TRUE) && output->input("Surface")->link &&
+         output->input("Displacement")->link;
+}
+
+void SVMCompiler::finalize(Shader *shader, Summary *summary)
+{
+  scoped_timer timer((summary != NULL) ? &summary->time_finalize : NULL);
+  shader->graph->finalize(scene,
+                          shader_has_bump(shader),
+                          shader->has_integrator_dependency,
+                          shader->get_displacement_method() == DISPLACE_BOTH);
+}
 
+void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary)
+{
   const double time_start = time_dt();
 
-  bool has_bump = (shader->get_displacement_method() != DISPLACE_TRUE) &&
-                  output->input("Surface")->link && output->input("Displacement")->link;
+  finalize(shader, summary);
+  generate(shader, svm_nodes, index, summary);
 
-  /* finalize */
-  {
-    scoped_timer timer((summary != NULL) ? &summary->time_finalize : NULL);
-    shader->graph->finalize(scene,
-                            has_bump,
-                            shader->has_integrator_dependency,
-                            shader->get_displacement_method() == DISPLACE_BOTH);
+  if (summary != NULL) {
+    summary->time_total = time_dt() - time_start;
   }
+}
+
+void SVMCompiler::generate(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary)
+{
+  svm_node_types_used[NODE_SHADER_JUMP] = true;
+  svm_nodes.push_back_slow(make_int4(NODE_SHADER_JUMP, 0, 0, 0));
+
+  num_instructions = 1;
+  num_fused_nodes = 0;
+
+  int start_num_svm_nodes = svm_nodes.size();
+
+  const bool has_bump = shader_has_bump(shader);
 
   current_shader = shader;
 
@@ -921,9 +1410,10 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
 
   /* Fill in summary information. */
   if (summary != NULL) {
-    summary->time_total = time_dt() - time_start;
     summary->peak_stack_usage = max_stack_use;
     summary->num_svm_nodes = svm_nodes.size() - start_num_svm_nodes;
+    summary->num_svm_instructions = num_instructions;
+    summary->num_fused_nodes = num_fused_nodes;
   }
 
   /* Estimate emission for MIS. */
@@ -934,6 +1424,8 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
 
 SVMCompiler::Summary::Summary()
     : num_svm_nodes(0),
+      num_svm_instructions(0),
+      num_fused_nodes(0),
       peak_stack_usage(0),
       time_finalize(0.0),
       time_generate_surface(0.0),
@@ -948,6 +1440,8 @@ string SVMCompiler::Summary::full_report() const
 {
   string report = "";
   report += string_printf("Number of SVM nodes: %d\n", num_svm_nodes);
+  report += string_printf("  Instructions:      %d\n", num_svm_instructions);
+  report += string_printf("  Fused nodes:       %d\n", num_fused_nodes);
   report += string_printf("Peak stack usage:    %d\n", peak_stack_usage);
 
   report += string_printf("Time (in seconds):\n");
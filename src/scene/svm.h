@@ -9,9 +9,11 @@
 #include "scene/shader_graph.h"
 
 #include "util/array.h"
+#include "util/map.h"
 #include "util/set.h"
 #include "util/string.h"
 #include "util/thread.h"
+#include "util/unique_ptr.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -40,10 +42,65 @@ class SVMShaderManager : public ShaderManager {
   void device_free(Device *device, DeviceScene *dscene, Scene *scene) override;
 
  protected:
+  /* SVM program compiled from a shader graph. */
+  struct Program {
+    /* Nodes of the program, starting with a jump node with offsets local to the program. */
+    array<int4> svm_nodes;
+
+    /* Hash of the nodes, to find programs which are identical. */
+    uint32_t nodes_hash = 0;
+
+    /* Number of instructions the program was compiled into, for reporting. */
+    int num_instructions = 0;
+
+    /* Shader flags which are detected during compilation, to restore them when the program is
+     * used for another shader with the same graph. */
+    bool has_surface;
+    bool has_surface_transparent;
+    bool has_surface_raytrace;
+    bool has_surface_bssrdf;
+    bool has_surface_spatial_varying;
+    bool has_bump;
+    bool has_bssrdf_bump;
+    bool has_volume;
+    bool has_volume_spatial_varying;
+    bool has_volume_attribute_dependency;
+    bool has_displacement;
+    bool has_integrator_dependency;
+
+    void store_shader_flags(const Shader *shader);
+    void restore_shader_flags(Shader *shader) const;
+
+    bool nodes_equal(const Program &other) const;
+  };
+
+  /* Program of a shader along with the settings it was compiled with. */
+  struct ShaderProgram {
+    std::shared_ptr<Program> program;
+    bool background = false;
+  };
+
   void device_update_shader(Scene *scene,
                             Shader *shader,
                             Progress *progress,
-                            array<int4> *svm_nodes);
+                            ShaderProgram *shader_program);
+
+  /* Programs of the shaders compiled by the previous update. Shaders which are not modified keep
+   * their program. */
+  unordered_map<const Shader *, ShaderProgram> shader_programs;
+
+  /* Programs which can be shared between shaders with the same graph, by hash of the finalized
+   * graph and compilation settings. Programs stay in the cache after the shaders stop using them,
+   * so that undoing a change does not compile the graph again. */
+  unordered_map<string, std::shared_ptr<Program>> program_cache;
+  thread_mutex program_cache_mutex;
+
+  /* Programs stored in the device SVM nodes array and their offset in the array, along with the
+   * index of the program used by every shader. Shaders with identical programs share the nodes.
+   * Used to only update the ranges of the array which belong to the modified programs. */
+  vector<std::shared_ptr<Program>> device_programs;
+  vector<int> device_program_offsets;
+  vector<int> device_shader_program_index;
 };
 
 /* Graph Compiler */
@@ -56,6 +113,12 @@ class SVMCompiler {
     /* Number of SVM nodes shader was compiled into. */
     int num_svm_nodes;
 
+    /* Number of instructions among the SVM nodes, not counting the data of the instructions. */
+    int num_svm_instructions;
+
+    /* Number of shader nodes which were fused into combined instructions. */
+    int num_fused_nodes;
+
     /* Peak stack usage during shader evaluation. */
     int peak_stack_usage;
 
@@ -84,6 +147,11 @@ class SVMCompiler {
   SVMCompiler(Scene *scene);
   void compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary = NULL);
 
+  /* Compilation in two steps: finalize the graph of the shader, after which its final state can
+   * be inspected, and generate SVM nodes from the finalized graph. */
+  void finalize(Shader *shader, Summary *summary = NULL);
+  void generate(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary = NULL);
+
   int stack_assign(ShaderOutput *output);
   int stack_assign(ShaderInput *input);
   int stack_assign_if_linked(ShaderInput *input);
@@ -186,6 +254,9 @@ class SVMCompiler {
 
   void stack_clear_temporary(ShaderNode *node);
   int stack_size(SocketType::Type type);
+
+  /* Emit the loads of constant inputs which were queued by stack_assign(). */
+  void flush_value_nodes();
   void stack_clear_users(ShaderNode *node, ShaderNodeSet &done);
 
   /* single closure */
@@ -197,8 +268,10 @@ class SVMCompiler {
                                        ShaderGraph *graph,
                                        CompilerState *state);
   void generate_node(ShaderNode *node, ShaderNodeSet &done);
+  bool generate_math_chain(ShaderNode *node, const ShaderNodeSet &nodes, CompilerState *state);
   void generate_aov_node(ShaderNode *node, CompilerState *state);
   void generate_closure_node(ShaderNode *node, CompilerState *state);
+  void generate_weighted_dependencies(ShaderNode *node, CompilerState *state);
   void generated_shared_closure_nodes(ShaderNode *root_node,
                                       ShaderNode *node,
                                       CompilerState *state,
@@ -209,14 +282,21 @@ class SVMCompiler {
   void generate_multi_closure(ShaderNode *root_node, ShaderNode *node, CompilerState *state);
 
   /* compile */
+  static bool shader_has_bump(Shader *shader);
   void compile_type(Shader *shader, ShaderGraph *graph, ShaderType type);
 
   std::atomic_int *svm_node_types_used;
   array<int4> current_svm_nodes;
+  /* Constant inputs to be loaded onto the stack before the next node, as (offset, value) and
+   * (offset, x, y, z). */
+  vector<int2> pending_float_values;
+  vector<int4> pending_vector_values;
   ShaderType current_type;
   Shader *current_shader;
   Stack active_stack;
   int max_stack_use;
+  int num_instructions;
+  int num_fused_nodes;
   uint mix_weight_offset;
   bool compile_failed;
 };
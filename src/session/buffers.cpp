@@ -50,6 +50,7 @@ NODE_DEFINE(BufferPass)
   SOCKET_STRING(name, "Name", ustring());
   SOCKET_BOOLEAN(include_albedo, "Include Albedo", false);
   SOCKET_STRING(lightgroup, "Light Group", ustring());
+  SOCKET_BOOLEAN(use_half_storage, "Use Half Storage", false);
 
   SOCKET_INT(offset, "Offset", -1);
 
@@ -66,7 +67,8 @@ BufferPass::BufferPass(const Pass *scene_pass)
       mode(scene_pass->get_mode()),
       name(scene_pass->get_name()),
       include_albedo(scene_pass->get_include_albedo()),
-      lightgroup(scene_pass->get_lightgroup())
+      lightgroup(scene_pass->get_lightgroup()),
+      use_half_storage(scene_pass->get_use_half_storage())
 {
 }
 
@@ -75,6 +77,11 @@ PassInfo BufferPass::get_info() const
   return Pass::get_info(type, include_albedo, !lightgroup.empty());
 }
 
+int BufferPass::get_storage_size() const
+{
+  return pass_storage_size(get_info().num_components, use_half_storage);
+}
+
 /* --------------------------------------------------------------------
  * Buffer Params.
  */
@@ -131,7 +138,7 @@ void BufferParams::update_passes()
         pass_offset_[index] = pass_stride;
       }
 
-      pass_stride += pass.get_info().num_components;
+      pass_stride += pass.get_storage_size();
     }
   }
 }
@@ -146,7 +153,7 @@ void BufferParams::update_passes(const vector<Pass *> &scene_passes)
 
     if (scene_pass->is_written()) {
       buffer_pass.offset = pass_stride;
-      pass_stride += scene_pass->get_info().num_components;
+      pass_stride += scene_pass->get_storage_size();
     }
     else {
       buffer_pass.offset = PASS_UNUSED;
@@ -31,6 +31,7 @@ class BufferPass : public Node {
   ustring name;
   bool include_albedo = false;
   ustring lightgroup;
+  bool use_half_storage = false;
 
   int offset = -1;
 
@@ -47,11 +48,14 @@ class BufferPass : public Node {
 
   PassInfo get_info() const;
 
+  /* Number of floats the pass occupies in the render buffer. */
+  int get_storage_size() const;
+
   inline bool operator==(const BufferPass &other) const
   {
     return type == other.type && mode == other.mode && name == other.name &&
            include_albedo == other.include_albedo && lightgroup == other.lightgroup &&
-           offset == other.offset;
+           use_half_storage == other.use_half_storage && offset == other.offset;
   }
   inline bool operator!=(const BufferPass &other) const
   {
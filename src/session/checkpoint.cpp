@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#include "session/checkpoint.h"
+
+#include "session/buffers.h"
+#include "util/hash.h"
+#include "util/log.h"
+#include "util/mapped_file.h"
+#include "util/path.h"
+#include "util/types.h"
+
+CCL_NAMESPACE_BEGIN
+
+static const char RENDER_CHECKPOINT_MAGIC[8] = {'C', 'Y', 'C', 'L', 'C', 'K', 'P', 'T'};
+static const uint32_t RENDER_CHECKPOINT_VERSION = 1;
+
+/* Pixels are aligned to the page size, so that the mapped data is suitably aligned. */
+static const size_t RENDER_CHECKPOINT_DATA_ALIGNMENT = 4096;
+
+struct RenderCheckpointHeader {
+  char magic[8];
+  uint32_t version;
+
+  /* Layout of the render buffers. */
+  int32_t width;
+  int32_t height;
+  int32_t pass_stride;
+  uint32_t passes_hash;
+
+  /* Scheduler state. */
+  int32_t num_rendered_samples;
+  int32_t sample_offset;
+  int32_t num_samples;
+  float adaptive_sampling_threshold;
+  double path_trace_time;
+
+  uint64_t data_offset;
+};
+
+/* Hash of the passes layout, to detect checkpoints which were written with different passes. */
+static uint32_t render_checkpoint_passes_hash(const BufferParams &buffer_params)
+{
+  uint32_t hash = hash_uint(buffer_params.passes.size());
+  for (const BufferPass &pass : buffer_params.passes) {
+    hash = hash_uint4(hash, pass.type, static_cast<uint>(pass.mode), pass.offset);
+    hash = hash_uint3(hash, hash_string(pass.name.c_str()), pass.use_half_storage);
+  }
+  return hash;
+}
+
+static uint64_t render_checkpoint_data_size(const BufferParams &buffer_params)
+{
+  return uint64_t(buffer_params.width) * buffer_params.height * buffer_params.pass_stride *
+         sizeof(float);
+}
+
+static const RenderCheckpointHeader *render_checkpoint_header(const MappedFileReader &file,
+                                                              const BufferParams &buffer_params)
+{
+  if (file.size() < sizeof(RenderCheckpointHeader)) {
+    return nullptr;
+  }
+
+  const RenderCheckpointHeader *header = reinterpret_cast<const RenderCheckpointHeader *>(
+      file.data());
+  if (memcmp(header->magic, RENDER_CHECKPOINT_MAGIC, sizeof(RENDER_CHECKPOINT_MAGIC)) != 0 ||
+      header->version != RENDER_CHECKPOINT_VERSION) {
+    LOG(ERROR) << "File is not a render checkpoint.";
+    return nullptr;
+  }
+
+  if (header->width != buffer_params.width || header->height != buffer_params.height ||
+      header->pass_stride != buffer_params.pass_stride ||
+      header->passes_hash != render_checkpoint_passes_hash(buffer_params)) {
+    LOG(ERROR) << "Render checkpoint does not match the render buffers.";
+    return nullptr;
+  }
+
+  if (header->data_offset < sizeof(RenderCheckpointHeader) ||
+      header->data_offset + render_checkpoint_data_size(buffer_params) > file.size()) {
+    LOG(ERROR) << "Render checkpoint is truncated.";
+    return nullptr;
+  }
+
+  return header;
+}
+
+bool RenderCheckpoint::write(const string &filepath, const RenderBuffers &buffers) const
+{
+  const BufferParams &buffer_params = buffers.params;
+
+  RenderCheckpointHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, RENDER_CHECKPOINT_MAGIC, sizeof(RENDER_CHECKPOINT_MAGIC));
+  header.version = RENDER_CHECKPOINT_VERSION;
+  header.width = buffer_params.width;
+  header.height = buffer_params.height;
+  header.pass_stride = buffer_params.pass_stride;
+  header.passes_hash = render_checkpoint_passes_hash(buffer_params);
+  header.num_rendered_samples = num_rendered_samples;
+  header.sample_offset = sample_offset;
+  header.num_samples = num_samples;
+  header.adaptive_sampling_threshold = adaptive_sampling_threshold;
+  header.path_trace_time = path_trace_time;
+  header.data_offset = align_up(sizeof(header), RENDER_CHECKPOINT_DATA_ALIGNMENT);
+
+  const uint64_t data_size = render_checkpoint_data_size(buffer_params);
+  const string temp_filepath = filepath + ".tmp";
+
+  PositionalFileWriter file;
+  if (!file.open(temp_filepath, header.data_offset + data_size)) {
+    LOG(ERROR) << "Error creating render checkpoint " << temp_filepath;
+    return false;
+  }
+
+  if (!file.write(&header, sizeof(header), 0) ||
+      !file.write(buffers.buffer.data(), data_size, header.data_offset) || !file.close()) {
+    LOG(ERROR) << "Error writing render checkpoint " << temp_filepath;
+    file.close();
+    path_remove(temp_filepath);
+    return false;
+  }
+
+  if (!path_rename(temp_filepath, filepath)) {
+    LOG(ERROR) << "Error replacing render checkpoint " << filepath;
+    path_remove(temp_filepath);
+    return false;
+  }
+
+  VLOG_WORK << "Written render checkpoint with " << num_rendered_samples << " samples to "
+            << filepath;
+
+  return true;
+}
+
+bool RenderCheckpoint::read_state(const string &filepath, const BufferParams &buffer_params)
+{
+  if (!path_exists(filepath)) {
+    return false;
+  }
+
+  MappedFileReader file;
+  if (!file.open(filepath)) {
+    LOG(ERROR) << "Error opening render checkpoint " << filepath;
+    return false;
+  }
+
+  const RenderCheckpointHeader *header = render_checkpoint_header(file, buffer_params);
+  if (!header) {
+    return false;
+  }
+
+  num_rendered_samples = header->num_rendered_samples;
+  sample_offset = header->sample_offset;
+  num_samples = header->num_samples;
+  adaptive_sampling_threshold = header->adaptive_sampling_threshold;
+  path_trace_time = header->path_trace_time;
+
+  return true;
+}
+
+bool RenderCheckpoint::read_buffers(const string &filepath, RenderBuffers *buffers)
+{
+  MappedFileReader file;
+  if (!file.open(filepath)) {
+    LOG(ERROR) << "Error opening render checkpoint " << filepath;
+    return false;
+  }
+
+  const RenderCheckpointHeader *header = render_checkpoint_header(file, buffers->params);
+  if (!header) {
+    return false;
+  }
+
+  memcpy(buffers->buffer.data(),
+         file.data() + header->data_offset,
+         render_checkpoint_data_size(buffers->params));
+
+  return true;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#pragma once
+
+#include "util/string.h"
+
+CCL_NAMESPACE_BEGIN
+
+class BufferParams;
+class RenderBuffers;
+
+/* Checkpoint of an in-progress offline render.
+ *
+ * Contains render buffers of the big tile together with the render scheduler state, so that an
+ * interrupted render can continue from the last checkpoint instead of starting over. */
+class RenderCheckpoint {
+ public:
+  /* Number of samples accumulated in the render buffers. */
+  int num_rendered_samples = 0;
+
+  /* Sample range of the render. Resuming requires the same range, so that the samples which are
+   * rendered after resume continue the same sequence. */
+  int sample_offset = 0;
+  int num_samples = 0;
+
+  /* Adaptive sampling threshold used by the scheduler at the time of the checkpoint. */
+  float adaptive_sampling_threshold = 0.0f;
+
+  /* Wall time in seconds spent on path tracing before the checkpoint. */
+  double path_trace_time = 0.0;
+
+  /* Write checkpoint with the given render buffers to a file.
+   * The file is written next to the destination and renamed when complete, so an interruption
+   * during the write keeps the previous checkpoint intact. */
+  bool write(const string &filepath, const RenderBuffers &buffers) const;
+
+  /* Read the scheduler state from the checkpoint file.
+   * Returns false if the file does not exist, is not a valid checkpoint, or was written for
+   * render buffers with different dimensions or passes than the given ones. */
+  bool read_state(const string &filepath, const BufferParams &buffer_params);
+
+  /* Read render buffers pixels from the checkpoint file.
+   * The buffers are to be allocated with the same parameters as used for the write. */
+  static bool read_buffers(const string &filepath, RenderBuffers *buffers);
+};
+
+CCL_NAMESPACE_END
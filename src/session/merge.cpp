@@ -5,7 +5,11 @@
 
 #include "util/array.h"
 #include "util/map.h"
+#include "util/math.h"
 #include "util/system.h"
+#include "util/task.h"
+#include "util/tbb.h"
+#include "util/thread.h"
 #include "util/time.h"
 #include "util/unique_ptr.h"
 
@@ -57,8 +61,8 @@ struct MergeImageLayer {
   int samples;
   /* Indicates if this layer has "Debug Sample Count" pass. */
   bool has_sample_pass;
-  /* Offset of the "Debug Sample Count" pass if it exists. */
-  int sample_pass_offset;
+  /* Channel of the "Debug Sample Count" pass in input image if it exists. */
+  int sample_pass_channel;
 };
 
 /* Merge Image */
@@ -219,7 +223,7 @@ static bool parse_channels(const ImageSpec &in_spec,
         });
     if (sample_pass_it != layer.passes.end()) {
       layer.has_sample_pass = true;
-      layer.sample_pass_offset = distance(layer.passes.begin(), sample_pass_it);
+      layer.sample_pass_channel = sample_pass_it->offset;
     }
     else {
       layer.has_sample_pass = false;
@@ -377,89 +381,151 @@ static void merge_channels_metadata(vector<MergeImage> &images, ImageSpec &out_s
   }
 }
 
-static void alloc_pixels(const ImageSpec &spec, array<float> &pixels)
+/* Number of scanlines which are read and merged by a single task. Keeps memory usage of the merge
+ * low, while still reading enough scanlines at once to cover compressed EXR chunks. */
+static const int MERGE_CHUNK_HEIGHT = 32;
+
+/* Merge pixels of a chunk of scanlines of a single image into the output chunk.
+ * The pixel_index is the index of the first pixel of the chunk in the full image. */
+static void merge_chunk_pixels(const MergeImage &image,
+                               const array<float> &pixels,
+                               const size_t pixel_index,
+                               const ImageSpec &out_spec,
+                               const unordered_map<string, SampleCount> &layer_samples,
+                               array<float> &out_pixels)
 {
-  const size_t width = spec.width;
-  const size_t height = spec.height;
-  const size_t num_channels = spec.nchannels;
+  const size_t stride = image.in->spec().nchannels;
+  const size_t out_stride = out_spec.nchannels;
+  const size_t num_pixels = pixels.size();
+
+  for (const MergeImageLayer &layer : image.layers) {
+    for (const MergeImagePass &pass : layer.passes) {
+      size_t offset = pass.offset;
+      size_t out_offset = pass.merge_offset;
+
+      switch (pass.op) {
+        case MERGE_CHANNEL_NOP:
+          break;
+        case MERGE_CHANNEL_COPY:
+          for (; offset < num_pixels; offset += stride, out_offset += out_stride) {
+            out_pixels[out_offset] = pixels[offset];
+          }
+          break;
+        case MERGE_CHANNEL_SUM:
+          for (; offset < num_pixels; offset += stride, out_offset += out_stride) {
+            out_pixels[out_offset] += pixels[offset];
+          }
+          break;
+        case MERGE_CHANNEL_AVERAGE: {
+          /* Weights based on sample count passes and sample metadata. Per channel since not
+           * all files are guaranteed to have the same channels. */
+          size_t sample_pass_offset = layer.sample_pass_channel;
+          const auto &samples = layer_samples.at(layer.name);
+
+          for (size_t i = pixel_index; offset < num_pixels;
+               offset += stride, sample_pass_offset += stride, out_offset += out_stride, i++) {
+            const float total_samples = samples.per_pixel[i];
+
+            float layer_samples;
+            if (layer.has_sample_pass) {
+              layer_samples = pixels[sample_pass_offset] * layer.samples;
+            }
+            else {
+              layer_samples = layer.samples;
+            }
 
-  const size_t num_pixels = width * height;
-  pixels.resize(num_pixels * num_channels);
+            out_pixels[out_offset] += pixels[offset] * (1.0f * layer_samples / total_samples);
+          }
+          break;
+        }
+        case MERGE_CHANNEL_SAMPLES: {
+          const auto &samples = layer_samples.at(layer.name);
+          for (size_t i = pixel_index; offset < num_pixels;
+               offset += stride, out_offset += out_stride, i++) {
+            out_pixels[out_offset] = 1.0f * samples.per_pixel[i] / samples.total;
+          }
+          break;
+        }
+      }
+    }
+  }
 }
 
+/* Merge pixels of all images and write them to the output.
+ *
+ * Images are processed in chunks of scanlines, so that only a few chunks of every image are in
+ * memory at a time. Batches of chunks are merged in parallel, and written to the output in order
+ * once the whole batch is merged. */
 static bool merge_pixels(const vector<MergeImage> &images,
                          const ImageSpec &out_spec,
                          const unordered_map<string, SampleCount> &layer_samples,
-                         array<float> &out_pixels,
+                         ImageOutput *out,
                          string &error)
 {
-  alloc_pixels(out_spec, out_pixels);
-  memset(out_pixels.data(), 0, out_pixels.size() * sizeof(float));
+  const size_t width = out_spec.width;
+  const int height = out_spec.height;
+  const size_t out_stride = out_spec.nchannels;
 
-  for (const MergeImage &image : images) {
-    /* Read all channels into buffer. Reading all channels at once is
-     * faster than individually due to interleaved EXR channel storage. */
-    array<float> pixels;
-    alloc_pixels(image.in->spec(), pixels);
-    const int num_channels = image.in->spec().nchannels;
-    if (!image.in->read_image(0, 0, 0, num_channels, TypeDesc::FLOAT, pixels.data())) {
-      error = "Failed to read image: " + image.filepath;
+  const int num_chunks = divide_up(height, MERGE_CHUNK_HEIGHT);
+  const int batch_size = max(1, TaskScheduler::max_concurrency());
+
+  vector<array<float>> out_chunks(min(batch_size, num_chunks));
+
+  thread_mutex error_mutex;
+  bool ok = true;
+
+  for (int batch_begin = 0; batch_begin < num_chunks; batch_begin += batch_size) {
+    const int batch_end = min(batch_begin + batch_size, num_chunks);
+
+    parallel_for(batch_begin, batch_end, [&](const int chunk) {
+      const int y_begin = chunk * MERGE_CHUNK_HEIGHT;
+      const int y_end = min(y_begin + MERGE_CHUNK_HEIGHT, height);
+      const size_t num_pixels = width * (y_end - y_begin);
+
+      array<float> &out_pixels = out_chunks[chunk - batch_begin];
+      out_pixels.resize(num_pixels * out_stride);
+      memset(out_pixels.data(), 0, out_pixels.size() * sizeof(float));
+
+      array<float> pixels;
+      for (const MergeImage &image : images) {
+        /* Read all channels into buffer. Reading all channels at once is
+         * faster than individually due to interleaved EXR channel storage. */
+        const ImageSpec &spec = image.in->spec();
+        pixels.resize(num_pixels * spec.nchannels);
+        if (!image.in->read_scanlines(0,
+                                      0,
+                                      spec.y + y_begin,
+                                      spec.y + y_end,
+                                      0,
+                                      0,
+                                      spec.nchannels,
+                                      TypeDesc::FLOAT,
+                                      pixels.data())) {
+          thread_scoped_lock lock(error_mutex);
+          error = "Failed to read image: " + image.filepath;
+          ok = false;
+          return;
+        }
+
+        merge_chunk_pixels(image, pixels, width * y_begin, out_spec, layer_samples, out_pixels);
+      }
+    });
+
+    if (!ok) {
       return false;
     }
 
-    for (const MergeImageLayer &layer : image.layers) {
-      const size_t stride = image.in->spec().nchannels;
-      const size_t out_stride = out_spec.nchannels;
-      const size_t num_pixels = pixels.size();
-
-      for (const MergeImagePass &pass : layer.passes) {
-        size_t offset = pass.offset;
-        size_t out_offset = pass.merge_offset;
-
-        switch (pass.op) {
-          case MERGE_CHANNEL_NOP:
-            break;
-          case MERGE_CHANNEL_COPY:
-            for (; offset < num_pixels; offset += stride, out_offset += out_stride) {
-              out_pixels[out_offset] = pixels[offset];
-            }
-            break;
-          case MERGE_CHANNEL_SUM:
-            for (; offset < num_pixels; offset += stride, out_offset += out_stride) {
-              out_pixels[out_offset] += pixels[offset];
-            }
-            break;
-          case MERGE_CHANNEL_AVERAGE: {
-            /* Weights based on sample count passes and sample metadata. Per channel since not
-             * all files are guaranteed to have the same channels. */
-            size_t sample_pass_offset = layer.sample_pass_offset;
-            const auto &samples = layer_samples.at(layer.name);
-
-            for (size_t i = 0; offset < num_pixels;
-                 offset += stride, sample_pass_offset += stride, out_offset += out_stride, i++) {
-              const float total_samples = samples.per_pixel[i];
-
-              float layer_samples;
-              if (layer.has_sample_pass) {
-                layer_samples = pixels[sample_pass_offset] * layer.samples;
-              }
-              else {
-                layer_samples = layer.samples;
-              }
-
-              out_pixels[out_offset] += pixels[offset] * (1.0f * layer_samples / total_samples);
-            }
-            break;
-          }
-          case MERGE_CHANNEL_SAMPLES: {
-            const auto &samples = layer_samples.at(layer.name);
-            for (size_t i = 0; offset < num_pixels;
-                 offset += stride, out_offset += out_stride, i++) {
-              out_pixels[out_offset] = 1.0f * samples.per_pixel[i] / samples.total;
-            }
-            break;
-          }
-        }
+    for (int chunk = batch_begin; chunk < batch_end; chunk++) {
+      const int y_begin = chunk * MERGE_CHUNK_HEIGHT;
+      const int y_end = min(y_begin + MERGE_CHUNK_HEIGHT, height);
+
+      if (!out->write_scanlines(out_spec.y + y_begin,
+                                out_spec.y + y_end,
+                                0,
+                                TypeDesc::FLOAT,
+                                out_chunks[chunk - batch_begin].data())) {
+        error = "Failed to write merged pixels: " + out->geterror();
+        return false;
       }
     }
   }
@@ -468,8 +534,9 @@ static bool merge_pixels(const vector<MergeImage> &images,
 }
 
 static bool save_output(const string &filepath,
-                        const ImageSpec &spec,
-                        const array<float> &pixels,
+                        const ImageSpec &merged_spec,
+                        vector<MergeImage> &images,
+                        const unordered_map<string, SampleCount> &layer_samples,
                         string &error)
 {
   /* Write to temporary file path, so we merge images in place and don't
@@ -484,25 +551,34 @@ static bool save_output(const string &filepath,
     return false;
   }
 
-  /* Open temporary file and write image buffers. */
+  /* Merged pixels are written in chunks of scanlines, so write a scanline image even when the
+   * inputs are tiled. */
+  ImageSpec spec = merged_spec;
+  spec.tile_width = 0;
+  spec.tile_height = 0;
+  spec.tile_depth = 0;
+
+  /* Open temporary file and write merged pixels as they are computed. */
   if (!out->open(tmp_filepath, spec)) {
     error = "Failed to open file " + tmp_filepath + " for writing: " + out->geterror();
     return false;
   }
 
-  bool ok = true;
-  if (!out->write_image(TypeDesc::FLOAT, pixels.data())) {
-    error = "Failed to write to file " + tmp_filepath + ": " + out->geterror();
-    ok = false;
-  }
+  bool ok = merge_pixels(images, spec, layer_samples, out.get(), error);
 
   if (!out->close()) {
-    error = "Failed to save to file " + tmp_filepath + ": " + out->geterror();
+    if (ok) {
+      error = "Failed to save to file " + tmp_filepath + ": " + out->geterror();
+    }
     ok = false;
   }
 
   out.reset();
 
+  /* We don't need input anymore at this point, and will possibly
+   * overwrite the same file. */
+  images.clear();
+
   /* Copy temporary file to output filepath. */
   string rename_error;
   if (ok && !OIIO::Filesystem::rename(tmp_filepath, filepath, rename_error)) {
@@ -541,8 +617,8 @@ static void read_layer_samples(vector<MergeImage> &images,
 
         image.in->read_image(0,
                              0,
-                             layer.sample_pass_offset,
-                             layer.sample_pass_offset,
+                             layer.sample_pass_channel,
+                             layer.sample_pass_channel + 1,
                              TypeDesc::FLOAT,
                              (void *)sample_count_buffer.data());
 
@@ -592,18 +668,8 @@ bool ImageMerger::run()
   ImageSpec out_spec;
   merge_channels_metadata(images, out_spec);
 
-  /* Merge pixels. */
-  array<float> out_pixels;
-  if (!merge_pixels(images, out_spec, layer_samples, out_pixels, error)) {
-    return false;
-  }
-
-  /* We don't need input anymore at this point, and will possibly
-   * overwrite the same file. */
-  images.clear();
-
-  /* Save output file. */
-  return save_output(output, out_spec, out_pixels, error);
+  /* Merge pixels and save output file. */
+  return save_output(output, out_spec, images, layer_samples, error);
 }
 
 CCL_NAMESPACE_END
@@ -18,6 +18,7 @@
 #include "scene/scene.h"
 #include "scene/shader_graph.h"
 #include "session/buffers.h"
+#include "session/checkpoint.h"
 #include "session/display_driver.h"
 #include "session/output_driver.h"
 #include "session/session.h"
@@ -26,6 +27,7 @@
 #include "util/function.h"
 #include "util/log.h"
 #include "util/math.h"
+#include "util/path.h"
 #include "util/task.h"
 #include "util/time.h"
 
@@ -153,6 +155,9 @@ void Session::run_main_render_loop()
     RenderWork render_work = run_update_for_next_iteration();
 
     if (!render_work) {
+      /* Include the pipelined denoising of the last result in the timing. */
+      path_trace_->finish_denoise_pipeline();
+
       if (VLOG_INFO_IS_ON) {
         double total_time, render_time;
         progress.get_time(total_time, render_time);
@@ -161,6 +166,11 @@ void Session::run_main_render_loop()
       }
 
       if (params.background) {
+        /* The render is complete, the checkpoint is not needed anymore. */
+        if (use_checkpoint_ && path_exists(params.checkpoint_filepath)) {
+          path_remove(params.checkpoint_filepath);
+        }
+
         /* if no work left and in background mode, we can stop immediately. */
         progress.set_status("Finished");
         break;
@@ -313,9 +323,13 @@ RenderWork Session::run_update_for_next_iteration()
    * Ideally this would need to happen once in `Session::set_samples()`, but the issue there is
    * the initial configuration when Session is created where the `set_samples()` is not used.
    *
+   * The sample offset is included, so that renders of a subset of the samples use the same
+   * sampling pattern as the full render and can be merged afterwards.
+   *
    * NOTE: Unless reset was requested only allow increasing number of samples. */
-  if (did_reset || scene->integrator->get_aa_samples() < params.samples) {
-    scene->integrator->set_aa_samples(params.samples);
+  const int aa_samples = params.sample_offset + params.samples;
+  if (did_reset || scene->integrator->get_aa_samples() < aa_samples) {
+    scene->integrator->set_aa_samples(aa_samples);
   }
 
   /* Update denoiser settings. */
@@ -340,6 +354,7 @@ RenderWork Session::run_update_for_next_iteration()
   render_scheduler_.set_num_samples(params.samples);
   render_scheduler_.set_start_sample(params.sample_offset);
   render_scheduler_.set_time_limit(params.time_limit);
+  render_scheduler_.set_noise_target(params.noise_target);
 
   while (have_tiles) {
     render_work = render_scheduler_.get_render_work();
@@ -534,6 +549,8 @@ void Session::do_delayed_reset()
    * temporary
    * directory in the host software and switch to a new temp directory when new render starts. */
   tile_manager_.set_temp_dir(params.temp_dir);
+  tile_manager_.set_temp_compression(params.temp_compression);
+  tile_manager_.set_temp_format(params.temp_format);
 
   /* Progress. */
   progress.reset_sample();
@@ -546,6 +563,53 @@ void Session::do_delayed_reset()
   const double time_limit = params.time_limit * ((double)tile_manager_.get_num_tiles());
   progress.set_render_start_time();
   progress.set_time_limit(time_limit);
+
+  update_checkpoint();
+
+  path_trace_->set_denoise_pipeline(params.background && params.use_denoise_pipeline,
+                                    params.denoise_threads);
+}
+
+void Session::update_checkpoint()
+{
+  use_checkpoint_ = false;
+
+  if (params.background && !params.checkpoint_filepath.empty()) {
+    if (tile_manager_.has_multiple_tiles()) {
+      LOG(WARNING) << "Render checkpoints are not supported when rendering with multiple tiles.";
+    }
+    else {
+      use_checkpoint_ = true;
+    }
+  }
+
+  path_trace_->set_checkpoint_filepath(use_checkpoint_ ? params.checkpoint_filepath : "");
+  render_scheduler_.set_checkpoint_interval(use_checkpoint_ ? params.checkpoint_interval : 0.0);
+
+  if (!use_checkpoint_ || !params.checkpoint_resume) {
+    return;
+  }
+
+  RenderCheckpoint checkpoint;
+  if (!checkpoint.read_state(params.checkpoint_filepath, buffer_params_)) {
+    VLOG_INFO << "No render checkpoint to resume from, rendering from the first sample.";
+    return;
+  }
+
+  if (checkpoint.sample_offset != params.sample_offset ||
+      checkpoint.num_rendered_samples > params.samples) {
+    LOG(WARNING) << "Render checkpoint was written with a different sample range, ignoring.";
+    return;
+  }
+
+  VLOG_INFO << "Resuming render from checkpoint with " << checkpoint.num_rendered_samples
+            << " samples.";
+
+  render_scheduler_.resume_from_checkpoint(checkpoint);
+
+  progress.add_samples(static_cast<uint64_t>(buffer_params_.width) * buffer_params_.height *
+                           checkpoint.num_rendered_samples,
+                       checkpoint.num_rendered_samples);
 }
 
 void Session::reset(const SessionParams &session_params, const BufferParams &buffer_params)
@@ -661,6 +725,11 @@ void Session::wait()
   }
 }
 
+void Session::wait_denoise_pipeline()
+{
+  path_trace_->wait_denoise_pipeline();
+}
+
 bool Session::update_scene(int width, int height)
 {
   /* Update camera if dimensions changed for progressive render. the camera
@@ -743,6 +812,11 @@ void Session::collect_statistics(RenderStats *render_stats)
   }
 }
 
+const vector<AdaptiveSamplingConvergence> &Session::get_adaptive_sampling_convergence() const
+{
+  return render_scheduler_.get_adaptive_sampling_convergence();
+}
+
 /* --------------------------------------------------------------------
  * Full-frame on-disk storage.
  */
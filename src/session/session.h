@@ -49,6 +49,11 @@ class SessionParams {
    * Zero means no limit is applied. */
   double time_limit;
 
+  /* Target noise level, using the same metric as the adaptive sampling threshold.
+   * Rendering stops when the target or the time limit is reached, whichever comes first.
+   * Zero means no target is used. */
+  float noise_target;
+
   bool use_profiling;
 
   bool use_auto_tile;
@@ -61,6 +66,30 @@ class SessionParams {
   /* Session-specific temporary directory to store in-progress EXR files in. */
   string temp_dir;
 
+  /* Compression codec of the in-progress EXR files. Only lossless codecs are supported, an empty
+   * string uses the default codec. */
+  string temp_compression;
+
+  /* Format of the in-progress files. */
+  TileFileFormat temp_format;
+
+  /* File to periodically store the progress of an offline render in, allowing to resume the
+   * render after the process has been interrupted. Empty disables checkpoints.
+   * Only supported when rendering with a single tile. */
+  string checkpoint_filepath;
+
+  /* Interval in seconds between checkpoints. */
+  double checkpoint_interval;
+
+  /* Continue rendering from the checkpoint file when it exists and matches the render. */
+  bool checkpoint_resume;
+
+  /* Denoise and write the final result on a separate thread, while the session carries on with
+   * the next render. Only used for background rendering with a single tile and OpenImageDenoise.
+   * The denoiser uses the given number of threads, zero means all available threads. */
+  bool use_denoise_pipeline;
+  int denoise_threads;
+
   SessionParams()
   {
     headless = false;
@@ -72,6 +101,7 @@ class SessionParams {
     pixel_size = 1;
     threads = 0;
     time_limit = 0.0;
+    noise_target = 0.0f;
 
     use_profiling = false;
 
@@ -81,6 +111,14 @@ class SessionParams {
     use_resolution_divider = true;
 
     shadingsystem = SHADINGSYSTEM_SVM;
+
+    temp_format = TILE_FILE_FORMAT_EXR;
+
+    checkpoint_interval = 300.0;
+    checkpoint_resume = false;
+
+    use_denoise_pipeline = false;
+    denoise_threads = 0;
   }
 
   bool modified(const SessionParams &params) const
@@ -126,6 +164,11 @@ class Session {
   void draw();
   void wait();
 
+  /* Wait until the pipelined denoising and writing of the previous render result is finished.
+   * Is to be used before modifying the output driver, so that the result is written with the
+   * driver configuration it was rendered for. */
+  void wait_denoise_pipeline();
+
   bool ready_to_reset();
   void reset(const SessionParams &session_params, const BufferParams &buffer_params);
 
@@ -147,6 +190,10 @@ class Session {
 
   void collect_statistics(RenderStats *stats);
 
+  /* Convergence of adaptive sampling over time for the current render.
+   * Is only to be accessed when the session is not rendering, for example after `wait()`. */
+  const vector<AdaptiveSamplingConvergence> &get_adaptive_sampling_convergence() const;
+
   /* --------------------------------------------------------------------
    * Full-frame on-disk storage.
    */
@@ -199,6 +246,10 @@ class Session {
 
   void do_delayed_reset();
 
+  /* Configure render checkpoints for the current render, and resume from the checkpoint file if
+   * requested. */
+  void update_checkpoint();
+
   int2 get_effective_tile_size() const;
 
   /* Session thread that performs rendering tasks decoupled from the thread
@@ -227,6 +278,9 @@ class Session {
   /* Render scheduler is used to get work to be rendered with the current big tile. */
   RenderScheduler render_scheduler_;
 
+  /* Render checkpoints are written for the current render. */
+  bool use_checkpoint_ = false;
+
   /* Path tracer object.
    *
    * Is a single full-frame path tracer for interactive viewport rendering.
@@ -18,6 +18,7 @@
 #include "util/path.h"
 #include "util/string.h"
 #include "util/system.h"
+#include "util/tbb.h"
 #include "util/time.h"
 #include "util/types.h"
 
@@ -42,6 +43,8 @@ static std::atomic<uint64_t> g_instance_index = 0;
 static std::vector<std::string> exr_channel_names_for_passes(const BufferParams &buffer_params)
 {
   static const char *component_suffixes[] = {"R", "G", "B", "A"};
+  /* Passes stored in half float pack two components into every channel. */
+  static const char *half_component_suffixes[] = {"RG", "BA"};
 
   int pass_index = 0;
   std::vector<std::string> channel_names;
@@ -60,8 +63,15 @@ static std::vector<std::string> exr_channel_names_for_passes(const BufferParams
 
     const string channel_name_prefix = prefix + string(pass.name) + ".";
 
-    for (int i = 0; i < pass_info.num_components; ++i) {
-      channel_names.push_back(channel_name_prefix + component_suffixes[i]);
+    if (pass.use_half_storage) {
+      for (int i = 0; i < pass.get_storage_size(); ++i) {
+        channel_names.push_back(channel_name_prefix + half_component_suffixes[i]);
+      }
+    }
+    else {
+      for (int i = 0; i < pass_info.num_components; ++i) {
+        channel_names.push_back(channel_name_prefix + component_suffixes[i]);
+      }
     }
 
     ++pass_index;
@@ -302,6 +312,190 @@ static bool configure_image_spec_from_buffer(ImageSpec *image_spec,
   return true;
 }
 
+/* --------------------------------------------------------------------
+ * Raw tile file.
+ *
+ * The file starts with a fixed header, followed by the image specification attributes which
+ * carry the buffer parameters, passes and denoising parameters in the same way as the metadata of
+ * the EXR file. The pixels follow at a page-aligned offset and are stored exactly as they are in
+ * the full-frame render buffer, so reading the file back involves no decoding.
+ */
+
+static const char RAW_TILE_FILE_MAGIC[8] = {'C', 'Y', 'C', 'L', 'T', 'I', 'L', 'E'};
+static const uint32_t RAW_TILE_FILE_VERSION = 1;
+static const uint64_t RAW_TILE_FILE_DATA_ALIGNMENT = 4096;
+
+struct RawTileFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t pass_stride;
+  int32_t width;
+  int32_t height;
+  uint64_t metadata_size;
+  uint64_t data_offset;
+};
+
+enum RawTileFileAttributeType : uint8_t {
+  RAW_TILE_FILE_ATTRIBUTE_INT = 0,
+  RAW_TILE_FILE_ATTRIBUTE_FLOAT = 1,
+  RAW_TILE_FILE_ATTRIBUTE_STRING = 2,
+};
+
+static void raw_tile_file_append(vector<uint8_t> &metadata, const void *data, const size_t size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  metadata.insert(metadata.end(), bytes, bytes + size);
+}
+
+static void raw_tile_file_append_string(vector<uint8_t> &metadata, const string &str)
+{
+  const uint32_t size = str.size();
+  raw_tile_file_append(metadata, &size, sizeof(size));
+  raw_tile_file_append(metadata, str.data(), size);
+}
+
+/* Serialize attributes of the image specification. Only the attribute types used for the node
+ * sockets are supported. */
+static vector<uint8_t> raw_tile_file_metadata_from_image_spec(const ImageSpec &image_spec)
+{
+  vector<uint8_t> metadata;
+
+  for (const ParamValue &attrib : image_spec.extra_attribs) {
+    RawTileFileAttributeType type;
+    if (attrib.type() == TypeInt) {
+      type = RAW_TILE_FILE_ATTRIBUTE_INT;
+    }
+    else if (attrib.type() == TypeFloat) {
+      type = RAW_TILE_FILE_ATTRIBUTE_FLOAT;
+    }
+    else if (attrib.type() == TypeString) {
+      type = RAW_TILE_FILE_ATTRIBUTE_STRING;
+    }
+    else {
+      continue;
+    }
+
+    raw_tile_file_append(metadata, &type, sizeof(type));
+    raw_tile_file_append_string(metadata, attrib.name().string());
+
+    switch (type) {
+      case RAW_TILE_FILE_ATTRIBUTE_INT: {
+        const int32_t value = attrib.get_int();
+        raw_tile_file_append(metadata, &value, sizeof(value));
+        break;
+      }
+      case RAW_TILE_FILE_ATTRIBUTE_FLOAT: {
+        const float value = attrib.get_float();
+        raw_tile_file_append(metadata, &value, sizeof(value));
+        break;
+      }
+      case RAW_TILE_FILE_ATTRIBUTE_STRING:
+        raw_tile_file_append_string(metadata, attrib.get_string());
+        break;
+    }
+  }
+
+  return metadata;
+}
+
+static bool raw_tile_file_read(const uint8_t *&data,
+                               const uint8_t *data_end,
+                               void *value,
+                               const size_t size)
+{
+  if (data_end - data < ptrdiff_t(size)) {
+    return false;
+  }
+  memcpy(value, data, size);
+  data += size;
+  return true;
+}
+
+static bool raw_tile_file_read_string(const uint8_t *&data, const uint8_t *data_end, string *str)
+{
+  uint32_t size;
+  if (!raw_tile_file_read(data, data_end, &size, sizeof(size))) {
+    return false;
+  }
+  if (data_end - data < ptrdiff_t(size)) {
+    return false;
+  }
+  str->assign(reinterpret_cast<const char *>(data), size);
+  data += size;
+  return true;
+}
+
+static bool raw_tile_file_metadata_to_image_spec(const uint8_t *data,
+                                                 const size_t size,
+                                                 ImageSpec *image_spec)
+{
+  const uint8_t *data_end = data + size;
+
+  while (data != data_end) {
+    RawTileFileAttributeType type;
+    string name;
+    if (!raw_tile_file_read(data, data_end, &type, sizeof(type)) ||
+        !raw_tile_file_read_string(data, data_end, &name)) {
+      return false;
+    }
+
+    switch (type) {
+      case RAW_TILE_FILE_ATTRIBUTE_INT: {
+        int32_t value;
+        if (!raw_tile_file_read(data, data_end, &value, sizeof(value))) {
+          return false;
+        }
+        image_spec->attribute(name, int(value));
+        break;
+      }
+      case RAW_TILE_FILE_ATTRIBUTE_FLOAT: {
+        float value;
+        if (!raw_tile_file_read(data, data_end, &value, sizeof(value))) {
+          return false;
+        }
+        image_spec->attribute(name, value);
+        break;
+      }
+      case RAW_TILE_FILE_ATTRIBUTE_STRING: {
+        string value;
+        if (!raw_tile_file_read_string(data, data_end, &value)) {
+          return false;
+        }
+        image_spec->attribute(name, value);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/* Get header of the raw tile file, or nullptr if the file is not a valid raw tile file. */
+static const RawTileFileHeader *raw_tile_file_header(const MappedFileReader &file)
+{
+  if (file.size() < sizeof(RawTileFileHeader)) {
+    return nullptr;
+  }
+
+  const RawTileFileHeader *header = reinterpret_cast<const RawTileFileHeader *>(file.data());
+  if (memcmp(header->magic, RAW_TILE_FILE_MAGIC, sizeof(RAW_TILE_FILE_MAGIC)) != 0 ||
+      header->version != RAW_TILE_FILE_VERSION) {
+    return nullptr;
+  }
+
+  const uint64_t data_size = uint64_t(header->width) * header->height * header->pass_stride *
+                             sizeof(float);
+  if (header->data_offset < sizeof(RawTileFileHeader) ||
+      header->metadata_size > header->data_offset - sizeof(RawTileFileHeader) ||
+      header->data_offset + data_size > file.size()) {
+    return nullptr;
+  }
+
+  return header;
+}
+
 /* --------------------------------------------------------------------
  * Tile Manager.
  */
@@ -321,6 +515,7 @@ TileManager::TileManager()
 
 TileManager::~TileManager()
 {
+  wait_tile_writes();
 }
 
 int TileManager::compute_render_tile_size(const int suggested_tile_size) const
@@ -338,6 +533,7 @@ void TileManager::reset_scheduling(const BufferParams &params, int2 tile_size)
 {
   VLOG_WORK << "Using tile size of " << tile_size;
 
+  wait_tile_writes();
   close_tile_output();
 
   tile_size_ = tile_size;
@@ -388,6 +584,28 @@ void TileManager::set_temp_dir(const string &temp_dir)
   temp_dir_ = temp_dir;
 }
 
+void TileManager::set_temp_compression(const string &compression)
+{
+  /* The tile file stores raw render buffers which are to be read back for the full-frame
+   * post-processing, so lossy codecs are not allowed. */
+  static const char *lossless_codecs[] = {"none", "rle", "zips", "zip", "piz"};
+
+  if (!compression.empty() &&
+      std::find(std::begin(lossless_codecs), std::end(lossless_codecs), compression) ==
+          std::end(lossless_codecs)) {
+    LOG(ERROR) << "Unsupported tile file compression " << compression << ", using default.";
+    temp_compression_ = "";
+    return;
+  }
+
+  temp_compression_ = compression;
+}
+
+void TileManager::set_temp_format(const TileFileFormat format)
+{
+  temp_format_ = format;
+}
+
 bool TileManager::done()
 {
   return tile_state_.next_tile_index == tile_state_.num_tiles;
@@ -446,9 +664,37 @@ const int2 TileManager::get_size() const
 
 bool TileManager::open_tile_output()
 {
+  const bool use_raw = (temp_format_ == TILE_FILE_FORMAT_RAW);
+
   write_state_.filename = path_join(temp_dir_,
                                     "cycles-tile-buffer-" + tile_file_unique_part_ + "-" +
-                                        to_string(write_state_.tile_file_index) + ".exr");
+                                        to_string(write_state_.tile_file_index) +
+                                        (use_raw ? ".raw" : ".exr"));
+
+  if (!(use_raw ? open_tile_output_raw() : open_tile_output_exr())) {
+    return false;
+  }
+
+  write_state_.num_tiles_written = 0;
+
+  {
+    thread_scoped_lock lock(write_queue_.mutex);
+    write_queue_.error = false;
+  }
+
+  VLOG_WORK << "Opened tile file " << write_state_.filename;
+
+  return true;
+}
+
+bool TileManager::open_tile_output_exr()
+{
+  if (!temp_compression_.empty()) {
+    write_state_.image_spec.attribute("compression", temp_compression_);
+  }
+  else {
+    write_state_.image_spec.erase_attribute("compression");
+  }
 
   write_state_.tile_out = ImageOutput::create(write_state_.filename);
   if (!write_state_.tile_out) {
@@ -467,21 +713,60 @@ bool TileManager::open_tile_output()
     return false;
   }
 
-  write_state_.num_tiles_written = 0;
+  return true;
+}
 
-  VLOG_WORK << "Opened tile file " << write_state_.filename;
+bool TileManager::open_tile_output_raw()
+{
+  const vector<uint8_t> metadata = raw_tile_file_metadata_from_image_spec(
+      write_state_.image_spec);
+
+  RawTileFileHeader header;
+  memcpy(header.magic, RAW_TILE_FILE_MAGIC, sizeof(RAW_TILE_FILE_MAGIC));
+  header.version = RAW_TILE_FILE_VERSION;
+  header.pass_stride = buffer_params_.pass_stride;
+  header.width = buffer_params_.width;
+  header.height = buffer_params_.height;
+  header.metadata_size = metadata.size();
+  header.data_offset = align_up(sizeof(header) + metadata.size(), RAW_TILE_FILE_DATA_ALIGNMENT);
+
+  const uint64_t data_size = uint64_t(header.width) * header.height * header.pass_stride *
+                             sizeof(float);
+
+  /* The file is created with its final size, so that the tiles which are never written are read
+   * back as zeros. */
+  if (!write_state_.raw_out.open(write_state_.filename, header.data_offset + data_size)) {
+    LOG(ERROR) << "Error creating tile file " << write_state_.filename;
+    return false;
+  }
+
+  if (!write_state_.raw_out.write(&header, sizeof(header), 0) ||
+      !write_state_.raw_out.write(metadata.data(), metadata.size(), sizeof(header))) {
+    LOG(ERROR) << "Error writing header of tile file " << write_state_.filename;
+    write_state_.raw_out.close();
+    return false;
+  }
+
+  write_state_.raw_data_offset = header.data_offset;
+  write_state_.raw_width = header.width;
 
   return true;
 }
 
 bool TileManager::close_tile_output()
 {
-  if (!write_state_.tile_out) {
+  if (!is_tile_output_open()) {
     return true;
   }
 
-  const bool success = write_state_.tile_out->close();
-  write_state_.tile_out = nullptr;
+  bool success;
+  if (write_state_.tile_out) {
+    success = write_state_.tile_out->close();
+    write_state_.tile_out = nullptr;
+  }
+  else {
+    success = write_state_.raw_out.close();
+  }
 
   if (!success) {
     LOG(ERROR) << "Error closing tile file.";
@@ -493,15 +778,31 @@ bool TileManager::close_tile_output()
   return true;
 }
 
+void TileManager::wait_tile_writes()
+{
+  if (write_queue_.pool) {
+    write_queue_.pool->wait();
+  }
+}
+
 bool TileManager::write_tile(const RenderBuffers &tile_buffers)
 {
-  if (!write_state_.tile_out) {
+  {
+    thread_scoped_lock lock(write_queue_.mutex);
+    if (write_queue_.error) {
+      return false;
+    }
+  }
+
+  if (!is_tile_output_open()) {
     if (!open_tile_output()) {
       return false;
     }
   }
 
-  const double time_start = time_dt();
+  if (!write_queue_.pool) {
+    write_queue_.pool = make_unique<DedicatedTaskPool>();
+  }
 
   DCHECK_EQ(tile_buffers.params.pass_stride, buffer_params_.pass_stride);
 
@@ -513,33 +814,114 @@ bool TileManager::write_tile(const RenderBuffers &tile_buffers)
   const int64_t pass_stride = tile_params.pass_stride;
   const int64_t tile_row_stride = tile_params.width * pass_stride;
 
-  vector<float> pixel_storage;
-  const float *pixels = tile_buffers.buffer.data() + tile_params.window_x * pass_stride +
-                        tile_params.window_y * tile_row_stride;
+  const int64_t pixels_continuous_row_stride = pass_stride * tile_params.window_width;
+  const size_t num_floats = pixels_continuous_row_stride * tile_params.window_height;
 
-  /* If there is an overscan used for the tile copy pixels into single continuous block of memory
-   * without any "gaps".
-   * This is a workaround for bug in OIIO (https://github.com/OpenImageIO/oiio/pull/3176).
-   * Our task reference: #93008. */
-  if (tile_params.window_x || tile_params.window_y ||
-      tile_params.window_width != tile_params.width ||
-      tile_params.window_height != tile_params.height) {
-    pixel_storage.resize(pass_stride * tile_params.window_width * tile_params.window_height);
-    float *pixels_continuous = pixel_storage.data();
+  const size_t tile_write_size = num_floats * sizeof(float);
+  const int num_write_buffers = (tile_write_size <= MAX_DOUBLE_BUFFERED_TILE_WRITE_SIZE) ?
+                                    NUM_TILE_WRITE_BUFFERS :
+                                    1;
 
-    const int64_t pixels_row_stride = pass_stride * tile_params.width;
-    const int64_t pixels_continuous_row_stride = pass_stride * tile_params.window_width;
+  /* Wait for a write buffer to become available. */
+  int buffer_index = -1;
+  {
+    thread_scoped_lock lock(write_queue_.mutex);
+
+    /* Release the memory of buffers which are not used for tiles of this size. */
+    for (int i = num_write_buffers; i < NUM_TILE_WRITE_BUFFERS; ++i) {
+      if (!write_queue_.buffer_busy[i]) {
+        vector<float>().swap(write_queue_.buffers[i]);
+      }
+    }
 
+    while (true) {
+      for (int i = 0; i < num_write_buffers; ++i) {
+        if (!write_queue_.buffer_busy[i]) {
+          buffer_index = i;
+          break;
+        }
+      }
+      if (buffer_index != -1) {
+        break;
+      }
+      write_queue_.buffer_freed_cond.wait(lock);
+    }
+    write_queue_.buffer_busy[buffer_index] = true;
+  }
+
+  /* Copy pixels of the tile window into single continuous block of memory without any "gaps",
+   * which is also a workaround for bug in OIIO (https://github.com/OpenImageIO/oiio/pull/3176).
+   * Our task reference: #93008.
+   *
+   * The buffer is only ever grown, so that it is not re-allocated for every tile. */
+  vector<float> &pixel_storage = write_queue_.buffers[buffer_index];
+  if (pixel_storage.size() < num_floats) {
+    pixel_storage.resize(num_floats);
+  }
+
+  const float *pixels = tile_buffers.buffer.data() + tile_params.window_x * pass_stride +
+                        tile_params.window_y * tile_row_stride;
+  float *pixels_continuous = pixel_storage.data();
+
+  if (pixels_continuous_row_stride == tile_row_stride) {
+    memcpy(pixels_continuous, pixels, sizeof(float) * num_floats);
+  }
+  else {
     for (int i = 0; i < tile_params.window_height; ++i) {
       memcpy(pixels_continuous, pixels, sizeof(float) * pixels_continuous_row_stride);
-      pixels += pixels_row_stride;
+      pixels += tile_row_stride;
       pixels_continuous += pixels_continuous_row_stride;
     }
-
-    pixels = pixel_storage.data();
   }
 
-  VLOG_WORK << "Write tile at " << tile_x << ", " << tile_y;
+  ++write_state_.num_tiles_written;
+
+  VLOG_WORK << "Queue tile at " << tile_x << ", " << tile_y << " for write.";
+
+  const int width = tile_params.window_width;
+  const int height = tile_params.window_height;
+
+  write_queue_.pool->push([this, buffer_index, tile_x, tile_y, width, height]() {
+    const bool success = write_tile_pixels(
+        tile_x, tile_y, width, height, write_queue_.buffers[buffer_index].data());
+
+    thread_scoped_lock lock(write_queue_.mutex);
+    if (!success) {
+      write_queue_.error = true;
+    }
+    write_queue_.buffer_busy[buffer_index] = false;
+    write_queue_.buffer_freed_cond.notify_all();
+  });
+
+  return true;
+}
+
+bool TileManager::write_tile_pixels(
+    const int x, const int y, const int width, const int height, const float *pixels)
+{
+  const double time_start = time_dt();
+
+  VLOG_WORK << "Write tile at " << x << ", " << y;
+
+  if (write_state_.raw_out.is_open()) {
+    /* Rows of the tile are stored at their location in the full-frame render buffer. */
+    const int64_t pixel_size = buffer_params_.pass_stride * sizeof(float);
+    const int64_t row_size = pixel_size * width;
+
+    for (int row = 0; row < height; ++row) {
+      const uint64_t offset = write_state_.raw_data_offset +
+                              (int64_t(y + row) * write_state_.raw_width + x) * pixel_size;
+      if (!write_state_.raw_out.write(
+              reinterpret_cast<const uint8_t *>(pixels) + row * row_size, row_size, offset)) {
+        LOG(ERROR) << "Error writing tile to " << write_state_.filename;
+        return false;
+      }
+    }
+
+    VLOG_WORK << "Tile written in " << time_dt() - time_start << " seconds.";
+
+    return true;
+  }
 
   /* The image tile sizes in the OpenEXR file are different from the size of our big tiles. The
    * write_tiles() method expects a contiguous image region that will be split into tiles
@@ -549,43 +931,45 @@ bool TileManager::write_tile(const RenderBuffers &tile_buffers)
    * The only thing we have to ensure is that the tile_x and tile_y are a multiple of the
    * image tile size, which happens in compute_render_tile_size. */
 
-  const int64_t xstride = pass_stride * sizeof(float);
-  const int64_t ystride = xstride * tile_params.window_width;
-  const int64_t zstride = ystride * tile_params.window_height;
-
-  if (!write_state_.tile_out->write_tiles(tile_x,
-                                          tile_x + tile_params.window_width,
-                                          tile_y,
-                                          tile_y + tile_params.window_height,
-                                          0,
-                                          1,
-                                          TypeDesc::FLOAT,
-                                          pixels,
-                                          xstride,
-                                          ystride,
-                                          zstride)) {
+  const int64_t xstride = buffer_params_.pass_stride * sizeof(float);
+  const int64_t ystride = xstride * width;
+  const int64_t zstride = ystride * height;
+
+  if (!write_state_.tile_out->write_tiles(
+          x, x + width, y, y + height, 0, 1, TypeDesc::FLOAT, pixels, xstride, ystride, zstride)) {
     LOG(ERROR) << "Error writing tile " << write_state_.tile_out->geterror();
     return false;
   }
 
-  ++write_state_.num_tiles_written;
-
   VLOG_WORK << "Tile written in " << time_dt() - time_start << " seconds.";
 
   return true;
 }
 
-void TileManager::finish_write_tiles()
+bool TileManager::finish_write_tiles()
 {
-  if (!write_state_.tile_out) {
+  if (!is_tile_output_open()) {
     /* None of the tiles were written hence the file was not created.
      * Avoid creation of fully empty file since it is redundant. */
-    return;
+    return true;
+  }
+
+  wait_tile_writes();
+
+  bool success;
+  {
+    thread_scoped_lock lock(write_queue_.mutex);
+    success = !write_queue_.error;
   }
 
-  /* EXR expects all tiles to present in file. So explicitly write missing tiles as all-zero. */
-  if (write_state_.num_tiles_written < tile_state_.num_tiles) {
-    vector<float> pixel_storage(tile_size_.x * tile_size_.y * buffer_params_.pass_stride);
+  /* EXR expects all tiles to present in file. So explicitly write missing tiles as all-zero.
+   * A single row of zeros is used for the whole tile by using zero stride between rows.
+   * The raw file is already created with zeros in place of the missing tiles. */
+  if (success && write_state_.tile_out &&
+      write_state_.num_tiles_written < tile_state_.num_tiles) {
+    const vector<float> zero_row(tile_size_.x * buffer_params_.pass_stride);
+
+    const int64_t xstride = buffer_params_.pass_stride * sizeof(float);
 
     for (int tile_index = write_state_.num_tiles_written; tile_index < tile_state_.num_tiles;
          ++tile_index) {
@@ -596,18 +980,27 @@ void TileManager::finish_write_tiles()
 
       VLOG_WORK << "Write dummy tile at " << tile_x << ", " << tile_y;
 
-      write_state_.tile_out->write_tiles(tile_x,
-                                         tile_x + tile.window_width,
-                                         tile_y,
-                                         tile_y + tile.window_height,
-                                         0,
-                                         1,
-                                         TypeDesc::FLOAT,
-                                         pixel_storage.data());
+      if (!write_state_.tile_out->write_tiles(tile_x,
+                                              tile_x + tile.window_width,
+                                              tile_y,
+                                              tile_y + tile.window_height,
+                                              0,
+                                              1,
+                                              TypeDesc::FLOAT,
+                                              zero_row.data(),
+                                              xstride,
+                                              0,
+                                              0)) {
+        LOG(ERROR) << "Error writing dummy tile " << write_state_.tile_out->geterror();
+        success = false;
+        break;
+      }
     }
   }
 
-  close_tile_output();
+  if (!close_tile_output()) {
+    success = false;
+  }
 
   if (full_buffer_written_cb) {
     full_buffer_written_cb(write_state_.filename);
@@ -622,12 +1015,22 @@ void TileManager::finish_write_tiles()
   ++write_state_.tile_file_index;
 
   write_state_.filename = "";
+
+  return success;
 }
 
 bool TileManager::read_full_buffer_from_disk(const string_view filename,
                                              RenderBuffers *buffers,
                                              DenoiseParams *denoise_params)
 {
+  MappedFileReader raw_in;
+  if (raw_in.open(string(filename))) {
+    if (const RawTileFileHeader *header = raw_tile_file_header(raw_in)) {
+      return read_full_buffer_from_raw_file(raw_in, *header, buffers, denoise_params);
+    }
+  }
+  raw_in.close();
+
   unique_ptr<ImageInput> in(ImageInput::open(filename));
   if (!in) {
     LOG(ERROR) << "Error opening tile file " << filename;
@@ -660,4 +1063,48 @@ bool TileManager::read_full_buffer_from_disk(const string_view filename,
   return true;
 }
 
+bool TileManager::read_full_buffer_from_raw_file(const MappedFileReader &raw_in,
+                                                 const RawTileFileHeader &header,
+                                                 RenderBuffers *buffers,
+                                                 DenoiseParams *denoise_params)
+{
+  ImageSpec image_spec;
+  if (!raw_tile_file_metadata_to_image_spec(
+          raw_in.data() + sizeof(header), header.metadata_size, &image_spec)) {
+    LOG(ERROR) << "Error reading metadata of the tile file.";
+    return false;
+  }
+
+  BufferParams buffer_params;
+  if (!buffer_params_from_image_spec_atttributes(&buffer_params, image_spec)) {
+    return false;
+  }
+
+  if (buffer_params.width != header.width || buffer_params.height != header.height ||
+      buffer_params.pass_stride != header.pass_stride) {
+    LOG(ERROR) << "Mismatched buffer parameters in the tile file.";
+    return false;
+  }
+
+  buffers->reset(buffer_params);
+
+  if (!node_from_image_spec_atttributes(denoise_params, image_spec, ATTR_DENOISE_SOCKET_PREFIX)) {
+    return false;
+  }
+
+  /* The pixels are stored with the same layout as the render buffer, so they are copied from the
+   * mapped file as-is. Copy in parallel to spread page faults of the mapping over threads. */
+  const uint8_t *src = raw_in.data() + header.data_offset;
+  uint8_t *dst = reinterpret_cast<uint8_t *>(buffers->buffer.data());
+  const size_t data_size = buffers->buffer.size() * sizeof(float);
+  const size_t chunk_size = 16 * 1024 * 1024;
+
+  parallel_for(size_t(0), divide_up(data_size, chunk_size), [&](const size_t chunk) {
+    const size_t offset = chunk * chunk_size;
+    memcpy(dst + offset, src + offset, min(chunk_size, data_size - offset));
+  });
+
+  return true;
+}
+
 CCL_NAMESPACE_END
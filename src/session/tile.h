@@ -5,13 +5,17 @@
 
 #include "session/buffers.h"
 #include "util/image.h"
+#include "util/mapped_file.h"
 #include "util/string.h"
+#include "util/task.h"
+#include "util/thread.h"
 #include "util/unique_ptr.h"
 
 CCL_NAMESPACE_BEGIN
 
 class DenoiseParams;
 class Scene;
+struct RawTileFileHeader;
 
 /* --------------------------------------------------------------------
  * Tile.
@@ -34,6 +38,15 @@ class Tile {
  * Tile Manager.
  */
 
+/* Format of the on-disk file which stores render buffers of tiles. */
+enum TileFileFormat {
+  /* Tiled OpenEXR file with a named channel per pass component. */
+  TILE_FILE_FORMAT_EXR,
+  /* Raw render buffer memory preceded by a small header with the buffer parameters.
+   * Avoids the encoding and decoding costs of the EXR file, at the cost of no compression. */
+  TILE_FILE_FORMAT_RAW,
+};
+
 class TileManager {
  public:
   /* This callback is invoked by whenever on-dist tiles storage file is closed after writing. */
@@ -60,6 +73,14 @@ class TileManager {
 
   void set_temp_dir(const string &temp_dir);
 
+  /* Set compression codec of the on-disk tile file.
+   * Only lossless OpenEXR codecs are accepted ("none", "rle", "zips", "zip", "piz"). An empty
+   * string uses the default codec of OpenImageIO. */
+  void set_temp_compression(const string &compression);
+
+  /* Set format of the on-disk tile file. */
+  void set_temp_format(TileFileFormat format);
+
   inline int get_num_tiles() const
   {
     return tile_state_.num_tiles;
@@ -85,12 +106,18 @@ class TileManager {
    *
    * Opens file for write when first tile is written.
    *
-   * Returns true on success. */
+   * The pixels are copied from the buffer and written to the file by a background thread, so the
+   * buffer can be re-used as soon as this call returns. Blocks while all write buffers are busy.
+   *
+   * Returns false if the file could not be opened or an earlier tile failed to be written. */
   bool write_tile(const RenderBuffers &tile_buffers);
 
   /* Inform the tile manager that no more tiles will be written to disk.
-   * The file will be considered final, all handles to it will be closed. */
-  void finish_write_tiles();
+   * Waits for all pending tile writes, after which the file is considered final and all handles
+   * to it are closed.
+   *
+   * Returns true if all tiles were successfully written. */
+  bool finish_write_tiles();
 
   /* Check whether any tile has been written to disk. */
   inline bool has_written_tiles() const
@@ -99,6 +126,7 @@ class TileManager {
   }
 
   /* Read full frame render buffer from tiles file on disk.
+   * The file format is detected from the file content.
    *
    * Returns true on success. */
   bool read_full_buffer_from_disk(string_view filename,
@@ -117,15 +145,43 @@ class TileManager {
    * Use conservative value which is safe for most of OpenGL drivers and GPUs. */
   static const int MAX_TILE_SIZE = 8192;
 
+  /* Number of tiles which can be queued for writing to disk at the same time.
+   * A single buffer already allows the next tile to be rendered while the previous one is being
+   * compressed. The second buffer also lets the copy of the next tile proceed before that write is
+   * finished, and is only used for tiles up to the given size in bytes, since each buffer holds a
+   * full copy of the tile. */
+  static const int NUM_TILE_WRITE_BUFFERS = 2;
+  static const size_t MAX_DOUBLE_BUFFERED_TILE_WRITE_SIZE = 256 * 1024 * 1024;
+
  protected:
   /* Get tile configuration for its index.
    * The tile index must be within [0, state_.tile_state_). */
   Tile get_tile_for_index(int index) const;
 
   bool open_tile_output();
+  bool open_tile_output_exr();
+  bool open_tile_output_raw();
   bool close_tile_output();
 
+  inline bool is_tile_output_open() const
+  {
+    return write_state_.tile_out || write_state_.raw_out.is_open();
+  }
+
+  bool read_full_buffer_from_raw_file(const MappedFileReader &raw_in,
+                                      const RawTileFileHeader &header,
+                                      RenderBuffers *buffers,
+                                      DenoiseParams *denoise_params);
+
+  /* Wait for all tiles queued for writing to be written to the file. */
+  void wait_tile_writes();
+
+  /* Write contiguous pixels of the given image region to the tile file. */
+  bool write_tile_pixels(int x, int y, int width, int height, const float *pixels);
+
   string temp_dir_;
+  string temp_compression_;
+  TileFileFormat temp_format_ = TILE_FILE_FORMAT_EXR;
 
   /* Part of an on-disk tile file name which avoids conflicts between several Cycles instances or
    * several sessions. */
@@ -172,8 +228,31 @@ class TileManager {
      * the state and is created whenever writing is requested. */
     unique_ptr<ImageOutput> tile_out;
 
+    /* Output of the raw tile file, used instead of the image output when the raw format is
+     * requested. */
+    PositionalFileWriter raw_out;
+
+    /* Layout of the pixels in the raw tile file. */
+    uint64_t raw_data_offset = 0;
+    int raw_width = 0;
+
+    /* Number of tiles handed over for writing, including the ones which are still queued. */
     int num_tiles_written = 0;
   } write_state_;
+
+  /* Tiles queued for writing to the file on disk by the background thread.
+   * Access to the buffers state and error flag is protected by the mutex. */
+  struct {
+    unique_ptr<DedicatedTaskPool> pool;
+
+    thread_mutex mutex;
+    thread_condition_variable buffer_freed_cond;
+
+    vector<float> buffers[NUM_TILE_WRITE_BUFFERS];
+    bool buffer_busy[NUM_TILE_WRITE_BUFFERS] = {false};
+
+    bool error = false;
+  } write_queue_;
 };
 
 CCL_NAMESPACE_END
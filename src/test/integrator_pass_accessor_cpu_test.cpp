@@ -0,0 +1,226 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#include "testing/testing.h"
+
+#include "device/cpu/kernel.h"
+#include "device/device.h"
+
+#include "util/hash.h"
+#include "util/time.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Tests of the film convert kernels which are used by the PassAccessorCPU.
+ *
+ * The kernels convert multiple pixels at once when the row is wide enough, and convert pixels
+ * one by one otherwise. Converting every pixel on its own is used as a reference, which the
+ * vectorized conversion is to match bit-wise. */
+
+/* Layout of the render buffer pixel. */
+static const int PASS_OFFSET_COMBINED = 0;
+static const int PASS_OFFSET_DEPTH = 4;
+static const int PASS_OFFSET_NORMAL = 5;
+static const int PASS_OFFSET_SAMPLE_COUNT = 8;
+static const int PASS_STRIDE = 9;
+
+/* Width which is not a multiple of the vector width, so that the remainder is tested as well. */
+static const int TEST_WIDTH = 1923;
+static const int TEST_HEIGHT = 16;
+
+static vector<float> create_render_buffer(const int width, const int height)
+{
+  vector<float> buffer(size_t(width) * height * PASS_STRIDE);
+
+  for (int i = 0; i < width * height; ++i) {
+    float *pixel = buffer.data() + size_t(i) * PASS_STRIDE;
+    for (int j = 0; j < PASS_OFFSET_SAMPLE_COUNT; ++j) {
+      pixel[j] = (hash_uint2_to_float(i, j) - 0.25f) * 40.0f;
+    }
+
+    /* Pixels which did not hit anything. */
+    if (i % 7 == 0) {
+      pixel[PASS_OFFSET_DEPTH] = 0.0f;
+    }
+
+    /* Pixels without samples, as happens with adaptive sampling. */
+    const uint num_samples = (i % 11 == 0) ? 0 : hash_uint2(i, PASS_STRIDE) % 1024 + 1;
+    pixel[PASS_OFFSET_SAMPLE_COUNT] = __uint_as_float(num_samples);
+  }
+
+  return buffer;
+}
+
+static KernelFilmConvert create_film_convert(const int pass_offset,
+                                             const int num_components,
+                                             const bool use_exposure,
+                                             const bool use_sample_count)
+{
+  KernelFilmConvert kfilm_convert;
+  memset(&kfilm_convert, 0, sizeof(kfilm_convert));
+
+  kfilm_convert.pass_offset = pass_offset;
+  kfilm_convert.pass_stride = PASS_STRIDE;
+
+  kfilm_convert.pass_use_exposure = use_exposure;
+  kfilm_convert.pass_use_filter = true;
+
+  kfilm_convert.pass_divide = PASS_UNUSED;
+  kfilm_convert.pass_indirect = PASS_UNUSED;
+  kfilm_convert.pass_combined = PASS_OFFSET_COMBINED;
+  kfilm_convert.pass_sample_count = use_sample_count ? PASS_OFFSET_SAMPLE_COUNT : PASS_UNUSED;
+  kfilm_convert.pass_adaptive_aux_buffer = PASS_UNUSED;
+  kfilm_convert.pass_motion_weight = PASS_UNUSED;
+  kfilm_convert.pass_shadow_catcher = PASS_UNUSED;
+  kfilm_convert.pass_shadow_catcher_sample_count = PASS_UNUSED;
+  kfilm_convert.pass_shadow_catcher_matte = PASS_UNUSED;
+  kfilm_convert.pass_background = PASS_UNUSED;
+
+  kfilm_convert.scale = 1.0f / 17.0f;
+  kfilm_convert.exposure = use_exposure ? 1.7f : 1.0f;
+  kfilm_convert.scale_exposure = kfilm_convert.scale * kfilm_convert.exposure;
+
+  kfilm_convert.num_components = num_components;
+  kfilm_convert.pixel_stride = num_components;
+
+  return kfilm_convert;
+}
+
+static void test_film_convert(const CPUKernels::FilmConvertFunction &film_convert,
+                              const CPUKernels::FilmConvertHalfRGBAFunction &film_convert_half,
+                              const KernelFilmConvert &kfilm_convert)
+{
+  const vector<float> buffer = create_render_buffer(TEST_WIDTH, TEST_HEIGHT);
+  const int num_pixels = TEST_WIDTH * TEST_HEIGHT;
+  const int num_components = kfilm_convert.num_components;
+
+  vector<float> pixels(size_t(num_pixels) * num_components, -1.0f);
+  vector<float> pixels_reference(size_t(num_pixels) * num_components, -1.0f);
+  vector<half4> pixels_half(num_pixels);
+  vector<half4> pixels_half_reference(num_pixels);
+
+  for (int y = 0; y < TEST_HEIGHT; ++y) {
+    const int row = y * TEST_WIDTH;
+    film_convert(&kfilm_convert,
+                 buffer.data() + size_t(row) * PASS_STRIDE,
+                 pixels.data() + size_t(row) * num_components,
+                 TEST_WIDTH,
+                 PASS_STRIDE,
+                 num_components);
+    film_convert_half(&kfilm_convert,
+                      buffer.data() + size_t(row) * PASS_STRIDE,
+                      pixels_half.data() + row,
+                      TEST_WIDTH,
+                      PASS_STRIDE);
+  }
+
+  for (int i = 0; i < num_pixels; ++i) {
+    film_convert(&kfilm_convert,
+                 buffer.data() + size_t(i) * PASS_STRIDE,
+                 pixels_reference.data() + size_t(i) * num_components,
+                 1,
+                 PASS_STRIDE,
+                 num_components);
+    film_convert_half(&kfilm_convert,
+                      buffer.data() + size_t(i) * PASS_STRIDE,
+                      pixels_half_reference.data() + i,
+                      1,
+                      PASS_STRIDE);
+  }
+
+  EXPECT_EQ(memcmp(pixels.data(), pixels_reference.data(), sizeof(float) * pixels.size()), 0);
+  EXPECT_EQ(memcmp(pixels_half.data(),
+                   pixels_half_reference.data(),
+                   sizeof(half4) * pixels_half.size()),
+            0);
+}
+
+TEST(PassAccessorCPU, film_convert_combined)
+{
+  const CPUKernels &kernels = Device::get_cpu_kernels();
+  test_film_convert(kernels.film_convert_combined,
+                    kernels.film_convert_half_rgba_combined,
+                    create_film_convert(PASS_OFFSET_COMBINED, 4, true, true));
+  test_film_convert(kernels.film_convert_combined,
+                    kernels.film_convert_half_rgba_combined,
+                    create_film_convert(PASS_OFFSET_COMBINED, 4, true, false));
+}
+
+TEST(PassAccessorCPU, film_convert_depth)
+{
+  const CPUKernels &kernels = Device::get_cpu_kernels();
+  test_film_convert(kernels.film_convert_depth,
+                    kernels.film_convert_half_rgba_depth,
+                    create_film_convert(PASS_OFFSET_DEPTH, 1, false, true));
+}
+
+TEST(PassAccessorCPU, film_convert_float3)
+{
+  const CPUKernels &kernels = Device::get_cpu_kernels();
+
+  /* Normal pass. */
+  test_film_convert(kernels.film_convert_float3,
+                    kernels.film_convert_half_rgba_float3,
+                    create_film_convert(PASS_OFFSET_NORMAL, 3, false, true));
+
+  /* Albedo pass, which has alpha from the combined pass. */
+  test_film_convert(kernels.film_convert_float3,
+                    kernels.film_convert_half_rgba_float3,
+                    create_film_convert(PASS_OFFSET_NORMAL, 4, false, true));
+}
+
+/* Microbenchmark of the conversion of a 4K combined pass, as happens for every display update.
+ * Compares conversion of full rows against conversion of pixels one by one. Disabled by default,
+ * run with --gtest_also_run_disabled_tests, the timings are recorded as test properties. */
+TEST(PassAccessorCPU, DISABLED_film_convert_benchmark)
+{
+  const int width = 3840;
+  const int height = 2160;
+  const int num_iterations = 4;
+
+  const CPUKernels &kernels = Device::get_cpu_kernels();
+  const KernelFilmConvert kfilm_convert = create_film_convert(PASS_OFFSET_COMBINED, 4, true, true);
+
+  /* A single row of the buffer is converted for every row of the image, keeping the memory usage
+   * of the test low while still measuring the conversion itself. */
+  const vector<float> buffer = create_render_buffer(width, 1);
+  vector<float> pixels(size_t(width) * 4);
+  vector<half4> pixels_half(width);
+
+  const double time_start = time_dt();
+  for (int i = 0; i < num_iterations; ++i) {
+    for (int y = 0; y < height; ++y) {
+      kernels.film_convert_combined(
+          &kfilm_convert, buffer.data(), pixels.data(), width, PASS_STRIDE, 4);
+      kernels.film_convert_half_rgba_combined(
+          &kfilm_convert, buffer.data(), pixels_half.data(), width, PASS_STRIDE);
+    }
+  }
+  const double time_rows = (time_dt() - time_start) / num_iterations;
+
+  const double time_start_pixels = time_dt();
+  for (int i = 0; i < num_iterations; ++i) {
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        kernels.film_convert_combined(&kfilm_convert,
+                                      buffer.data() + size_t(x) * PASS_STRIDE,
+                                      pixels.data() + size_t(x) * 4,
+                                      1,
+                                      PASS_STRIDE,
+                                      4);
+        kernels.film_convert_half_rgba_combined(&kfilm_convert,
+                                                buffer.data() + size_t(x) * PASS_STRIDE,
+                                                pixels_half.data() + x,
+                                                1,
+                                                PASS_STRIDE);
+      }
+    }
+  }
+  const double time_pixels = (time_dt() - time_start_pixels) / num_iterations;
+
+  RecordProperty("time_rows_us", int(time_rows * 1e6));
+  RecordProperty("time_pixels_us", int(time_pixels * 1e6));
+}
+
+CCL_NAMESPACE_END
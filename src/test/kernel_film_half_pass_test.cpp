@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#include "testing/testing.h"
+
+#include "kernel/device/cpu/compat.h"
+#include "kernel/device/cpu/globals.h"
+
+#include "kernel/integrator/state.h"
+
+#include "kernel/film/write.h"
+
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Tests of auxiliary passes stored as half float, which hold the mean over the samples of the
+ * pixel. */
+
+/* Layout of the render buffer pixel. */
+static const int PASS_OFFSET_NORMAL = 0;
+static const int PASS_OFFSET_DENOISING_ALBEDO = 2;
+static const int PASS_STRIDE = 4;
+
+static void init_kernel_globals(KernelGlobalsCPU &kg, KernelHalfPassesBlock &block)
+{
+  kg.data.film.use_half_passes = true;
+  kg.data.film.pass_normal = PASS_OFFSET_NORMAL;
+  kg.data.film.pass_denoising_normal = PASS_UNUSED;
+  kg.data.film.pass_denoising_albedo = PASS_OFFSET_DENOISING_ALBEDO;
+
+  film_reset_half_passes_block(&block);
+  kg.half_passes_block = &block;
+}
+
+static float3 read_pass_half3(const float *buffer)
+{
+  const uint xy = __float_as_uint(buffer[0]);
+  const uint z = __float_as_uint(buffer[1]);
+  return make_float3(half_storage_to_float(xy & 0xffff),
+                     half_storage_to_float(xy >> 16),
+                     half_storage_to_float(z & 0xffff));
+}
+
+TEST(KernelFilmHalfPass, constant_samples)
+{
+  KernelGlobalsCPU kg;
+  KernelHalfPassesBlock block;
+  init_kernel_globals(kg, block);
+
+  vector<float> buffer(PASS_STRIDE, 0.0f);
+
+  /* A running sum in half float stops growing long before this number of samples. Every sample
+   * is its own block, which rounds the mean the most often. */
+  const int num_samples = 4096;
+  const float3 normal = make_float3(0.267f, -0.535f, 0.802f);
+  const float3 albedo = make_float3(0.8f, 0.333f, 0.05f);
+
+  for (int sample = 0; sample < num_samples; ++sample) {
+    film_begin_half_passes_sample(&kg, sample);
+    film_write_aux_pass_float3(&kg, buffer.data(), PASS_OFFSET_NORMAL, normal);
+    film_write_aux_pass_float3(&kg, buffer.data(), PASS_OFFSET_DENOISING_ALBEDO, albedo);
+    film_fold_half_passes_block(&kg, buffer.data());
+  }
+
+  const float3 normal_mean = read_pass_half3(buffer.data() + PASS_OFFSET_NORMAL);
+  const float3 albedo_mean = read_pass_half3(buffer.data() + PASS_OFFSET_DENOISING_ALBEDO);
+
+  /* Within a few units of half float precision. */
+  const float tolerance = 4e-3f;
+  EXPECT_NEAR(normal_mean.x, normal.x, tolerance);
+  EXPECT_NEAR(normal_mean.y, normal.y, tolerance);
+  EXPECT_NEAR(normal_mean.z, normal.z, tolerance);
+  EXPECT_NEAR(albedo_mean.x, albedo.x, tolerance);
+  EXPECT_NEAR(albedo_mean.y, albedo.y, tolerance);
+  EXPECT_NEAR(albedo_mean.z, albedo.z, tolerance);
+}
+
+TEST(KernelFilmHalfPass, varying_samples)
+{
+  KernelGlobalsCPU kg;
+  KernelHalfPassesBlock block;
+  init_kernel_globals(kg, block);
+
+  vector<float> buffer(PASS_STRIDE, 0.0f);
+
+  /* Alternate between two values in the first half of the samples and use another value in the
+   * second half, so that the mean moves late in the render. Skip the contribution of every
+   * fourth sample as a path which does not hit any surface would. Blocks double in size, similar
+   * to how the render scheduler increases the number of samples per render work. */
+  const int num_samples = 4096;
+  double expected = 0.0;
+
+  int sample = 0;
+  for (int block_size = 1; sample < num_samples; block_size *= 2) {
+    const int end_sample = min(sample + block_size, num_samples);
+    for (; sample < end_sample; ++sample) {
+      film_begin_half_passes_sample(&kg, sample);
+      if (sample % 4 == 3) {
+        continue;
+      }
+      const float value = (sample >= num_samples / 2) ? 1.0f : (sample % 2) ? 0.9f : 0.1f;
+      film_write_aux_pass_float3(
+          &kg, buffer.data(), PASS_OFFSET_NORMAL, make_float3(value, value, value));
+      expected += value;
+    }
+    film_fold_half_passes_block(&kg, buffer.data());
+  }
+  expected /= num_samples;
+
+  const float3 mean = read_pass_half3(buffer.data() + PASS_OFFSET_NORMAL);
+  const double tolerance = expected * 0.002;
+  EXPECT_NEAR(mean.x, expected, tolerance);
+  EXPECT_NEAR(mean.y, expected, tolerance);
+  EXPECT_NEAR(mean.z, expected, tolerance);
+}
+
+CCL_NAMESPACE_END
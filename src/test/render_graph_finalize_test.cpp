@@ -14,6 +14,7 @@
 #include "util/log.h"
 #include "util/stats.h"
 #include "util/string.h"
+#include "util/time.h"
 #include "util/vector.h"
 
 using testing::_;
@@ -1523,4 +1524,84 @@ TEST_F(RenderGraph, constant_fold_convert_color_float_color)
   graph.finalize(scene);
 }
 
+/* Build graph similar to procedurally generated materials, with layers of math nodes where each
+ * layer has duplicated nodes, nodes which fold into a no-op and constant inputs. */
+static void build_large_graph(ShaderGraph &graph, const int num_layers)
+{
+  AttributeNode *attribute = graph.create_node<AttributeNode>();
+  attribute->set_attribute(ustring("Attribute"));
+  graph.add(attribute);
+
+  ShaderOutput *layer_output = attribute->output("Fac");
+
+  for (int i = 0; i < num_layers; i++) {
+    const bool is_add = (i % 2) != 0;
+    const float value = is_add ? float(i % 4 - 1) : float(1 + i % 8);
+
+    ValueNode *value_node = NULL;
+    if (i % 4 == 0) {
+      value_node = graph.create_node<ValueNode>();
+      value_node->set_value(value);
+      graph.add(value_node);
+    }
+
+    MathNode *math_nodes[2];
+    for (int j = 0; j < 2; j++) {
+      MathNode *math = graph.create_node<MathNode>();
+      math->set_math_type(is_add ? NODE_MATH_ADD : NODE_MATH_MULTIPLY);
+      math->set_value2(value);
+      graph.add(math);
+
+      graph.connect(layer_output, math->input("Value1"));
+      if (value_node) {
+        graph.connect(value_node->output("Value"), math->input("Value2"));
+      }
+
+      math_nodes[j] = math;
+    }
+
+    MathNode *sum = graph.create_node<MathNode>();
+    sum->set_math_type(NODE_MATH_ADD);
+    graph.add(sum);
+    graph.connect(math_nodes[0]->output("Value"), sum->input("Value1"));
+    graph.connect(math_nodes[1]->output("Value"), sum->input("Value2"));
+
+    layer_output = sum->output("Value");
+  }
+
+  EmissionNode *emission = graph.create_node<EmissionNode>();
+  graph.add(emission);
+  graph.connect(layer_output, emission->input("Strength"));
+  graph.connect(emission->output("Emission"), graph.output()->input("Surface"));
+}
+
+/*
+ * Benchmark of finalizing large graphs.
+ * Disabled by default, run with --gtest_also_run_disabled_tests, the timings are recorded as test
+ * properties.
+ */
+TEST_F(RenderGraph, DISABLED_finalize_large_graph_benchmark)
+{
+  EXPECT_ANY_MESSAGE(log);
+
+  /* Avoid measuring logging of every folded and deduplicated node. */
+  util_logging_verbosity_set(0);
+
+  for (int num_layers = 1000; num_layers <= 8000; num_layers *= 2) {
+    ShaderGraph large_graph;
+    build_large_graph(large_graph, num_layers);
+    const size_t num_nodes = large_graph.nodes.size();
+
+    const double time_start = time_dt();
+    large_graph.finalize(scene);
+    const double time_finalize = time_dt() - time_start;
+
+    /* Duplicated nodes are merged and no-op nodes are removed. */
+    EXPECT_NE(large_graph.output()->input("Surface")->link, (void *)NULL);
+    EXPECT_LT(large_graph.nodes.size(), num_nodes);
+
+    RecordProperty("time_finalize_us_" + to_string(num_layers), int(time_finalize * 1e6));
+  }
+}
+
 CCL_NAMESPACE_END
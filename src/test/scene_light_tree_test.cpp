@@ -0,0 +1,167 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#include "testing/testing.h"
+
+#include "scene/light_tree.h"
+
+#include "util/hash.h"
+#include "util/task.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Create a scattered set of one-sided emissive triangles, large enough for the tree to be
+ * built with multiple tasks and chunked reductions. */
+vector<LightTreePrimitive> make_light_tree_prims(const int num_prims)
+{
+  vector<LightTreePrimitive> prims(num_prims);
+  for (int i = 0; i < num_prims; i++) {
+    LightTreePrimitive &prim = prims[i];
+    prim.prim_id = i;
+    prim.object_id = 0;
+
+    const float3 P = make_float3(hash_uint2_to_float(i, 0),
+                                 hash_uint2_to_float(i, 1),
+                                 hash_uint2_to_float(i, 2)) *
+                     100.0f;
+    const float3 N = safe_normalize(make_float3(hash_uint2_to_float(i, 3) - 0.5f,
+                                                hash_uint2_to_float(i, 4) - 0.5f,
+                                                hash_uint2_to_float(i, 5) - 0.5f));
+
+    prim.energy = 0.1f + hash_uint2_to_float(i, 6);
+    prim.centroid = P;
+    prim.bcone = OrientationBounds(N, 0.0f, M_PI_2_F);
+    prim.bbox = BoundBox(P - make_float3(0.01f), P + make_float3(0.01f));
+  }
+  return prims;
+}
+
+void build_light_tree(const int num_threads,
+                      vector<LightTreePrimitive> &prims,
+                      vector<LightTreeNode> &nodes)
+{
+  TaskScheduler::init(num_threads);
+  LightTree light_tree(prims, 0, 8);
+  nodes = light_tree.get_nodes();
+  TaskScheduler::exit();
+}
+
+bool bbox_contains(const BoundBox &a, const BoundBox &b)
+{
+  return a.min.x <= b.min.x && a.min.y <= b.min.y && a.min.z <= b.min.z && a.max.x >= b.max.x &&
+         a.max.y >= b.max.y && a.max.z >= b.max.z;
+}
+
+}  // namespace
+
+TEST(scene_light_tree, deterministic_across_thread_counts)
+{
+  const int num_prims = 8 * LightTree::THREAD_TASK_SIZE + 123;
+
+  vector<LightTreePrimitive> prims_single = make_light_tree_prims(num_prims);
+  vector<LightTreeNode> nodes_single;
+  build_light_tree(1, prims_single, nodes_single);
+
+  vector<LightTreePrimitive> prims_multi = make_light_tree_prims(num_prims);
+  vector<LightTreeNode> nodes_multi;
+  build_light_tree(0, prims_multi, nodes_multi);
+
+  /* Primitives must end up in the same order. */
+  for (int i = 0; i < num_prims; i++) {
+    ASSERT_EQ(prims_single[i].prim_id, prims_multi[i].prim_id);
+  }
+
+  /* Nodes must be bit-wise identical. */
+  ASSERT_EQ(nodes_single.size(), nodes_multi.size());
+  for (size_t i = 0; i < nodes_single.size(); i++) {
+    const LightTreeNode &a = nodes_single[i];
+    const LightTreeNode &b = nodes_multi[i];
+
+    ASSERT_EQ(a.num_prims, b.num_prims);
+    ASSERT_EQ(a.bit_trail, b.bit_trail);
+    if (a.is_leaf()) {
+      ASSERT_EQ(a.first_prim_index, b.first_prim_index);
+    }
+    else {
+      ASSERT_EQ(a.right_child_index, b.right_child_index);
+    }
+
+    EXPECT_EQ(a.energy, b.energy);
+    EXPECT_EQ(a.bbox.min, b.bbox.min);
+    EXPECT_EQ(a.bbox.max, b.bbox.max);
+    EXPECT_EQ(a.bcone.axis, b.bcone.axis);
+    EXPECT_EQ(a.bcone.theta_o, b.bcone.theta_o);
+    EXPECT_EQ(a.bcone.theta_e, b.bcone.theta_e);
+  }
+}
+
+TEST(scene_light_tree, valid_structure)
+{
+  const int num_prims = 4 * LightTree::THREAD_TASK_SIZE;
+
+  vector<LightTreePrimitive> prims = make_light_tree_prims(num_prims);
+  vector<LightTreeNode> nodes;
+  build_light_tree(0, prims, nodes);
+
+  /* Every primitive is referenced by exactly one leaf, and children come after parents. */
+  vector<int> prim_count(num_prims, 0);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const LightTreeNode &node = nodes[i];
+    if (node.is_leaf()) {
+      for (int j = 0; j < node.num_prims; j++) {
+        prim_count[node.first_prim_index + j]++;
+      }
+    }
+    else {
+      ASSERT_GT(node.right_child_index, int(i) + 1);
+      ASSERT_LT(node.right_child_index, int(nodes.size()));
+    }
+  }
+  for (int i = 0; i < num_prims; i++) {
+    EXPECT_EQ(prim_count[i], 1);
+  }
+}
+
+TEST(scene_light_tree, refit)
+{
+  const int num_prims = 1000;
+
+  vector<LightTreePrimitive> prims = make_light_tree_prims(num_prims);
+  LightTree light_tree(prims, 0, 8);
+
+  /* Move a primitive far away and make it brighter. */
+  LightTreePrimitive &prim = prims[num_prims / 2];
+  const float3 offset = make_float3(1000.0f, -1000.0f, 500.0f);
+  prim.centroid += offset;
+  prim.bbox = BoundBox(prim.bbox.min + offset, prim.bbox.max + offset);
+  prim.energy = 100.0f;
+
+  const vector<int> modified_nodes = light_tree.refit(prims, {num_prims / 2});
+  EXPECT_FALSE(modified_nodes.empty());
+
+  /* Bounds and energy of the interior nodes must match their children again. */
+  const vector<LightTreeNode> &nodes = light_tree.get_nodes();
+  for (size_t i = 1; i < nodes.size(); i++) {
+    const LightTreeNode &node = nodes[i];
+    if (node.is_leaf()) {
+      float energy = 0.0f;
+      for (int j = 0; j < node.num_prims; j++) {
+        const LightTreePrimitive &leaf_prim = prims[node.first_prim_index + j];
+        energy += leaf_prim.energy;
+        EXPECT_TRUE(bbox_contains(node.bbox, leaf_prim.bbox));
+      }
+      EXPECT_NEAR(node.energy, energy, 1e-4f * energy);
+    }
+    else {
+      const LightTreeNode &left = nodes[i + 1];
+      const LightTreeNode &right = nodes[node.right_child_index];
+      EXPECT_TRUE(bbox_contains(node.bbox, left.bbox));
+      EXPECT_TRUE(bbox_contains(node.bbox, right.bbox));
+      EXPECT_NEAR(node.energy, left.energy + right.energy, 1e-4f * node.energy);
+    }
+  }
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#include "testing/testing.h"
+#include "util/hash.h"
+#include "util/system.h"
+#include "util/types.h"
+#include "util/vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+static bool validate_cpu_capabilities()
+{
+
+#if defined(__KERNEL_AVX2__)
+  return system_cpu_support_avx2();
+#elif defined(__KERNEL_SSE2__)
+  return system_cpu_support_sse2();
+#else
+  return false;
+#endif
+}
+
+#define INIT_HASH_TEST \
+  if (!validate_cpu_capabilities()) \
+    return;
+
+/* Number of keys hashed by the array tests, a multiple of the vector width. */
+static const int num_keys = 1024;
+
+/* Keys covering both arbitrary bit patterns and the integer cell coordinates that Voronoi
+ * textures hash, including negative and large ones. */
+static float hash_test_key(const uint i, const uint seed)
+{
+  const uint h = hash_uint2(i, seed);
+  if (i % 2) {
+    return __uint_as_float(h);
+  }
+  return floorf((float)(int)h * ((i % 4) ? 1e-6f : 1.0f));
+}
+
+TEST(TEST_CATEGORY_NAME, uint_to_float_incl)
+{
+  INIT_HASH_TEST
+  for (int i = 0; i < num_keys; i += 4) {
+    const uint n[4] = {
+        hash_uint(i), hash_uint(i + 1), 0xFFFFFFFFu - i, 0x80000000u + i};
+    const float4 f = uint_to_float4_incl(make_int4(n[0], n[1], n[2], n[3]));
+    for (int lane = 0; lane < 4; lane++) {
+      EXPECT_EQ(__float_as_uint(f[lane]), __float_as_uint(uint_to_float_incl(n[lane])));
+    }
+  }
+
+#ifdef __KERNEL_AVX2__
+  for (int i = 0; i < num_keys; i += 8) {
+    uint n[8];
+    for (int lane = 0; lane < 8; lane++) {
+      n[lane] = hash_uint(i + lane);
+    }
+    const vfloat8 f = uint_to_vfloat8_incl(
+        make_vint8(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7]));
+    for (int lane = 0; lane < 8; lane++) {
+      EXPECT_EQ(__float_as_uint(f[lane]), __float_as_uint(uint_to_float_incl(n[lane])));
+    }
+  }
+#endif
+}
+
+TEST(TEST_CATEGORY_NAME, hash_float3_to_float3_array)
+{
+  INIT_HASH_TEST
+  vector<float> kx(num_keys), ky(num_keys), kz(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    kx[i] = hash_test_key(i, 0);
+    ky[i] = hash_test_key(i, 1);
+    kz[i] = hash_test_key(i, 2);
+  }
+
+  vector<float> hx(num_keys), hy(num_keys), hz(num_keys);
+  hash_float3_to_float3_array(
+      kx.data(), ky.data(), kz.data(), hx.data(), hy.data(), hz.data(), num_keys);
+
+  for (int i = 0; i < num_keys; i++) {
+    const float3 h = hash_float3_to_float3(make_float3(kx[i], ky[i], kz[i]));
+    EXPECT_EQ(__float_as_uint(hx[i]), __float_as_uint(h.x));
+    EXPECT_EQ(__float_as_uint(hy[i]), __float_as_uint(h.y));
+    EXPECT_EQ(__float_as_uint(hz[i]), __float_as_uint(h.z));
+  }
+}
+
+TEST(TEST_CATEGORY_NAME, hash_float4_to_float4_array)
+{
+  INIT_HASH_TEST
+  vector<float> kx(num_keys), ky(num_keys), kz(num_keys), kw(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    kx[i] = hash_test_key(i, 0);
+    ky[i] = hash_test_key(i, 1);
+    kz[i] = hash_test_key(i, 2);
+    kw[i] = hash_test_key(i, 3);
+  }
+
+  vector<float> hx(num_keys), hy(num_keys), hz(num_keys), hw(num_keys);
+  hash_float4_to_float4_array(kx.data(),
+                              ky.data(),
+                              kz.data(),
+                              kw.data(),
+                              hx.data(),
+                              hy.data(),
+                              hz.data(),
+                              hw.data(),
+                              num_keys);
+
+  for (int i = 0; i < num_keys; i++) {
+    const float4 h = hash_float4_to_float4(make_float4(kx[i], ky[i], kz[i], kw[i]));
+    EXPECT_EQ(__float_as_uint(hx[i]), __float_as_uint(h.x));
+    EXPECT_EQ(__float_as_uint(hy[i]), __float_as_uint(h.y));
+    EXPECT_EQ(__float_as_uint(hz[i]), __float_as_uint(h.z));
+    EXPECT_EQ(__float_as_uint(hw[i]), __float_as_uint(h.w));
+  }
+}
+
+CCL_NAMESPACE_END
@@ -128,6 +128,37 @@ ccl_device_inline float4 half4_to_float4_image(const half4 h)
   return f;
 }
 
+/* Conversion to/from half float bits for storage of accumulated values.
+ *
+ * Unlike the image texture conversion this rounds to nearest even, and zero round-trips exactly.
+ * Rounding still loses small contributions to a large running sum, so passes stored this way
+ * hold the mean over samples instead, see film_fold_half_passes_block(). Values are clamped to
+ * the largest finite half and denormals are flushed to positive zero. Only integer operations
+ * are used, so the result is identical on all devices. */
+
+ccl_device_inline uint float_to_half_storage(const float f)
+{
+  const uint u = __float_as_uint(f);
+  const uint absolute = u & 0x7fffffff;
+  if (absolute < 0x38800000) {
+    return 0;
+  }
+  const uint sign = (u >> 16) & 0x8000;
+  if (absolute >= 0x477ff000) {
+    return sign | 0x7bff;
+  }
+  const uint rounded = absolute + 0xfff + ((absolute >> 13) & 1);
+  return sign | ((rounded >> 13) - 0x1c000);
+}
+
+ccl_device_inline float half_storage_to_float(const uint h)
+{
+  if ((h & 0x7c00) == 0) {
+    return 0.0f;
+  }
+  return __uint_as_float(((h & 0x8000) << 16) | (((h & 0x7fff) + 0x1c000) << 13));
+}
+
 /* Conversion to half float texture for display.
  *
  * Simplified float to half for fast display texture conversion on processors
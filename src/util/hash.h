@@ -375,6 +375,101 @@ ccl_device_inline vint8 hash_int8_4(vint8 kx, vint8 ky, vint8 kz, vint8 kw)
 #  undef final
 #  undef mix
 
+/* Vectorized uint_to_float_incl() of lanes interpreted as unsigned integers. The upper and lower
+ * 16 bits convert exactly, so their sum is rounded only once like the scalar conversion. */
+
+ccl_device_inline float4 uint_to_float4_incl(const int4 n)
+{
+  const float4 f = make_float4(srl(n, 16)) * 65536.0f + make_float4(n & 0xFFFF);
+  return f * (1.0f / (float)0xFFFFFFFFu);
+}
+
+#  if defined(__KERNEL_AVX2__)
+ccl_device_inline vfloat8 uint_to_vfloat8_incl(const vint8 n)
+{
+  const vfloat8 f = make_vfloat8(srl(n, 16)) * 65536.0f + make_vfloat8(n & 0xFFFF);
+  return f * (1.0f / (float)0xFFFFFFFFu);
+}
+#  endif
+
+/* Hashing arrays of float3 and float4 keys, stored as one array per component. The results are
+ * bit-wise identical to hash_float3_to_float3() and hash_float4_to_float4() of every key. The
+ * arrays must be padded to a multiple of 8 elements, as keys are hashed 8 at a time. */
+
+ccl_device_inline void hash_float3_to_float3_array(ccl_private const float *kx,
+                                                   ccl_private const float *ky,
+                                                   ccl_private const float *kz,
+                                                   ccl_private float *hx,
+                                                   ccl_private float *hy,
+                                                   ccl_private float *hz,
+                                                   const int num)
+{
+#  if defined(__KERNEL_AVX2__)
+  const vint8 one = make_vint8(__float_as_int(1.0f));
+  const vint8 two = make_vint8(__float_as_int(2.0f));
+
+  for (int i = 0; i < num; i += 8) {
+    const vint8 x = cast(make_vfloat8(load_float4(kx + i), load_float4(kx + i + 4)));
+    const vint8 y = cast(make_vfloat8(load_float4(ky + i), load_float4(ky + i + 4)));
+    const vint8 z = cast(make_vfloat8(load_float4(kz + i), load_float4(kz + i + 4)));
+
+    _mm256_storeu_ps(hx + i, uint_to_vfloat8_incl(hash_int8_3(x, y, z)));
+    _mm256_storeu_ps(hy + i, uint_to_vfloat8_incl(hash_int8_4(x, y, z, one)));
+    _mm256_storeu_ps(hz + i, uint_to_vfloat8_incl(hash_int8_4(x, y, z, two)));
+  }
+#  else
+  const int4 one = make_int4(__float_as_int(1.0f));
+  const int4 two = make_int4(__float_as_int(2.0f));
+
+  for (int i = 0; i < num; i += 4) {
+    const int4 x = cast(load_float4(kx + i));
+    const int4 y = cast(load_float4(ky + i));
+    const int4 z = cast(load_float4(kz + i));
+
+    _mm_storeu_ps(hx + i, uint_to_float4_incl(hash_int4_3(x, y, z)));
+    _mm_storeu_ps(hy + i, uint_to_float4_incl(hash_int4_4(x, y, z, one)));
+    _mm_storeu_ps(hz + i, uint_to_float4_incl(hash_int4_4(x, y, z, two)));
+  }
+#  endif
+}
+
+ccl_device_inline void hash_float4_to_float4_array(ccl_private const float *kx,
+                                                   ccl_private const float *ky,
+                                                   ccl_private const float *kz,
+                                                   ccl_private const float *kw,
+                                                   ccl_private float *hx,
+                                                   ccl_private float *hy,
+                                                   ccl_private float *hz,
+                                                   ccl_private float *hw,
+                                                   const int num)
+{
+#  if defined(__KERNEL_AVX2__)
+  for (int i = 0; i < num; i += 8) {
+    const vint8 x = cast(make_vfloat8(load_float4(kx + i), load_float4(kx + i + 4)));
+    const vint8 y = cast(make_vfloat8(load_float4(ky + i), load_float4(ky + i + 4)));
+    const vint8 z = cast(make_vfloat8(load_float4(kz + i), load_float4(kz + i + 4)));
+    const vint8 w = cast(make_vfloat8(load_float4(kw + i), load_float4(kw + i + 4)));
+
+    _mm256_storeu_ps(hx + i, uint_to_vfloat8_incl(hash_int8_4(x, y, z, w)));
+    _mm256_storeu_ps(hy + i, uint_to_vfloat8_incl(hash_int8_4(w, x, y, z)));
+    _mm256_storeu_ps(hz + i, uint_to_vfloat8_incl(hash_int8_4(z, w, x, y)));
+    _mm256_storeu_ps(hw + i, uint_to_vfloat8_incl(hash_int8_4(y, z, w, x)));
+  }
+#  else
+  for (int i = 0; i < num; i += 4) {
+    const int4 x = cast(load_float4(kx + i));
+    const int4 y = cast(load_float4(ky + i));
+    const int4 z = cast(load_float4(kz + i));
+    const int4 w = cast(load_float4(kw + i));
+
+    _mm_storeu_ps(hx + i, uint_to_float4_incl(hash_int4_4(x, y, z, w)));
+    _mm_storeu_ps(hy + i, uint_to_float4_incl(hash_int4_4(w, x, y, z)));
+    _mm_storeu_ps(hz + i, uint_to_float4_incl(hash_int4_4(z, w, x, y)));
+    _mm_storeu_ps(hw + i, uint_to_float4_incl(hash_int4_4(y, z, w, x)));
+  }
+#  endif
+}
+
 #endif
 
 /* ***** Hash Prospector Hash Functions *****
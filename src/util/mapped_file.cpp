@@ -0,0 +1,279 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#include "util/mapped_file.h"
+#include "util/algorithm.h"
+#include "util/windows.h"
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+CCL_NAMESPACE_BEGIN
+
+/* Biggest size of a single write call, which keeps sizes within the range of the platform API. */
+static const size_t MAX_WRITE_CHUNK_SIZE = size_t(1) << 30;
+
+/* --------------------------------------------------------------------
+ * Positional file writer.
+ */
+
+PositionalFileWriter::~PositionalFileWriter()
+{
+  close();
+}
+
+#ifdef _WIN32
+
+bool PositionalFileWriter::open(const string &filepath, const uint64_t size)
+{
+  close();
+
+  const wstring filepath_wc = string_to_wstring(filepath);
+  HANDLE handle = CreateFileW(filepath_wc.c_str(),
+                              GENERIC_WRITE,
+                              0,
+                              nullptr,
+                              CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  file_size.QuadPart = size;
+  if (!SetFilePointerEx(handle, file_size, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) {
+    CloseHandle(handle);
+    return false;
+  }
+
+  handle_ = handle;
+
+  return true;
+}
+
+bool PositionalFileWriter::close()
+{
+  if (!handle_) {
+    return true;
+  }
+
+  const bool success = CloseHandle(static_cast<HANDLE>(handle_));
+  handle_ = nullptr;
+
+  return success;
+}
+
+bool PositionalFileWriter::is_open() const
+{
+  return handle_ != nullptr;
+}
+
+bool PositionalFileWriter::write(const void *data, const size_t size, const uint64_t offset)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+  size_t num_written = 0;
+  while (num_written < size) {
+    const DWORD chunk_size = DWORD(std::min(size - num_written, MAX_WRITE_CHUNK_SIZE));
+    const uint64_t chunk_offset = offset + num_written;
+
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = DWORD(chunk_offset & 0xffffffff);
+    overlapped.OffsetHigh = DWORD(chunk_offset >> 32);
+
+    DWORD chunk_written = 0;
+    if (!WriteFile(static_cast<HANDLE>(handle_),
+                   bytes + num_written,
+                   chunk_size,
+                   &chunk_written,
+                   &overlapped) ||
+        chunk_written == 0) {
+      return false;
+    }
+
+    num_written += chunk_written;
+  }
+
+  return true;
+}
+
+#else /* _WIN32 */
+
+bool PositionalFileWriter::open(const string &filepath, const uint64_t size)
+{
+  close();
+
+  const int fd = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    return false;
+  }
+
+  if (ftruncate(fd, off_t(size)) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  fd_ = fd;
+
+  return true;
+}
+
+bool PositionalFileWriter::close()
+{
+  if (fd_ == -1) {
+    return true;
+  }
+
+  const bool success = (::close(fd_) == 0);
+  fd_ = -1;
+
+  return success;
+}
+
+bool PositionalFileWriter::is_open() const
+{
+  return fd_ != -1;
+}
+
+bool PositionalFileWriter::write(const void *data, const size_t size, const uint64_t offset)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+  size_t num_written = 0;
+  while (num_written < size) {
+    const size_t chunk_size = std::min(size - num_written, MAX_WRITE_CHUNK_SIZE);
+    const ssize_t chunk_written = pwrite(
+        fd_, bytes + num_written, chunk_size, off_t(offset + num_written));
+    if (chunk_written <= 0) {
+      return false;
+    }
+
+    num_written += chunk_written;
+  }
+
+  return true;
+}
+
+#endif /* _WIN32 */
+
+/* --------------------------------------------------------------------
+ * Mapped file reader.
+ */
+
+MappedFileReader::~MappedFileReader()
+{
+  close();
+}
+
+#ifdef _WIN32
+
+bool MappedFileReader::open(const string &filepath)
+{
+  close();
+
+  const wstring filepath_wc = string_to_wstring(filepath);
+  HANDLE file_handle = CreateFileW(filepath_wc.c_str(),
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ,
+                                   nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   nullptr);
+  if (file_handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  file_handle_ = file_handle;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+    close();
+    return false;
+  }
+
+  HANDLE mapping_handle = CreateFileMappingW(
+      file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_handle == nullptr) {
+    close();
+    return false;
+  }
+  mapping_handle_ = mapping_handle;
+
+  data_ = static_cast<const uint8_t *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  if (data_ == nullptr) {
+    close();
+    return false;
+  }
+
+  size_ = size_t(file_size.QuadPart);
+
+  return true;
+}
+
+void MappedFileReader::close()
+{
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_handle_) {
+    CloseHandle(static_cast<HANDLE>(mapping_handle_));
+  }
+  if (file_handle_) {
+    CloseHandle(static_cast<HANDLE>(file_handle_));
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  mapping_handle_ = nullptr;
+  file_handle_ = nullptr;
+}
+
+#else /* _WIN32 */
+
+bool MappedFileReader::open(const string &filepath)
+{
+  close();
+
+  const int fd = ::open(filepath.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void *data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+  /* The mapping stays valid after the file descriptor is closed. */
+  ::close(fd);
+
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t *>(data);
+  size_ = size_t(st.st_size);
+
+  return true;
+}
+
+void MappedFileReader::close()
+{
+  if (data_) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif /* _WIN32 */
+
+CCL_NAMESPACE_END
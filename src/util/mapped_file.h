@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright 2011-2022 Blender Foundation */
+
+#ifndef __UTIL_MAPPED_FILE_H__
+#define __UTIL_MAPPED_FILE_H__
+
+/* Raw binary file access for big files which are written in parts at arbitrary offsets and read
+ * back without any decoding, such as the on-disk render buffer of tiled rendering. */
+
+#include "util/string.h"
+#include "util/types.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* File which is written at explicit offsets.
+ * Regions of the file which were never written read back as zeros. */
+class PositionalFileWriter {
+ public:
+  PositionalFileWriter() = default;
+  ~PositionalFileWriter();
+
+  PositionalFileWriter(const PositionalFileWriter &other) = delete;
+  PositionalFileWriter &operator=(const PositionalFileWriter &other) = delete;
+
+  /* Create file of the given size, replacing existing one. */
+  bool open(const string &filepath, uint64_t size);
+  bool close();
+
+  bool is_open() const;
+
+  /* Write data at the given offset from the beginning of the file.
+   * Safe to be called from multiple threads for non-overlapping regions. */
+  bool write(const void *data, size_t size, uint64_t offset);
+
+ protected:
+#ifdef _WIN32
+  void *handle_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+/* Read-only memory mapping of a whole file. */
+class MappedFileReader {
+ public:
+  MappedFileReader() = default;
+  ~MappedFileReader();
+
+  MappedFileReader(const MappedFileReader &other) = delete;
+  MappedFileReader &operator=(const MappedFileReader &other) = delete;
+
+  bool open(const string &filepath);
+  void close();
+
+  inline const uint8_t *data() const
+  {
+    return data_;
+  }
+
+  inline size_t size() const
+  {
+    return size_;
+  }
+
+ protected:
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+
+#ifdef _WIN32
+  void *file_handle_ = nullptr;
+  void *mapping_handle_ = nullptr;
+#endif
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_MAPPED_FILE_H__ */
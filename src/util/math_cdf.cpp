@@ -6,8 +6,63 @@
 #include "util/algorithm.h"
 #include "util/math.h"
 
+#if !defined(__KERNEL_GPU__) && defined(__KERNEL_SSE2__)
+#  include "util/simd.h"
+#endif
+
 CCL_NAMESPACE_BEGIN
 
+float util_cdf_prefix_sum(const float *values, const int size, const float scale, float *cdf)
+{
+  int i = 0;
+  float sum = 0.0f;
+  cdf[0] = 0.0f;
+
+#ifdef __KERNEL_SSE2__
+  /* Scan four values at a time: two shifted additions give the prefix sum within the vector,
+   * and the running total of the previous vectors is added to it. */
+  const __m128 vscale = _mm_set1_ps(scale);
+  __m128 vsum = _mm_setzero_ps();
+  for (; i + 4 <= size; i += 4) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(values + i), vscale);
+    v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+    v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+    v = _mm_add_ps(v, vsum);
+    _mm_storeu_ps(cdf + i + 1, v);
+    vsum = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  sum = _mm_cvtss_f32(vsum);
+#endif
+
+  for (; i < size; i++) {
+    sum += values[i] * scale;
+    cdf[i + 1] = sum;
+  }
+
+  return sum;
+}
+
+void util_cdf_normalize(float *cdf, const int size, const float total)
+{
+  if (!(total > 0.0f)) {
+    return;
+  }
+
+  const float inv_total = 1.0f / total;
+  int i = 0;
+
+#ifdef __KERNEL_SSE2__
+  const __m128 vinv_total = _mm_set1_ps(inv_total);
+  for (; i + 4 <= size; i += 4) {
+    _mm_storeu_ps(cdf + i, _mm_mul_ps(_mm_loadu_ps(cdf + i), vinv_total));
+  }
+#endif
+
+  for (; i < size; i++) {
+    cdf[i] *= inv_total;
+  }
+}
+
 /* Invert pre-calculated CDF function. */
 void util_cdf_invert(const int resolution,
                      const float from,
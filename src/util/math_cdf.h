@@ -10,6 +10,14 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Compute the non-normalized CDF of `size` values multiplied by `scale`, into `cdf` which must
+ * hold `size + 1` entries: `cdf[0]` is zero and `cdf[i + 1] = cdf[i] + values[i] * scale`.
+ * Returns the total, which is also stored in `cdf[size]`. */
+float util_cdf_prefix_sum(const float *values, const int size, const float scale, float *cdf);
+
+/* Divide the `size` entries of `cdf` by `total`, if it is positive. */
+void util_cdf_normalize(float *cdf, const int size, const float total);
+
 /* Evaluate CDF of a given functor with given range and resolution. */
 template<typename Functor>
 void util_cdf_evaluate(
@@ -17,18 +25,20 @@ void util_cdf_evaluate(
 {
   const int cdf_count = resolution + 1;
   const float range = to - from;
+  vector<float> values(resolution);
   cdf.resize(cdf_count);
-  cdf[0] = 0.0f;
   /* Actual CDF evaluation. */
   for (int i = 0; i < resolution; ++i) {
     float x = from + range * (float)i / (resolution - 1);
-    float y = functor(x);
-    cdf[i + 1] = cdf[i] + fabsf(y);
+    values[i] = fabsf(functor(x));
   }
+  const float total = util_cdf_prefix_sum(values.data(), resolution, 1.0f, cdf.data());
   /* Normalize the CDF. */
-  float fac = (cdf[resolution] == 0.0f) ? 0.0f : 1.0f / cdf[resolution];
-  for (int i = 0; i <= resolution; i++) {
-    cdf[i] *= fac;
+  if (total == 0.0f) {
+    std::fill(cdf.begin(), cdf.end(), 0.0f);
+  }
+  else {
+    util_cdf_normalize(cdf.data(), cdf_count, total);
   }
   cdf[resolution] = 1.0f;
 }
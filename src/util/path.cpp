@@ -729,6 +729,17 @@ bool path_remove(const string &path)
   return remove(path.c_str()) == 0;
 }
 
+bool path_rename(const string &from, const string &to)
+{
+#ifdef _WIN32
+  const wstring from_wc = string_to_wstring(from);
+  const wstring to_wc = string_to_wstring(to);
+  return MoveFileExW(from_wc.c_str(), to_wc.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
 struct SourceReplaceState {
   typedef map<string, string> ProcessedMapping;
   /* Base director for all relative include headers. */
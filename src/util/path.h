@@ -51,6 +51,8 @@ bool path_read_text(const string &path, string &text);
 
 /* File manipulation. */
 bool path_remove(const string &path);
+/* Rename file, replacing the destination if it exists. */
+bool path_rename(const string &from, const string &to);
 
 /* source code utility */
 string path_source_replace_includes(const string &source, const string &path);
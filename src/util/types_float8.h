@@ -50,6 +50,7 @@ ccl_device_inline vfloat8 make_vfloat8(float f);
 ccl_device_inline vfloat8
 make_vfloat8(float a, float b, float c, float d, float e, float f, float g, float h);
 ccl_device_inline vfloat8 make_vfloat8(const float4 a, const float4 b);
+ccl_device_inline vfloat8 make_vfloat8(const vint8 i);
 
 ccl_device_inline void print_vfloat8(ccl_private const char *label, const vfloat8 a);
 
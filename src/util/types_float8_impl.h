@@ -86,6 +86,22 @@ ccl_device_inline vfloat8 make_vfloat8(const float4 a, const float4 b)
 #endif
 }
 
+ccl_device_inline vfloat8 make_vfloat8(const vint8 i)
+{
+#ifdef __KERNEL_AVX__
+  return vfloat8(_mm256_cvtepi32_ps(i.m256));
+#else
+  return make_vfloat8((float)i.a,
+                      (float)i.b,
+                      (float)i.c,
+                      (float)i.d,
+                      (float)i.e,
+                      (float)i.f,
+                      (float)i.g,
+                      (float)i.h);
+#endif
+}
+
 ccl_device_inline void print_vfloat8(ccl_private const char *label, const vfloat8 a)
 {
 #ifdef __KERNEL_PRINTF__